@@ -50,5 +50,6 @@ void OnDrawHUD() {
 }
 
 void OnEnd() {
+  DestroyPlayer(&player);
 }
 
@@ -11,10 +11,12 @@
 
  This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
 \******************************************************************/
+#include "model_palette.h"
 #include "skeleton.h"
 #include "boilerplate_main.h"
 #include "extra-utils.h"
 #include "player_anim.h"
+#include "pose_arena.h"
 
 #include <raylib.h>
 #include <raymath.h>
@@ -57,6 +59,9 @@ typedef struct Player {
   Model model;
   Pose pose;
 
+  /* Skinning palette shared by all meshes of model */
+  ModelPalette palette;
+
   Vector3 position;
   Vector3 velocity;
 
@@ -66,6 +71,8 @@ typedef struct Player {
   /* Bone masks for split body animation */
   BoneMask lowerBodyMask;
   BoneMask upperBodyMask;
+  CompiledBoneMask lowerBodyBones; // Compiled `lowerBodyMask` (only leg bones are blended)
+  CompiledBoneMask upperBodyBones; // Compiled `upperBodyMask`
 
   /* Walking + Running animations */
   ModelAnimation *motionAnims;
@@ -105,6 +112,9 @@ typedef struct Player {
 
   /* Stores blend between walking and running animations */
   float walkToRunBlend;
+
+  /* Temporary poses of a frame are taken from here. Reset at start of each update */
+  PoseArena *arena;
 } Player;
 
 Player CreatePlayer() {
@@ -112,6 +122,11 @@ Player CreatePlayer() {
 
   player.model = LoadModel(PLAYER_MODEL_FILE_NAME);
   player.pose = CopyPose(player.model.bindPose, player.model.boneCount);
+  player.palette = LoadModelPalette(player.model, 0);
+
+  // Enough for all temporary poses of a frame (see `arena->highWaterMark`)
+  player.arena = new_(PoseArena);
+  *player.arena = LoadPoseArenaForPoses(player.model.boneCount, 16);
 
   for (int i = 0; i < player.model.materialCount; i++) {
     player.model.materials[i].shader = skinningShader;
@@ -128,6 +143,9 @@ Player CreatePlayer() {
   player.upperBodyMask = CopyBoneMask(player.lowerBodyMask, player.model.boneCount);
   BoneMaskInvert(player.upperBodyMask, player.model.boneCount);
 
+  player.lowerBodyBones = LoadCompiledBoneMask(player.lowerBodyMask, player.model.boneCount);
+  player.upperBodyBones = LoadCompiledBoneMask(player.upperBodyMask, player.model.boneCount);
+
   player.motionAnims = LoadModelAnimations("resources/models/bot.glb", &player.motionAnimCount);
   ModelAnimationToLocalPose(player.motionAnims, player.motionAnimCount);
 
@@ -159,6 +177,7 @@ Player CreatePlayer() {
     .invert_LR_on_D = true,
     .superimposedDisc = NULL,
     .frame = 0,
+    .arena = player.arena,
   };
 
   player.walkDisc = (AnimModelDisc) {
@@ -171,6 +190,7 @@ Player CreatePlayer() {
     .invert_LR_on_D = true,
     .superimposedDisc = playerRunDisc,
     .frame = 0,
+    .arena = player.arena,
   };
 
   return player;
@@ -200,7 +220,11 @@ void UpdatePlayer(Player *player, Camera *camera) {
   animToVelScale = animToVelScale + player->walkToRunBlend * 0.04f; // Increase scale bcs runnig is faster than walking
 
   // ANIMATION PROCESSING //
-  Pose playerNewPose defer(UnloadPosePtr); // Temporary pose to processed and updated at each step and applied in end.
+  // All poses below are temporary and live in arena till next update
+  ResetPoseArena(player->arena);
+  int boneCount = player->model.boneCount;
+
+  Pose playerNewPose = NULL; // Temporary pose to processed and updated at each step and applied in end.
 
   // WALKING+RUNNIG OR JUMPING := state machine //
   if (player->state == STATE_WALKING) {
@@ -214,7 +238,7 @@ void UpdatePlayer(Player *player, Camera *camera) {
       player->state = STATE_IN_JUMP;
     }
   } else if (player->state == STATE_IN_JUMP) {
-    playerNewPose = CopyPose(GetAnimPose(player->fallingAnims[0], 0), player->model.boneCount);
+    playerNewPose = PoseArenaCopyPose(player->arena, GetAnimPose(player->fallingAnims[0], 0), boneCount);
     
     // Process transitions
     if (player->velocity.y < 0 && player->position.y < 1.0f) { // to walking 
@@ -251,26 +275,19 @@ void UpdatePlayer(Player *player, Camera *camera) {
     player->aimDir.y = Clamp(player->aimDir.y, -0.8f, 0.8f);
 
     // Process aim pose //
+    Pose aimPose = PoseArenaInitPose(player->arena, boneCount);
     // Pick aimIdle(aiming to front) and add additiveAimLeft pose (scaled by player->aimDir.x) on top of it to make player aim left or right as per input
-    Pose afterAimLR defer(UnloadPosePtr) = PoseAdditiveBlend(player->aimIdle, player->additiveAimLeft, player->model.boneCount, 1.0f, player->aimDir.x, NULL);
+    PoseAdditiveBlendInto(aimPose, player->aimIdle, player->additiveAimLeft, boneCount, 1.0f, player->aimDir.x, NULL);
     // Now add aim up down pose to previous pose
-    Pose afterAimUD defer(UnloadPosePtr) = PoseAdditiveBlend(afterAimLR, player->additiveAimUp, player->model.boneCount, 1.0f, player->aimDir.y, NULL);
+    PoseAdditiveBlendInto(aimPose, aimPose, player->additiveAimUp, boneCount, 1.0f, player->aimDir.y, NULL);
     // New apply previous pose to only upper half of body
-    Pose afterLower defer(UnloadPosePtr) = PoseOverrideBlend(afterAimUD, playerNewPose, player->model.boneCount, 1.0, player->lowerBodyMask);
-
-    // apply afterLower
-    UnloadPose(playerNewPose);
-    playerNewPose = CopyPose(afterLower, player->model.boneCount);
+    PoseOverrideBlendCompiledInto(playerNewPose, aimPose, playerNewPose, boneCount, 1.0f, &player->lowerBodyBones, 0);
   } else if (player->armingState != PLAYER_DISARMED) { // Either arming or disarming
     // Update frame number
     player->armingFrame += (player->armingState == PLAYER_ARMING)? 1:-1;
 
     // Apply pose to upper half
-    Pose armingPose = PoseOverrideBlend(playerNewPose, GetAnimPose(player->drawRifleAnims[0], player->armingFrame), player->model.boneCount, 1.0f, player->upperBodyMask);
-
-    // Update pose
-    UnloadPose(playerNewPose);
-    playerNewPose = armingPose;
+    PoseOverrideBlendCompiledInto(playerNewPose, playerNewPose, GetAnimPose(player->drawRifleAnims[0], player->armingFrame), boneCount, 1.0f, &player->upperBodyBones, 0);
 
     // Process transitions //
     if (player->armingFrame == 0 || player->armingFrame == player->drawRifleAnims[0].frameCount - 1) {
@@ -281,14 +298,14 @@ void UpdatePlayer(Player *player, Camera *camera) {
 
   // Update Pose //
   // Convert player's current pose to local pose
-  Pose playerLocalPose defer(UnloadPosePtr) = PoseToLocalTransformPose(player->pose, player->model.bones, player->model.boneCount);
+  Pose laggedPose = PoseArenaInitPose(player->arena, boneCount);
+  PoseToLocalTransformPoseInto(laggedPose, player->pose, player->model.bones, boneCount);
   // Lerp current pose to new pose by lag factor.
-  Pose laggedPose defer(UnloadPosePtr) = PoseLerp(playerLocalPose, playerNewPose, player->model.boneCount, player->walkDisc.lagFactor);
+  PoseLerpInto(laggedPose, laggedPose, playerNewPose, boneCount, player->walkDisc.lagFactor);
 
   // Apply pose
-  UnloadPose(player->pose);
-  player->pose = PoseToGlobalTransformPose(laggedPose, player->model.bones, player->model.boneCount);
-  UpdateModelMeshFromPose(player->model, player->pose);
+  PoseToGlobalTransformPoseInto(player->pose, laggedPose, player->model.bones, boneCount);
+  UpdateModelPaletteFromPose(&player->palette, player->pose);
 
   // Update Player Position //
 
@@ -311,3 +328,28 @@ void DrawPlayer(Player player) {
   DrawModel(player.model, player.position, 0.01f, WHITE);
 }
 
+void DestroyPlayer(Player *player) {
+  UnloadModelPalette(&player->palette);
+  UnloadPose(player->pose);
+  UnloadPose(player->additiveAimLeft);
+  UnloadPose(player->additiveAimUp);
+
+  UnloadBoneMask(player->lowerBodyMask);
+  UnloadBoneMask(player->upperBodyMask);
+  UnloadCompiledBoneMask(player->lowerBodyBones);
+  UnloadCompiledBoneMask(player->upperBodyBones);
+
+  UnloadModelAnimations(player->motionAnims, player->motionAnimCount);
+  UnloadModelAnimations(player->fallingAnims, player->fallingAnimCount);
+  UnloadModelAnimations(player->drawRifleAnims, player->drawRifleAnimCount);
+  UnloadModelAnimations(player->aimAnims, player->aimAnimCount);
+
+  free(player->walkDisc.superimposedDisc);
+
+  UnloadPoseArena(player->arena);
+  free(player->arena);
+
+  UnloadModel(player->model);
+
+  *player = (Player){0};
+}
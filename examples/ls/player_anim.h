@@ -41,6 +41,7 @@ Usage example to help understad:
 #include "../common/utils.h"
 #include "skeleton.h"
 #include "pose.h"
+#include "pose_arena.h"
 
 
 typedef struct AnimModelDisc {
@@ -70,6 +71,9 @@ typedef struct AnimModelDisc {
 
   /* Another disc to use and blend */
   struct AnimModelDisc *superimposedDisc; // eg: This disc contain running animation data when base disc contains walking.
+
+  /* Optional arena to take poses from. If set, returned pose also lives in arena and must not be unloaded. */
+  PoseArena *arena;
 } AnimModelDisc;
 
 Pose AnimModelDiscGetPose(AnimModelDisc *disc, /* UP-DOWN input */ float ud, /* LEFT-RIGHT input */ float lr, /* How must to superimpose the superimposeDisc */float superimposeFactor) {
@@ -114,26 +118,28 @@ Pose AnimModelDiscGetPose(AnimModelDisc *disc, /* UP-DOWN input */ float ud, /*
                 (Clamp(fabs(ud), 0.0001f, 1.0f) +
                  Clamp(fabs(lr), 0.0001f, 1.0f));
 
+  // Allocate result first so temporaries after it can be given back to arena
+  Pose finalPose = PoseArenaInitPose(disc->arena, disc->boneCount);
+  PoseArenaMark mark = PoseArenaGetMark(disc->arena);
+
   // lerp the left-right motion with front-back
-  Pose baseLerpPose defer(UnloadPosePtr) = PoseLerp(poseUD, poseLR, disc->boneCount, weightY);
+  Pose motionPose = PoseArenaInitPose(disc->arena, disc->boneCount);
+  PoseLerpInto(motionPose, poseUD, poseLR, disc->boneCount, weightY);
 
-  // Get pose from superimposed disc
-  Pose superimposedPose defer(UnloadPosePtr) = NULL;
+  // Get pose from superimposed disc and lerp to it
   if (disc->superimposedDisc && superimposeFactor) {
-    superimposedPose = AnimModelDiscGetPose(disc->superimposedDisc, ud, lr, superimposeFactor);
-  }
-
-  Pose finalMotionPose defer(UnloadPosePtr) = NULL;
-  if (superimposedPose) {
-    finalMotionPose = PoseLerp(baseLerpPose, superimposedPose, disc->boneCount, superimposeFactor);
-  } else {
-    finalMotionPose = CopyPose(baseLerpPose, disc->boneCount);
+    Pose superimposedPose = AnimModelDiscGetPose(disc->superimposedDisc, ud, lr, superimposeFactor);
+    PoseLerpInto(motionPose, motionPose, superimposedPose, disc->boneCount, superimposeFactor);
+    PoseArenaUnloadPose(disc->superimposedDisc->arena, superimposedPose);
   }
 
   float idleToMotionBlend = sqrt(ud*ud + lr*lr);
 
   // Finally lerp the motion pose calculated above to idle pose
-  Pose finalPose = PoseLerp(idle, finalMotionPose, disc->boneCount, idleToMotionBlend);
+  PoseLerpInto(finalPose, idle, motionPose, disc->boneCount, idleToMotionBlend);
+
+  PoseArenaUnloadPose(disc->arena, motionPose);
+  PoseArenaRewind(disc->arena, mark);
+
   return finalPose;
 }
-
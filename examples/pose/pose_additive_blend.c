@@ -5,7 +5,9 @@
   global pose tranformations to local pose transformations and get
   better results and more option with animations in raylib. 
   This example specificly shows additive animation blending between
-  local transform frames. It have a simple model picked from 
+  local transform frames. Additive pose of crouch over idle is baked
+  once at start (`LoadAdditiveAnimationClipFromFrame()`) and only
+  blended every frame. It have a simple model picked from 
    Mixamo(https://www.mixamo.com/) along with some basic 
    locomotion animations(listed in `enum ANIM`).
 
@@ -47,6 +49,10 @@ int crouchAnimIndex = 0;
 int crouchAnimCount = 0;
 ModelAnimation *crouchAnim;
 
+AnimationClip idleClip;           // Local frames of idle
+AnimationClip crouchAdditiveClip; // Crouch relative to first idle frame (local)
+Pose resultPose;                  // Local result of blend
+
 float additiveLayerWeight = 0.0f;
 
 void OnStart() {
@@ -61,6 +67,14 @@ void OnStart() {
   anims = LoadModelAnimations(ANIMATION_FILE_NAME, &animsCount);
   crouchAnim = LoadModelAnimations(ANIMATION_CROUCH_FILE_NAME, &crouchAnimCount);
 
+  idleClip = LoadAnimationClipFromModelAnimation(anims[IDLE], CLIP_LOCAL_POSE);
+
+  AnimationClip crouchClip = LoadAnimationClipFromModelAnimation(crouchAnim[0], CLIP_LOCAL_POSE);
+  crouchAdditiveClip = LoadAdditiveAnimationClipFromFrame(crouchClip, idleClip, 0, &skeleton.hierarchy, CLIP_LOCAL_POSE);
+  UnloadAnimationClip(crouchClip);
+
+  resultPose = InitPose(skeleton.boneCount);
+
   model.transform = MatrixIdentity();
   model.transform = MatrixMultiply(MatrixRotateX(PI / 2), model.transform);
   model.transform =
@@ -81,24 +95,18 @@ void OnUpdate() {
   /********** UPDATE ANIMATION **********/
 
   /// UPDATE POSE BELOW ///
-  Pose idlePose = PoseToLocalTransformPose(anims[IDLE].framePoses[0], skeleton.bones, skeleton.boneCount);
-  Pose crouchPose = PoseToLocalTransformPose(crouchAnim[0].framePoses[0], skeleton.bones, skeleton.boneCount);
-  Pose crouchPoseAdditive = PoseGenerateAdditivePose(crouchPose, idlePose, skeleton.boneCount);
+  Pose idlePose = AnimationClipGetLocalPose(idleClip, 0);
+  Pose crouchPoseAdditive = AnimationClipGetLocalPose(crouchAdditiveClip, 0);
 
   // Note: Weight is doubled
-  Pose resultPose = PoseAdditiveBlend(idlePose, crouchPoseAdditive, skeleton.boneCount, 1.0f, 2.0 * clamp(abs_(additiveLayerWeight), 0.0f, 1.0f), NULL);
-
-  UnloadPose(idlePose);
-  UnloadPose(crouchPoseAdditive);
-  UnloadPose(skeleton.pose);
+  PoseAdditiveBlendInto(resultPose, idlePose, crouchPoseAdditive, skeleton.boneCount, 1.0f, 2.0 * clamp(abs_(additiveLayerWeight), 0.0f, 1.0f), NULL);
 
-  skeleton.pose = PoseToGlobalTransformPose(resultPose, skeleton.bones, skeleton.boneCount);
-  resultPose = NULL;
+  PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, resultPose, &skeleton.hierarchy);
 
   if (IsKeyDown(KEY_I)) {
-    skeleton.pose = anims[IDLE].framePoses[0];
+    CopyPoseInto(skeleton.pose, anims[IDLE].framePoses[0], skeleton.boneCount);
   } else if (IsKeyDown(KEY_C)) {
-    skeleton.pose = crouchAnim[0].framePoses[0];
+    CopyPoseInto(skeleton.pose, crouchAnim[0].framePoses[0], skeleton.boneCount);
   }
 
   /// UPDATE POSE ABOVE ///
@@ -120,6 +128,10 @@ void OnDrawHUD() {
 }
 
 void OnEnd() {
+  UnloadPose(resultPose);
+  UnloadAnimationClip(idleClip);
+  UnloadAnimationClip(crouchAdditiveClip);
+  UnloadModelAnimations(crouchAnim, crouchAnimCount);
   UnloadModelAnimations(anims, animsCount);
   UnloadModel(model);
   UnloadSkeleton(skeleton);
@@ -7,9 +7,10 @@
    locomotion animations(listed in `enum ANIM`).
 
  By default raylib bone data in global transforms(i.e. relative to origin).
-    So, here `PoseToLocalTransformPose()` function converts a pose from 
-    global transforms to local transforms(i.e. relative to parent bone).
-    And its reversal is done using `PoseToGlobalTransformPose()`.
+    So, here skeleton keeps a local pose (i.e. relative to parent bone,
+    see `LoadSkeletonDirtyState()`). Editing a bone marks it dirty and
+    `UpdateSkeletonDirty()` recomputes global transforms and skinning
+    matrices of that bone's subtree only (nothing when no key is pressed).
 
  Authors:
   - Kirandeep Singh (@Kirandeep-Singh-Khehra)
@@ -17,7 +18,7 @@
  This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
 \******************************************************************/
 
-#include "skeleton.h"
+#include "skeleton_dirty.h"
 #include "../common/boilerplate_main.h"
 
 #define MODEL_FILE_NAME "resources/models/bot.glb"
@@ -32,7 +33,8 @@ void OnStart() {
   }
 
   skeleton = LoadSkeletonFromModel(model);
-  skeleton.pose = CopyPose(model.bindPose, model.boneCount);
+  UpdateSkeletonPose(skeleton, model.bindPose);
+  LoadSkeletonDirtyState(&skeleton);
 
   model.transform = MatrixIdentity();
   model.transform = MatrixMultiply(MatrixRotateX(PI / 2), model.transform);
@@ -50,41 +52,34 @@ void OnUpdate() {
 
   ///// MODIFY POSE BELOW /////
 
-  // // Uncomment the following line to reset pose every time. But
+  // // Uncomment the following lines to reset pose every time. But
   // // make sure to replace IsKeyPressed with IsKeyDown in following if-else
-  // skeleton.pose = CopyPose(model.bindPose, model.boneCount);
+  // UpdateSkeletonPose(skeleton, model.bindPose);
+  // SyncSkeletonLocalPose(skeleton);
 
-  Pose relPose = InitPose(skeleton.boneCount);
-  Pose globalPose = InitPose(skeleton.boneCount);
-
-  relPose = PoseToLocalTransformPose(skeleton.pose, skeleton.bones,
-                                     skeleton.boneCount);
+  Transform bone = GetSkeletonBoneLocal(skeleton, 8);
 
   if (IsKeyPressed(KEY_X)) {
-    relPose[8].rotation =
+    bone.rotation =
         QuaternionMultiply(QuaternionFromMatrix(MatrixRotateX(90.0f * DEG2RAD)),
-                           relPose[8].rotation);
+                           bone.rotation);
   } else if (IsKeyPressed(KEY_Y)) {
-    relPose[8].rotation =
+    bone.rotation =
         QuaternionMultiply(QuaternionFromMatrix(MatrixRotateY(90.0f * DEG2RAD)),
-                           relPose[8].rotation);
+                           bone.rotation);
   } else if (IsKeyPressed(KEY_Z)) {
-    relPose[8].rotation =
+    bone.rotation =
         QuaternionMultiply(QuaternionFromMatrix(MatrixRotateZ(90.0f * DEG2RAD)),
-                           relPose[8].rotation);
+                           bone.rotation);
   }
 
-  globalPose =
-      PoseToGlobalTransformPose(relPose, skeleton.bones, skeleton.boneCount);
-
-  UnloadPose(skeleton.pose);
-  skeleton.pose = globalPose;
-  globalPose = NULL;
-  UnloadPose(relPose);
+  SetSkeletonBoneLocal(skeleton, 8, bone);
 
   ///// MODIFY POSE ABOVE /////
 
-  UpdateModelMeshFromPose(model, skeleton.pose);
+  if (UpdateSkeletonDirty(skeleton) > 0) {
+    UpdateModelMeshFromSkeletonDirty(model, skeleton);
+  }
 }
 
 void OnDraw() {
@@ -3,6 +3,7 @@
 #include <raygui.h>
 #include <raymath.h>
 
+#include "../../src/bone_index.h"
 #include "../../src/skeleton.h"
 
 Model model;
@@ -16,6 +17,8 @@ int animIndex = 0;
 
 int motionAnimCount = 0;
 
+AnimationClip aimAdditiveClips[2]; // Baked additive aim left and aim up
+
 float aimLeftWeight = 0.0f;
 float aimUpWeight = 0.0f;
 
@@ -32,6 +35,15 @@ void OnStart() {
   anims = LoadModelAnimations("resources/models/bot.aim.glb", &animCount);
   motionAnims = LoadModelAnimations("resources/models/bot.glb", &motionAnimCount);
 
+  // Aim poses relative to first frame of base pose. Baked once here.
+  AnimationClip baseClip = LoadAnimationClipFromModelAnimation(anims[0], CLIP_LOCAL_POSE);
+  for (int i = 0; i < 2; i++) {
+    AnimationClip aimClip = LoadAnimationClipFromModelAnimation(anims[i + 1], CLIP_LOCAL_POSE);
+    aimAdditiveClips[i] = LoadAdditiveAnimationClipFromFrame(aimClip, baseClip, 0, &skeleton.hierarchy, CLIP_LOCAL_POSE);
+    UnloadAnimationClip(aimClip);
+  }
+  UnloadAnimationClip(baseClip);
+
   for (int i = 0; i < model.materialCount; i++) {
     model.materials[i].shader = skinningShader;
   }
@@ -44,10 +56,16 @@ void OnStart() {
   camera.position = (Vector3){0.0f, 2.0f, -2.5f};
   camera.target = (Vector3){1.0f, 0.7f, 0.0f};
 
+  // Leg bones, their children and root
+  BoneIndex boneIndex = LoadBoneIndex(skeleton.bones, skeleton.hierarchy);
+  BoneMaskRule rules[] = {
+    {0, "Leg", BONE_RULE_BONES | BONE_RULE_DIRECT_CHILDREN | BONE_RULE_REGEX, 1.0f},
+    {0, skeleton.bones[0].name, BONE_RULE_BONES, 1.0f},
+  };
+
   lowerBodyMask = BoneMaskZeros(skeleton.boneCount);
-  MaskChildBonesByParentRegex(lowerBodyMask, skeleton.bones, "Leg", 1.0f, skeleton.boneCount);
-  MaskBonesByRegex(lowerBodyMask, skeleton.bones, "Leg", 1.0f, skeleton.boneCount);
-  lowerBodyMask[0] = 1.0f;
+  BuildBoneMasks(&boneIndex, rules, 2, &lowerBodyMask);
+  UnloadBoneIndex(&boneIndex);
 }
 
 void OnUpdate() {
@@ -55,8 +73,8 @@ void OnUpdate() {
   float walktoRunWeight = Clamp(idleToRunWeight, 1.0f, 2.0f) - 1.0f;
 
   UpdateSkeletonModelAnimation(skeleton, anims[0], 0);
-  UpdateSkeletonModelAnimationPoseAdditiveLayer(skeleton, anims[1], 0, anims[0].framePoses[0], aimLeftWeight, USE_LOCAL_POSE, NULL);
-  UpdateSkeletonModelAnimationPoseAdditiveLayer(skeleton, anims[2], 0, anims[0].framePoses[0], aimUpWeight, USE_LOCAL_POSE, NULL);
+  UpdateSkeletonAdditiveClipLayer(skeleton, aimAdditiveClips[0], 0, aimLeftWeight, USE_LOCAL_POSE, NULL);
+  UpdateSkeletonAdditiveClipLayer(skeleton, aimAdditiveClips[1], 0, aimUpWeight, USE_LOCAL_POSE, NULL);
   if (playLowerBodyAnimation) {
   UpdateSkeletonModelAnimationPoseOverrideLayer(skeleton, motionAnims[6/*WALK*/], motionAnimFrameCounter ++, idleToWalkWeight, USE_LOCAL_POSE, lowerBodyMask);
   UpdateSkeletonModelAnimationPoseOverrideLayer(skeleton, motionAnims[1/*RUN */], motionAnimFrameCounter ++, walktoRunWeight , USE_LOCAL_POSE, lowerBodyMask);
@@ -96,6 +114,8 @@ void OnEnd() {
   UnloadSkeleton(skeleton);
   UnloadModelAnimations(anims, animCount);
   UnloadModelAnimations(motionAnims, motionAnimCount);
+  UnloadAnimationClip(aimAdditiveClips[0]);
+  UnloadAnimationClip(aimAdditiveClips[1]);
 
   UnloadBoneMask(lowerBodyMask);
 }
@@ -12,7 +12,8 @@
       animation then it adds one override layer(interpolation layer)
       of RUN or RUN_BACK (depending on input). Followed by
       another override layer of RUN_LEFT or RUN_RIGHT(depending on
-      input).
+      input). All three layers are evaluated by one `LayerStack`
+      (single local to global pass).
   - #define TWO_LAYER_IMPL : This directive will use two layer
       implementation. Which will first bind a blended animation pose
       consisting of forward and sideways animation to skeleton.
@@ -26,7 +27,7 @@
 
 #include "../common/boilerplate_main.h"
 
-#include "skeleton.h"
+#include "layer_stack.h"
 
 // Use any one of below
 #define THREE_LAYER_IMPL
@@ -50,11 +51,14 @@ enum Anim {
 
 Model model;
 Skeleton skeleton;
+PoseArena arena; // Temporary poses of layers are taken from here
+LayerStack layers;
 
 int animsCount = 0;
 int animFrameCounter = 0;
 int idleAnimFrameCounter = 0;
 ModelAnimation *anims;
+AnimationClip *clips; // Contiguous frames of `anims` (global and local)
 
 Vector2 inputDirection = {0.0f};
 Vector2 velocity = {0.0f};
@@ -71,7 +75,14 @@ void OnStart() {
   skeleton = LoadSkeletonFromModel(model);
   skeleton.pose = CopyPose(model.bindPose, model.boneCount);
 
+  arena = LoadPoseArenaForPoses(model.boneCount, 4);
+  skeleton.arena = &arena;
+
+  layers = LoadLayerStack(skeleton);
+
   anims = LoadModelAnimations(ANIMATION_FILE_NAME, &animsCount);
+  clips = LoadAnimationClipsFromModelAnimations(anims, animsCount,
+                                                CLIP_GLOBAL_POSE | CLIP_LOCAL_POSE);
 
   model.transform = MatrixScale(0.01f, 0.01f, 0.01f);
 
@@ -121,18 +132,22 @@ void OnUpdate() {
   animFrameCounter %= min(anims[indexX].frameCount, anims[indexY].frameCount);
   idleAnimFrameCounter++;
 
+  ResetPoseArena(&arena);
+
 #ifdef THREE_LAYER_IMPL
-  UpdateSkeletonModelAnimation(skeleton, anims[IDLE], idleAnimFrameCounter);
-  UpdateSkeletonModelAnimationPoseOverrideLayer(
-      skeleton, anims[indexX], animFrameCounter, weightX, USE_LOCAL_POSE, NULL);
-  UpdateSkeletonModelAnimationPoseOverrideLayer(
-      skeleton, anims[indexY], animFrameCounter, weightY, USE_LOCAL_POSE, NULL);
+  ClearLayerStack(&layers);
+  LayerStackPushAnimationClip(&layers, clips[IDLE], idleAnimFrameCounter);
+  LayerStackPushAnimationClipOverride(&layers, clips[indexX], animFrameCounter,
+                                      weightX, NULL);
+  LayerStackPushAnimationClipOverride(&layers, clips[indexY], animFrameCounter,
+                                      weightY, NULL);
+  UpdateSkeletonFromLayerStack(skeleton, &layers);
 #endif
 #ifdef TWO_LAYER_IMPL
-  UpdateSkeletonModelAnimationLerp(skeleton, anims[indexX], animFrameCounter,
-                                   anims[indexY], animFrameCounter, weightY, USE_LOCAL_POSE);
-  UpdateSkeletonModelAnimationPoseOverrideLayer(
-      skeleton, anims[IDLE], idleAnimFrameCounter,
+  UpdateSkeletonAnimationClipLerp(skeleton, clips[indexX], animFrameCounter,
+                                  clips[indexY], animFrameCounter, weightY, USE_LOCAL_POSE);
+  UpdateSkeletonAnimationClipOverrideLayer(
+      skeleton, clips[IDLE], idleAnimFrameCounter,
       clamp(1.0f - Vector2Length(velocity), 0.0f, 1.0f), USE_LOCAL_POSE, NULL);
 #endif
 
@@ -154,8 +169,11 @@ void OnDrawHUD() {
 }
 
 void OnEnd() {
+  UnloadAnimationClips(clips, animsCount);
   UnloadModelAnimations(anims, animsCount);
   UnloadModel(model);
   UnloadSkeleton(skeleton);
+  UnloadPoseArena(&arena);
+  UnloadLayerStack(&layers);
 }
 
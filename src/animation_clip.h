@@ -0,0 +1,470 @@
+#ifndef __KIRAN_RAY_ANIMATION_CLIP__
+#define __KIRAN_RAY_ANIMATION_CLIP__
+
+#include "pose.h"
+
+#define CLIP_GLOBAL_POSE (1 << 0)
+#define CLIP_LOCAL_POSE (1 << 1)
+#define CLIP_ADDITIVE (1 << 2) // Frames are additive poses (see `LoadAdditiveAnimationClip()`)
+
+// Time modes of time based sampling
+#define CLIP_TIME_LOOP 0  // Time wraps around, last frame blends into first
+#define CLIP_TIME_CLAMP 1 // Time is clamped to [0, duration]
+
+// Frame rate of clips loaded from `ModelAnimation` (raylib bakes glTF animations at ~60 Hz)
+#define ANIMATION_CLIP_FRAME_RATE 60.0f
+
+/* Animation frames in one contiguous block.
+
+   `ModelAnimation.framePoses` is one allocation per frame and only global
+   pose. `AnimationClip` is built once from it and keeps frames in global
+   space, local space or both (`flags`). So, sampling is an index into
+   stored frames and never converts space if the needed space is stored.
+
+   Frame `f` of a space is `boneCount` transforms starting at
+   `f * boneCount` of that space's block. */
+typedef struct AnimationClip {
+  int boneCount;          // Number of bones per frame
+  int frameCount;         // Number of frames
+  int flags;              // Spaces stored (CLIP_GLOBAL_POSE, CLIP_LOCAL_POSE)
+  float frameRate;        // Frames per second
+
+  Transform *globalFrames; // Global frames (NULL if not stored)
+  Transform *localFrames;  // Local frames (NULL if not stored)
+
+  char name[32];          // Name of clip (from animation)
+} AnimationClip;
+
+AnimationClip LoadEmptyAnimationClip(int boneCount, int frameCount, int flags);
+AnimationClip LoadAnimationClipFromModelAnimation(ModelAnimation anim, int flags);
+AnimationClip *LoadAnimationClipsFromModelAnimations(ModelAnimation *anims, int animCount, int flags);
+void UnloadAnimationClip(AnimationClip clip);
+void UnloadAnimationClips(AnimationClip *clips, int clipCount);
+
+int AnimationClipIsValid(AnimationClip clip);
+int AnimationClipFrameIndex(AnimationClip clip, int frame);
+Pose AnimationClipGetGlobalPose(AnimationClip clip, int frame);
+Pose AnimationClipGetLocalPose(AnimationClip clip, int frame);
+Pose AnimationClipResolvePose(AnimationClip clip, int frame, int space,
+                              SkeletonHierarchy *hierarchy, Pose temp);
+
+/* Additive clips. Every frame is baked once into additive pose of frame
+   relative to reference (`PoseGenerateAdditivePose()`) in each space given
+   in `flags`. Layer functions consuming them skip reference conversion and
+   relative transform pass.
+
+   Additive poses of one space can not be converted to other space. So,
+   bake `CLIP_LOCAL_POSE` for `USE_LOCAL_POSE` layers and
+   `CLIP_GLOBAL_POSE` for global layers. */
+AnimationClip LoadAdditiveAnimationClip(AnimationClip clip, Pose referencePose,
+                                        SkeletonHierarchy *hierarchy, int flags);
+AnimationClip LoadAdditiveAnimationClipFromFrame(AnimationClip clip,
+                                                 AnimationClip referenceClip,
+                                                 int referenceFrame,
+                                                 SkeletonHierarchy *hierarchy,
+                                                 int flags);
+
+/* Time based sampling. Time (in seconds) is mapped to two neighbouring
+   frames (`frameRate`) which are blended in one batched pass (see
+   `TransformLerpBatch()`, nlerp unless `Ex` is given other blend flags).
+   So clips can be stored at lower rate than display rate (see
+   `LoadResampledAnimationClip()`). */
+float AnimationClipDuration(AnimationClip clip, int mode);
+float AnimationClipTimeToFrames(AnimationClip clip, float seconds, int mode,
+                                int *frameA, int *frameB);
+void AnimationClipSamplePoseInto(Pose out, AnimationClip clip, float seconds,
+                                 int mode, int space,
+                                 SkeletonHierarchy *hierarchy);
+void AnimationClipSamplePoseExInto(Pose out, AnimationClip clip, float seconds,
+                                   int mode, int space,
+                                   SkeletonHierarchy *hierarchy, int flags);
+
+AnimationClip LoadResampledAnimationClip(AnimationClip clip, float frameRate,
+                                         int mode, SkeletonHierarchy *hierarchy);
+float AnimationClipMeasureResampleError(AnimationClip resampled,
+                                        AnimationClip source, int mode,
+                                        SkeletonHierarchy *hierarchy,
+                                        int *frame, int *boneId);
+
+/* Source animation is global (as loaded by raylib). Any combination of
+   `CLIP_GLOBAL_POSE` and `CLIP_LOCAL_POSE` can be given in `flags`
+   (0 means global only). */
+AnimationClip LoadAnimationClipFromModelAnimation(ModelAnimation anim, int flags) {
+  AnimationClip clip = {0};
+
+  if ((anim.frameCount <= 0) || (anim.boneCount <= 0) || (anim.framePoses == NULL)) {
+    return clip;
+  }
+
+  clip = LoadEmptyAnimationClip(anim.boneCount, anim.frameCount, flags);
+  if (!AnimationClipIsValid(clip)) {
+    TraceLog(LOG_WARNING, "CLIP: Failed to allocate frames of \"%s\"", anim.name);
+    return clip;
+  }
+
+  memcpy(clip.name, anim.name, sizeof(clip.name));
+  clip.name[sizeof(clip.name) - 1] = '\0';
+
+  SkeletonHierarchy hierarchy = {0};
+  if (clip.localFrames) {
+    hierarchy = LoadSkeletonHierarchy(anim.bones, anim.boneCount);
+  }
+
+  for (int frame = 0; frame < clip.frameCount; frame++) {
+    if (clip.globalFrames) {
+      CopyPoseInto(AnimationClipGetGlobalPose(clip, frame), anim.framePoses[frame], clip.boneCount);
+    }
+    if (clip.localFrames) {
+      PoseToLocalTransformPoseHierarchyInto(AnimationClipGetLocalPose(clip, frame), anim.framePoses[frame], &hierarchy);
+    }
+  }
+
+  if (clip.localFrames) {
+    UnloadSkeletonHierarchy(hierarchy);
+  }
+
+  return clip;
+}
+
+AnimationClip *LoadAnimationClipsFromModelAnimations(ModelAnimation *anims, int animCount, int flags) {
+  AnimationClip *clips = calloc(animCount, sizeof(AnimationClip));
+
+  for (int i = 0; (clips != NULL) && (i < animCount); i++) {
+    clips[i] = LoadAnimationClipFromModelAnimation(anims[i], flags);
+  }
+
+  return clips;
+}
+
+void UnloadAnimationClip(AnimationClip clip) {
+  // Global frames come first in allocation if stored
+  free((clip.globalFrames) ? clip.globalFrames : clip.localFrames);
+}
+
+void UnloadAnimationClips(AnimationClip *clips, int clipCount) {
+  for (int i = 0; i < clipCount; i++) {
+    UnloadAnimationClip(clips[i]);
+  }
+
+  free(clips);
+}
+
+int AnimationClipIsValid(AnimationClip clip) {
+  return (clip.frameCount > 0) && (clip.globalFrames || clip.localFrames);
+}
+
+// Wraps `frame` around (also for negative frames)
+int AnimationClipFrameIndex(AnimationClip clip, int frame) {
+  frame %= clip.frameCount;
+
+  return (frame < 0) ? frame + clip.frameCount : frame;
+}
+
+Pose AnimationClipGetGlobalPose(AnimationClip clip, int frame) {
+  if (clip.globalFrames == NULL) {
+    return NULL;
+  }
+
+  return clip.globalFrames + (size_t)AnimationClipFrameIndex(clip, frame) * clip.boneCount;
+}
+
+Pose AnimationClipGetLocalPose(AnimationClip clip, int frame) {
+  if (clip.localFrames == NULL) {
+    return NULL;
+  }
+
+  return clip.localFrames + (size_t)AnimationClipFrameIndex(clip, frame) * clip.boneCount;
+}
+
+/* Frame in `space` (`CLIP_GLOBAL_POSE` or `CLIP_LOCAL_POSE`). Stored frame
+   is returned as is, otherwise other space is converted into `temp` (using
+   `hierarchy`) and `temp` is returned. */
+Pose AnimationClipResolvePose(AnimationClip clip, int frame, int space,
+                              SkeletonHierarchy *hierarchy, Pose temp) {
+  if (space & CLIP_LOCAL_POSE) {
+    if (clip.localFrames) {
+      return AnimationClipGetLocalPose(clip, frame);
+    }
+
+    PoseToLocalTransformPoseHierarchyInto(temp, AnimationClipGetGlobalPose(clip, frame), hierarchy);
+  } else {
+    if (clip.globalFrames) {
+      return AnimationClipGetGlobalPose(clip, frame);
+    }
+
+    PoseToGlobalTransformPoseHierarchyInto(temp, AnimationClipGetLocalPose(clip, frame), hierarchy);
+  }
+
+  return temp;
+}
+
+// Allocates clip frames for spaces in `flags` (0 means global only).
+AnimationClip LoadEmptyAnimationClip(int boneCount, int frameCount, int flags) {
+  AnimationClip clip = {0};
+
+  if (!(flags & (CLIP_GLOBAL_POSE | CLIP_LOCAL_POSE))) {
+    flags |= CLIP_GLOBAL_POSE;
+  }
+
+  int storedSpaces = ((flags & CLIP_GLOBAL_POSE) ? 1 : 0) + ((flags & CLIP_LOCAL_POSE) ? 1 : 0);
+  size_t spaceSize = (size_t)frameCount * boneCount;
+
+  // All frames of all spaces in one allocation
+  Transform *memory = malloc(storedSpaces * spaceSize * sizeof(Transform));
+  if (memory == NULL) {
+    return clip;
+  }
+
+  clip.boneCount = boneCount;
+  clip.frameCount = frameCount;
+  clip.flags = flags;
+  clip.frameRate = ANIMATION_CLIP_FRAME_RATE;
+
+  if (flags & CLIP_GLOBAL_POSE) {
+    clip.globalFrames = memory;
+    memory += spaceSize;
+  }
+  if (flags & CLIP_LOCAL_POSE) {
+    clip.localFrames = memory;
+  }
+
+  return clip;
+}
+
+// Reference is given in global space and/or local space (NULL if not available).
+AnimationClip LoadAdditiveAnimationClipEx(AnimationClip clip, Pose globalReference,
+                                          Pose localReference,
+                                          SkeletonHierarchy *hierarchy, int flags) {
+  AnimationClip additive = {0};
+
+  if (!AnimationClipIsValid(clip) || (clip.flags & CLIP_ADDITIVE)) {
+    TraceLog(LOG_WARNING, "CLIP: Can not bake additive clip of \"%s\"", clip.name);
+    return additive;
+  }
+
+  additive = LoadEmptyAnimationClip(clip.boneCount, clip.frameCount, flags);
+  if (!AnimationClipIsValid(additive)) {
+    TraceLog(LOG_WARNING, "CLIP: Failed to allocate frames of additive \"%s\"", clip.name);
+    return additive;
+  }
+
+  additive.flags |= CLIP_ADDITIVE;
+  additive.frameRate = clip.frameRate;
+  memcpy(additive.name, clip.name, sizeof(additive.name));
+
+  Pose temp = InitPose(2 * clip.boneCount);
+  Pose referenceTemp = temp + clip.boneCount;
+
+  for (int space = CLIP_GLOBAL_POSE; space <= CLIP_LOCAL_POSE; space <<= 1) {
+    if (!(additive.flags & space)) {
+      continue;
+    }
+
+    Pose reference = (space == CLIP_LOCAL_POSE) ? localReference : globalReference;
+    if (reference == NULL && space == CLIP_LOCAL_POSE) {
+      PoseToLocalTransformPoseHierarchyInto(referenceTemp, globalReference, hierarchy);
+      reference = referenceTemp;
+    } else if (reference == NULL) {
+      PoseToGlobalTransformPoseHierarchyInto(referenceTemp, localReference, hierarchy);
+      reference = referenceTemp;
+    }
+
+    for (int frame = 0; frame < clip.frameCount; frame++) {
+      Pose pose = AnimationClipResolvePose(clip, frame, space, hierarchy, temp);
+      Pose out = (space == CLIP_LOCAL_POSE) ? AnimationClipGetLocalPose(additive, frame) : AnimationClipGetGlobalPose(additive, frame);
+
+      PoseGenerateAdditivePoseInto(out, pose, reference, clip.boneCount);
+    }
+  }
+
+  UnloadPose(temp);
+
+  return additive;
+}
+
+// `referencePose` is global pose. `hierarchy` is used for space conversions.
+AnimationClip LoadAdditiveAnimationClip(AnimationClip clip, Pose referencePose,
+                                        SkeletonHierarchy *hierarchy, int flags) {
+  return LoadAdditiveAnimationClipEx(clip, referencePose, NULL, hierarchy, flags);
+}
+
+AnimationClip LoadAdditiveAnimationClipFromFrame(AnimationClip clip,
+                                                 AnimationClip referenceClip,
+                                                 int referenceFrame,
+                                                 SkeletonHierarchy *hierarchy,
+                                                 int flags) {
+  if (!AnimationClipIsValid(referenceClip)) {
+    return (AnimationClip){0};
+  }
+
+  return LoadAdditiveAnimationClipEx(clip,
+                                     AnimationClipGetGlobalPose(referenceClip, referenceFrame),
+                                     AnimationClipGetLocalPose(referenceClip, referenceFrame),
+                                     hierarchy, flags);
+}
+
+/* Looping clip lasts `frameCount` frames (last frame blends into first).
+   Clamped clip ends at its last frame. */
+float AnimationClipDuration(AnimationClip clip, int mode) {
+  int frames = (mode == CLIP_TIME_CLAMP) ? clip.frameCount - 1 : clip.frameCount;
+
+  return (frames > 0) ? frames / clip.frameRate : 0.0f;
+}
+
+// Frames around time `seconds`. Returns blend factor from `frameA` to `frameB`.
+float AnimationClipTimeToFrames(AnimationClip clip, float seconds, int mode,
+                                int *frameA, int *frameB) {
+  float position = seconds * clip.frameRate;
+
+  if (mode == CLIP_TIME_CLAMP) {
+    position = Clamp(position, 0.0f, (float)(clip.frameCount - 1));
+  } else {
+    position = fmodf(position, (float)clip.frameCount);
+    if (position < 0.0f) {
+      position += clip.frameCount;
+    }
+  }
+
+  int frame = (int)position;
+  float factor = position - frame;
+
+  // Float rounding can land on `frameCount`
+  if (frame >= clip.frameCount) {
+    frame = (mode == CLIP_TIME_CLAMP) ? clip.frameCount - 1 : 0;
+    factor = 0.0f;
+  }
+
+  *frameA = frame;
+  *frameB = (mode == CLIP_TIME_CLAMP && frame == clip.frameCount - 1) ? frame : AnimationClipFrameIndex(clip, frame + 1);
+
+  return factor;
+}
+
+/* Pose at `seconds` in `space` (`CLIP_GLOBAL_POSE` or `CLIP_LOCAL_POSE`).
+   Frames of stored space are blended straight into `out`. If `space` is
+   not stored, other space is sampled and converted (using `hierarchy`).
+   Frames are blended with nlerp. */
+void AnimationClipSamplePoseInto(Pose out, AnimationClip clip, float seconds,
+                                 int mode, int space,
+                                 SkeletonHierarchy *hierarchy) {
+  AnimationClipSamplePoseExInto(out, clip, seconds, mode, space, hierarchy, BLEND_NLERP);
+}
+
+/* Same as above with blend `flags` (`BLEND_NLERP`, `BLEND_SAME_HEMISPHERE`)
+   for frames. Passing 0 blends with slerp. */
+void AnimationClipSamplePoseExInto(Pose out, AnimationClip clip, float seconds,
+                                   int mode, int space,
+                                   SkeletonHierarchy *hierarchy, int flags) {
+  if (!AnimationClipIsValid(clip)) {
+    return;
+  }
+
+  int frameA, frameB;
+  float factor = AnimationClipTimeToFrames(clip, seconds, mode, &frameA, &frameB);
+
+  int local = (space & CLIP_LOCAL_POSE) ? (clip.localFrames != NULL) : (clip.globalFrames == NULL);
+  Pose poseA = (local) ? AnimationClipGetLocalPose(clip, frameA) : AnimationClipGetGlobalPose(clip, frameA);
+  Pose poseB = (local) ? AnimationClipGetLocalPose(clip, frameB) : AnimationClipGetGlobalPose(clip, frameB);
+
+  if (factor == 0.0f) {
+    CopyPoseInto(out, poseA, clip.boneCount);
+  } else {
+    TransformLerpBatch(out, poseA, poseB, clip.boneCount, factor, NULL, flags);
+  }
+
+  if (local && !(space & CLIP_LOCAL_POSE)) {
+    PoseToGlobalTransformPoseHierarchyInto(out, out, hierarchy);
+  } else if (!local && (space & CLIP_LOCAL_POSE)) {
+    PoseToLocalTransformPoseHierarchyInto(out, out, hierarchy);
+  }
+}
+
+/* Re-bakes clip at `frameRate` (same spaces as `clip`). Duration of clip is
+   kept, so stored `frameRate` of result can differ slightly from requested
+   one to fit whole frames. Frames are sampled in local space when stored
+   (blending global frames does not keep bone lengths). Additive poses can
+   not be converted between spaces, so every stored space of an additive
+   clip is sampled from its own frames. */
+AnimationClip LoadResampledAnimationClip(AnimationClip clip, float frameRate,
+                                         int mode, SkeletonHierarchy *hierarchy) {
+  AnimationClip resampled = {0};
+
+  if (!AnimationClipIsValid(clip) || frameRate <= 0.0f) {
+    TraceLog(LOG_WARNING, "CLIP: Can not resample clip \"%s\"", clip.name);
+    return resampled;
+  }
+
+  float duration = AnimationClipDuration(clip, mode);
+  int frameCount = (int)(duration * frameRate + 0.5f) + ((mode == CLIP_TIME_CLAMP) ? 1 : 0);
+  if (frameCount < 1) {
+    frameCount = 1;
+  }
+
+  resampled = LoadEmptyAnimationClip(clip.boneCount, frameCount, clip.flags & (CLIP_GLOBAL_POSE | CLIP_LOCAL_POSE));
+  if (!AnimationClipIsValid(resampled)) {
+    TraceLog(LOG_WARNING, "CLIP: Failed to allocate frames of resampled \"%s\"", clip.name);
+    return resampled;
+  }
+
+  int intervals = (mode == CLIP_TIME_CLAMP) ? frameCount - 1 : frameCount;
+  resampled.flags = clip.flags;
+  resampled.frameRate = (intervals > 0 && duration > 0.0f) ? intervals / duration : frameRate;
+  memcpy(resampled.name, clip.name, sizeof(resampled.name));
+
+  int space = (clip.localFrames) ? CLIP_LOCAL_POSE : CLIP_GLOBAL_POSE;
+  int additive = (clip.flags & CLIP_ADDITIVE);
+
+  for (int frame = 0; frame < frameCount; frame++) {
+    float seconds = frame / resampled.frameRate;
+    Pose local = AnimationClipGetLocalPose(resampled, frame);
+    Pose global = AnimationClipGetGlobalPose(resampled, frame);
+
+    AnimationClipSamplePoseInto((space == CLIP_LOCAL_POSE) ? local : global, clip, seconds, mode, space, hierarchy);
+
+    if (space == CLIP_LOCAL_POSE && global) {
+      if (additive) {
+        AnimationClipSamplePoseInto(global, clip, seconds, mode, CLIP_GLOBAL_POSE, hierarchy);
+      } else {
+        PoseToGlobalTransformPoseHierarchyInto(global, local, hierarchy);
+      }
+    }
+  }
+
+  return resampled;
+}
+
+/* Max world space position error of bones of `resampled` (sampled at time
+   of every source frame) against frames of `source`. */
+float AnimationClipMeasureResampleError(AnimationClip resampled,
+                                        AnimationClip source, int mode,
+                                        SkeletonHierarchy *hierarchy,
+                                        int *frame, int *boneId) {
+  float maxError = 0.0f;
+
+  Pose sampled = InitPose(2 * source.boneCount);
+  Pose temp = sampled + source.boneCount;
+
+  for (int f = 0; f < source.frameCount; f++) {
+    AnimationClipSamplePoseInto(sampled, resampled, f / source.frameRate, mode, CLIP_GLOBAL_POSE, hierarchy);
+    Pose reference = AnimationClipResolvePose(source, f, CLIP_GLOBAL_POSE, hierarchy, temp);
+
+    for (int b = 0; b < source.boneCount; b++) {
+      float error = Vector3Distance(sampled[b].translation, reference[b].translation);
+      if (error > maxError) {
+        maxError = error;
+        if (frame) {
+          *frame = f;
+        }
+        if (boneId) {
+          *boneId = b;
+        }
+      }
+    }
+  }
+
+  UnloadPose(sampled);
+
+  return maxError;
+}
+
+#endif
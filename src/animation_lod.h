@@ -0,0 +1,379 @@
+#ifndef __KIRAN_RAY_ANIMATION_LOD__
+#define __KIRAN_RAY_ANIMATION_LOD__
+
+#include <float.h>
+
+#include "skeleton_def.h"
+
+#define ANIMATION_LOD_MAX_LEVELS 8
+
+// `AnimationLodEndUpdate()` flags
+#define ANIMATION_LOD_FULL_POSE (1 << 0) // Also write global pose of excluded bones
+
+/* Animation level of detail.
+
+   Each level has:
+    - Bone set: bones animated at that level. Excluded bones (and their
+      subtrees) keep their bind pose relative to parent, so they follow
+      parent's motion. Exclusions of a level also apply to all farther
+      levels.
+    - Update interval: full evaluation every `updateInterval` frames.
+      Frames in between blend last two evaluated poses (see
+      `AnimationLodInstance`).
+    - Clip mip: index into clip mip chain (`LoadAnimationClipMips()`) to
+      sample at that level (lower frame rate clips for far levels).
+
+   Level is picked from camera distance (`AnimationLodSelectLevel()`) or
+   set explicitly. */
+typedef struct AnimationLodLevel {
+  float distance;      // Max camera distance of level (last level has no max)
+  int updateInterval;  // Frames per full evaluation (1 = every frame)
+  int clipMip;         // Mip of clip mip chain sampled at this level
+  int boneCount;       // Number of bones animated at this level
+  int *bones;          // Bones animated (parent first)
+  unsigned char *animated; // Per bone flag (1 if animated)
+  int *sourceBones;    // Per bone: nearest animated bone up the hierarchy (itself if animated)
+} AnimationLodLevel;
+
+typedef struct AnimationLod {
+  SkeletonHierarchy hierarchy; // Hierarchy of skeleton (not owned)
+  Pose bindLocalPose;          // Bind pose relative to parents (for excluded bones)
+
+  int levelCount;              // Number of levels
+  AnimationLodLevel levels[ANIMATION_LOD_MAX_LEVELS];
+} AnimationLod;
+
+/* Per character LOD state. Evaluated poses are local (before FK), so a
+   skipped frame costs one blend and FK of animated bones of level. */
+typedef struct AnimationLodInstance {
+  int level;          // Current level
+  int step;           // Frames since last full evaluation
+  Pose previousPose;  // Local pose of evaluation before last
+  Pose currentPose;   // Local pose of last evaluation (evaluate into this)
+} AnimationLodInstance;
+
+AnimationLod LoadAnimationLod(Skeleton skeleton, int levelCount);
+void UnloadAnimationLod(AnimationLod *lod);
+void SetAnimationLodLevel(AnimationLod *lod, int level, float distance,
+                          int updateInterval, int clipMip);
+void AnimationLodExcludeBones(AnimationLod *lod, int level, BoneMask mask);
+void AnimationLodExcludeBonesByRegex(AnimationLod *lod, int level,
+                                     BoneInfo *bones, char *pattern);
+int AnimationLodSelectLevel(AnimationLod *lod, float distance);
+
+AnimationClip *LoadAnimationClipMips(AnimationClip clip, int mipCount, int mode,
+                                     SkeletonHierarchy *hierarchy);
+void UnloadAnimationClipMips(AnimationClip *mips, int mipCount);
+
+void AnimationLodSampleClipInto(Pose out, AnimationLod *lod, int level,
+                                AnimationClip clip, float seconds, int mode);
+void AnimationLodApplyBoneSet(Pose localPose, AnimationLod *lod, int level);
+
+AnimationLodInstance LoadAnimationLodInstance(AnimationLod *lod, int phase);
+void UnloadAnimationLodInstance(AnimationLodInstance instance);
+void SetAnimationLodInstanceLevel(AnimationLod *lod, AnimationLodInstance *instance, int level);
+int AnimationLodBeginUpdate(AnimationLod *lod, AnimationLodInstance *instance);
+void AnimationLodEndUpdate(AnimationLod *lod, AnimationLodInstance *instance,
+                           Skeleton skeleton, int flags);
+void AnimationLodUpdatePalette(AnimationLod *lod, int level, SkeletonInstance instance);
+
+/* Levels start with all bones animated every frame from mip 0. Level `i`
+   covers distances up to `FLT_MAX` till set with `SetAnimationLodLevel()`. */
+AnimationLod LoadAnimationLod(Skeleton skeleton, int levelCount) {
+  AnimationLod lod = {0};
+
+  if (levelCount < 1) {
+    levelCount = 1;
+  }
+  if (levelCount > ANIMATION_LOD_MAX_LEVELS) {
+    levelCount = ANIMATION_LOD_MAX_LEVELS;
+  }
+
+  int boneCount = skeleton.boneCount;
+
+  lod.hierarchy = skeleton.hierarchy;
+  lod.levelCount = levelCount;
+  lod.bindLocalPose = InitPose(boneCount);
+  PoseToLocalTransformPoseHierarchyInto(lod.bindLocalPose, skeleton.bindPose, &skeleton.hierarchy);
+
+  // Bone lists and flags of all levels in one allocation (freed with levels[0].bones)
+  int *bones = malloc(levelCount * boneCount * (2 * sizeof(int) + sizeof(unsigned char)));
+  int *sourceBones = bones + levelCount * boneCount;
+  unsigned char *animated = (unsigned char *)(sourceBones + levelCount * boneCount);
+
+  for (int level = 0; level < levelCount; level++) {
+    AnimationLodLevel *lodLevel = &lod.levels[level];
+
+    lodLevel->distance = FLT_MAX;
+    lodLevel->updateInterval = 1;
+    lodLevel->clipMip = 0;
+    lodLevel->boneCount = boneCount;
+    lodLevel->bones = bones + level * boneCount;
+    lodLevel->animated = animated + level * boneCount;
+    lodLevel->sourceBones = sourceBones + level * boneCount;
+
+    for (int i = 0; i < boneCount; i++) {
+      lodLevel->bones[i] = lod.hierarchy.order[i];
+      lodLevel->animated[i] = 1;
+      lodLevel->sourceBones[i] = i;
+    }
+  }
+
+  return lod;
+}
+
+void UnloadAnimationLod(AnimationLod *lod) {
+  UnloadPose(lod->bindLocalPose);
+  free(lod->levels[0].bones);
+
+  *lod = (AnimationLod){0};
+}
+
+void SetAnimationLodLevel(AnimationLod *lod, int level, float distance,
+                          int updateInterval, int clipMip) {
+  if (level < 0 || level >= lod->levelCount) {
+    TraceLog(LOG_WARNING, "LOD: Level %d out of range", level);
+    return;
+  }
+
+  lod->levels[level].distance = distance;
+  lod->levels[level].updateInterval = (updateInterval > 0) ? updateInterval : 1;
+  lod->levels[level].clipMip = (clipMip > 0) ? clipMip : 0;
+}
+
+/* Excludes bones with non zero `mask` weight (with their subtrees) from
+   `level` and all farther levels. */
+void AnimationLodExcludeBones(AnimationLod *lod, int level, BoneMask mask) {
+  int boneCount = lod->hierarchy.boneCount;
+
+  for (int l = level; l < lod->levelCount; l++) {
+    AnimationLodLevel *lodLevel = &lod->levels[l];
+
+    for (int i = 0; i < boneCount; i++) {
+      int boneId = lod->hierarchy.order[i];
+      int parent = lod->hierarchy.parents[boneId];
+
+      // Parents come first, so a subtree is excluded with its root
+      if (mask[boneId] != 0.0f || (parent != -1 && !lodLevel->animated[parent])) {
+        lodLevel->animated[boneId] = 0;
+      }
+      lodLevel->sourceBones[boneId] = (lodLevel->animated[boneId] || parent == -1) ? boneId : lodLevel->sourceBones[parent];
+    }
+
+    lodLevel->boneCount = 0;
+    for (int i = 0; i < boneCount; i++) {
+      int boneId = lod->hierarchy.order[i];
+      if (lodLevel->animated[boneId]) {
+        lodLevel->bones[lodLevel->boneCount++] = boneId;
+      }
+    }
+  }
+}
+
+void AnimationLodExcludeBonesByRegex(AnimationLod *lod, int level,
+                                     BoneInfo *bones, char *pattern) {
+  BoneMask mask = BoneMaskZeros(lod->hierarchy.boneCount);
+
+  MaskBonesByRegex(mask, bones, pattern, 1.0f, lod->hierarchy.boneCount);
+  AnimationLodExcludeBones(lod, level, mask);
+
+  UnloadBoneMask(mask);
+}
+
+// First level covering `distance` (last level if none).
+int AnimationLodSelectLevel(AnimationLod *lod, float distance) {
+  for (int level = 0; level < lod->levelCount - 1; level++) {
+    if (distance <= lod->levels[level].distance) {
+      return level;
+    }
+  }
+
+  return lod->levelCount - 1;
+}
+
+/* Mip `m` is `clip` resampled at `frameRate / 2^m` (mip 0 is a copy).
+   Clips are time sampled, so any mip can stand in for another. */
+AnimationClip *LoadAnimationClipMips(AnimationClip clip, int mipCount, int mode,
+                                     SkeletonHierarchy *hierarchy) {
+  AnimationClip *mips = calloc(mipCount, sizeof(AnimationClip));
+
+  for (int mip = 0; (mips != NULL) && (mip < mipCount); mip++) {
+    float frameRate = clip.frameRate / (float)(1 << mip);
+    mips[mip] = LoadResampledAnimationClip(clip, frameRate, mode, hierarchy);
+  }
+
+  return mips;
+}
+
+void UnloadAnimationClipMips(AnimationClip *mips, int mipCount) {
+  UnloadAnimationClips(mips, mipCount);
+}
+
+/* Local pose of `clip` (needs local frames) at `seconds`, sampled only for
+   bones of `level`. Excluded bones get bind pose. */
+void AnimationLodSampleClipInto(Pose out, AnimationLod *lod, int level,
+                                AnimationClip clip, float seconds, int mode) {
+  AnimationLodLevel *lodLevel = &lod->levels[level];
+
+  if (clip.localFrames == NULL) {
+    TraceLog(LOG_WARNING, "LOD: Clip \"%s\" has no local frames", clip.name);
+    return;
+  }
+
+  int frameA, frameB;
+  float factor = AnimationClipTimeToFrames(clip, seconds, mode, &frameA, &frameB);
+
+  Pose poseA = AnimationClipGetLocalPose(clip, frameA);
+  Pose poseB = AnimationClipGetLocalPose(clip, frameB);
+
+  if (lodLevel->boneCount == lod->hierarchy.boneCount) {
+    TransformLerpBatch(out, poseA, poseB, clip.boneCount, factor, NULL, BLEND_NLERP);
+    return;
+  }
+
+  for (int i = 0; i < lodLevel->boneCount; i++) {
+    int boneId = lodLevel->bones[i];
+    out[boneId] = TransformLerpEx(poseA[boneId], poseB[boneId], factor, BLEND_NLERP);
+  }
+
+  AnimationLodApplyBoneSet(out, lod, level);
+}
+
+// Sets excluded bones of `level` to bind pose (local). For poses evaluated without LOD.
+void AnimationLodApplyBoneSet(Pose localPose, AnimationLod *lod, int level) {
+  AnimationLodLevel *lodLevel = &lod->levels[level];
+
+  if (lodLevel->boneCount == lod->hierarchy.boneCount) {
+    return;
+  }
+
+  for (int boneId = 0; boneId < lod->hierarchy.boneCount; boneId++) {
+    if (!lodLevel->animated[boneId]) {
+      localPose[boneId] = lod->bindLocalPose[boneId];
+    }
+  }
+}
+
+/* Instance poses start at bind pose. `phase` offsets first evaluation so
+   characters of one level do not all evaluate on same frame (e.g. use
+   character index). */
+AnimationLodInstance LoadAnimationLodInstance(AnimationLod *lod, int phase) {
+  AnimationLodInstance instance = {0};
+  int boneCount = lod->hierarchy.boneCount;
+
+  instance.previousPose = InitPose(2 * boneCount);
+  instance.currentPose = instance.previousPose + boneCount;
+  instance.step = (phase > 0) ? phase : 0;
+
+  CopyPoseInto(instance.previousPose, lod->bindLocalPose, boneCount);
+  CopyPoseInto(instance.currentPose, lod->bindLocalPose, boneCount);
+
+  return instance;
+}
+
+void UnloadAnimationLodInstance(AnimationLodInstance instance) {
+  // Poses in one allocation (lower address comes first)
+  UnloadPose((instance.previousPose < instance.currentPose) ? instance.previousPose : instance.currentPose);
+}
+
+void SetAnimationLodInstanceLevel(AnimationLod *lod, AnimationLodInstance *instance, int level) {
+  if (level < 0 || level >= lod->levelCount) {
+    return;
+  }
+
+  // Step is rescaled to keep blend factor (pose does not jump back)
+  int interval = lod->levels[instance->level].updateInterval;
+  int newInterval = lod->levels[level].updateInterval;
+  int step = (instance->step + 1) * newInterval / interval - 1;
+
+  instance->step = Clamp(step, 0, newInterval - 1);
+  instance->level = level;
+}
+
+/* Returns true if pose has to be evaluated this frame. Then evaluate local
+   pose into `instance->currentPose` (e.g. `AnimationLodSampleClipInto()`)
+   before `AnimationLodEndUpdate()`. */
+int AnimationLodBeginUpdate(AnimationLod *lod, AnimationLodInstance *instance) {
+  int interval = lod->levels[instance->level].updateInterval;
+
+  if (instance->step + 1 < interval) {
+    instance->step++;
+    return 0;
+  }
+
+  // Last evaluation becomes previous one
+  Pose pose = instance->previousPose;
+  instance->previousPose = instance->currentPose;
+  instance->currentPose = pose;
+  instance->step = 0;
+
+  return 1;
+}
+
+/* Writes global pose into `skeleton.pose`. Between evaluations it blends
+   previous into current evaluation (output is one interval behind, which
+   keeps motion continuous). Only animated bones of level are blended and
+   transformed, so cost follows bone count of level. Excluded bones of
+   `skeleton.pose` are left as they are (`AnimationLodUpdatePalette()` does
+   not read them) unless `ANIMATION_LOD_FULL_POSE` is set, then they are
+   taken from current evaluation. */
+void AnimationLodEndUpdate(AnimationLod *lod, AnimationLodInstance *instance,
+                           Skeleton skeleton, int flags) {
+  AnimationLodLevel *lodLevel = &lod->levels[instance->level];
+  float factor = (float)(instance->step + 1) / lodLevel->updateInterval;
+
+  // Parents of animated bones are animated, so their global pose is ready
+  if (lodLevel->boneCount != skeleton.boneCount && !(flags & ANIMATION_LOD_FULL_POSE)) {
+    for (int i = 0; i < lodLevel->boneCount; i++) {
+      int boneId = lodLevel->bones[i];
+      int parentId = lod->hierarchy.parents[boneId];
+      Transform local = (factor >= 1.0f) ? instance->currentPose[boneId]
+                                         : TransformLerpEx(instance->previousPose[boneId], instance->currentPose[boneId], factor, BLEND_NLERP);
+
+      skeleton.pose[boneId] = (parentId == -1) ? local : TransformLocalToGlobal(local, skeleton.pose[parentId]);
+    }
+    return;
+  }
+
+  if (factor >= 1.0f) {
+    CopyPoseInto(skeleton.pose, instance->currentPose, skeleton.boneCount);
+  } else if (lodLevel->boneCount == skeleton.boneCount) {
+    TransformLerpBatch(skeleton.pose, instance->previousPose, instance->currentPose, skeleton.boneCount, factor, NULL, BLEND_NLERP);
+  } else {
+    CopyPoseInto(skeleton.pose, instance->currentPose, skeleton.boneCount);
+    for (int i = 0; i < lodLevel->boneCount; i++) {
+      int boneId = lodLevel->bones[i];
+      skeleton.pose[boneId] = TransformLerpEx(instance->previousPose[boneId], instance->currentPose[boneId], factor, BLEND_NLERP);
+    }
+  }
+
+  PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, skeleton.pose, &lod->hierarchy);
+}
+
+/* Same as `UpdateSkeletonInstancePalette()` for a pose of `level`. An
+   excluded bone keeps bind pose relative to its nearest animated bone,
+   so it shares that bone's matrix (exact for uniform scale) and only
+   animated bones are computed. */
+void AnimationLodUpdatePalette(AnimationLod *lod, int level, SkeletonInstance instance) {
+  AnimationLodLevel *lodLevel = &lod->levels[level];
+  SkeletonDef *def = instance.def;
+
+  if (lodLevel->boneCount == def->boneCount) {
+    UpdateSkeletonInstancePalette(instance);
+    return;
+  }
+
+  // Parent first, so source matrix is ready when copied
+  for (int i = 0; i < def->boneCount; i++) {
+    int boneId = lod->hierarchy.order[i];
+    int sourceId = lodLevel->sourceBones[boneId];
+
+    if (sourceId == boneId) {
+      instance.palette[boneId] = TransformToMatrix(TransformToTransformTransformInverse(def->inverseBindPose[boneId], instance.pose[boneId]));
+    } else {
+      instance.palette[boneId] = instance.palette[sourceId];
+    }
+  }
+}
+
+#endif
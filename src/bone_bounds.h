@@ -0,0 +1,400 @@
+#ifndef __KIRAN_RAY_BONE_BOUNDS__
+#define __KIRAN_RAY_BONE_BOUNDS__
+
+#include <float.h>
+#include <raylib.h>
+#include <stdlib.h>
+
+#include "animation_clip.h"
+#include "skeleton.h"
+
+typedef struct BoneBounds {
+  int valid;            // 1 if any vertex is weighted to bone
+  BoundingBox box;      // Box of weighted vertices (skinning space of bone)
+  Vector3 capsuleStart; // Capsule around weighted vertices (skinning space of bone)
+  Vector3 capsuleEnd;
+  float capsuleRadius;
+} BoneBounds;
+
+/* Per bone bounds of a model, computed once from mesh bone weights.
+
+   Every vertex with non zero weight on a bone is added to box and
+   capsule of that bone. Bounds are kept in skinning space of bone (bind
+   pose, which skinning matrix of bone maps to pose), so a posed box is
+   exactly where that bone's vertices can go. A skinned vertex is a
+   weighted average (weights summing to 1) of its bones' matrices applied
+   to it, so it stays inside box (and sphere) enclosing posed bounds of
+   all bones. Bounds of a pose need only one matrix per bone (no palette
+   stored and no vertices).
+
+   Bone ids are read as loaded, so load before `LoadModelPalette()` with
+   `PALETTE_REMAP_MESHES`. */
+typedef struct SkeletonBounds {
+  int boneCount;          // Number of bones
+  BoneBounds *bones;      // Bounds of every bone
+  Pose inverseBindPose;   // Inverse of bind pose of model
+} SkeletonBounds;
+
+// Bounds of a pose (space of pose, e.g. model space for global pose).
+typedef struct PoseBounds {
+  BoundingBox box;  // Box enclosing posed boxes of all bones
+  Vector3 center;   // Sphere enclosing posed capsules of all bones
+  float radius;
+} PoseBounds;
+
+SkeletonBounds LoadSkeletonBounds(Model model);
+void UnloadSkeletonBounds(SkeletonBounds bounds);
+
+PoseBounds GetPoseBounds(SkeletonBounds *bounds, Pose globalPose);
+PoseBounds GetPoseBoundsScratch(SkeletonBounds *bounds, Pose globalPose, BoneBounds *scratch);
+PoseBounds GetSkeletonBounds(SkeletonBounds *bounds, Skeleton skeleton);
+PoseBounds PoseBoundsTransform(PoseBounds poseBounds, Matrix transform);
+PoseBounds PoseBoundsMerge(PoseBounds a, PoseBounds b);
+
+PoseBounds *LoadAnimationClipBounds(SkeletonBounds *bounds, AnimationClip clip,
+                                    SkeletonHierarchy *hierarchy);
+void UnloadAnimationClipBounds(PoseBounds *clipBounds);
+PoseBounds AnimationClipSampleBounds(PoseBounds *clipBounds, AnimationClip clip,
+                                     float seconds, int mode);
+
+// Calls `function` with every vertex of `model` weighted to a bone.
+void SkeletonBoundsForEachVertex(Model model,
+                                 void (*function)(BoneBounds *bone, Vector3 point),
+                                 BoneBounds *bones) {
+  for (int m = 0; m < model.meshCount; m++) {
+    Mesh mesh = model.meshes[m];
+
+    if (mesh.vertices == NULL || mesh.boneIds == NULL || mesh.boneWeights == NULL) {
+      continue;
+    }
+
+    for (int v = 0; v < mesh.vertexCount; v++) {
+      Vector3 point = {mesh.vertices[3 * v + 0], mesh.vertices[3 * v + 1], mesh.vertices[3 * v + 2]};
+
+      for (int j = 0; j < 4; j++) {
+        int boneId = mesh.boneIds[4 * v + j];
+
+        if (mesh.boneWeights[4 * v + j] > 0.0f && boneId < model.boneCount) {
+          function(&bones[boneId], point);
+        }
+      }
+    }
+  }
+}
+
+void BoneBoundsAddToBox(BoneBounds *bone, Vector3 point) {
+
+  if (!bone->valid) {
+    bone->valid = 1;
+    bone->box = (BoundingBox){point, point};
+    return;
+  }
+
+  bone->box.min = Vector3Min(bone->box.min, point);
+  bone->box.max = Vector3Max(bone->box.max, point);
+}
+
+// Capsule axis is longest axis of box through its center.
+int BoneBoundsCapsuleAxis(BoneBounds *bone, Vector3 *center) {
+  Vector3 size = Vector3Subtract(bone->box.max, bone->box.min);
+  *center = Vector3Scale(Vector3Add(bone->box.min, bone->box.max), 0.5f);
+
+  return (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z) ? 1 : 2;
+}
+
+// Coordinate of `point` along capsule axis and its squared distance from axis.
+float BoneBoundsAxisDistance(BoneBounds *bone, Vector3 point, float *along) {
+  Vector3 center;
+  int axis = BoneBoundsCapsuleAxis(bone, &center);
+  float p[3] = {point.x - center.x, point.y - center.y, point.z - center.z};
+
+  *along = p[axis];
+
+  return p[0] * p[0] + p[1] * p[1] + p[2] * p[2] - p[axis] * p[axis];
+}
+
+void BoneBoundsAddToRadius(BoneBounds *bone, Vector3 point) {
+  float along;
+  float distanceSqr = BoneBoundsAxisDistance(bone, point, &along);
+
+  if (distanceSqr > bone->capsuleRadius * bone->capsuleRadius) {
+    bone->capsuleRadius = sqrtf(distanceSqr);
+  }
+}
+
+// Extends segment (along axis, kept in capsuleStart.x / capsuleEnd.x) so point is within radius.
+void BoneBoundsAddToSegment(BoneBounds *bone, Vector3 point) {
+  float along;
+  float distanceSqr = BoneBoundsAxisDistance(bone, point, &along);
+  float reach = bone->capsuleRadius * bone->capsuleRadius - distanceSqr;
+  reach = (reach > 0.0f) ? sqrtf(reach) : 0.0f;
+
+  bone->capsuleStart.x = fminf(bone->capsuleStart.x, along + reach);
+  bone->capsuleEnd.x = fmaxf(bone->capsuleEnd.x, along - reach);
+}
+
+/* Box and capsule of every bone from vertices of all meshes. Capsule lies
+   along longest axis of box, with smallest radius around that axis. */
+SkeletonBounds LoadSkeletonBounds(Model model) {
+  SkeletonBounds bounds = {0};
+
+  if (model.boneCount <= 0 || model.bindPose == NULL) {
+    TraceLog(LOG_WARNING, "BOUNDS: Model has no bones");
+    return bounds;
+  }
+
+  bounds.boneCount = model.boneCount;
+  bounds.bones = calloc(model.boneCount, sizeof(BoneBounds));
+  bounds.inverseBindPose = InitPose(model.boneCount);
+
+  for (int i = 0; i < model.boneCount; i++) {
+    bounds.inverseBindPose[i] = TransformInvert(model.bindPose[i]);
+    bounds.bones[i].capsuleStart.x = FLT_MAX;
+    bounds.bones[i].capsuleEnd.x = -FLT_MAX;
+  }
+
+  SkeletonBoundsForEachVertex(model, BoneBoundsAddToBox, bounds.bones);
+  SkeletonBoundsForEachVertex(model, BoneBoundsAddToRadius, bounds.bones);
+  SkeletonBoundsForEachVertex(model, BoneBoundsAddToSegment, bounds.bones);
+
+  // Segment from axis coordinates to points
+  for (int i = 0; i < model.boneCount; i++) {
+    BoneBounds *bone = &bounds.bones[i];
+
+    if (!bone->valid) {
+      bone->capsuleStart = bone->capsuleEnd = Vector3Zero();
+      continue;
+    }
+
+    float start = bone->capsuleStart.x;
+    float end = bone->capsuleEnd.x;
+    if (start > end) {
+      start = end = 0.5f * (start + end);
+    }
+
+    Vector3 center;
+    int axis = BoneBoundsCapsuleAxis(bone, &center);
+    float startPoint[3] = {center.x, center.y, center.z};
+    float endPoint[3] = {center.x, center.y, center.z};
+    startPoint[axis] += start;
+    endPoint[axis] += end;
+
+    bone->capsuleStart = (Vector3){startPoint[0], startPoint[1], startPoint[2]};
+    bone->capsuleEnd = (Vector3){endPoint[0], endPoint[1], endPoint[2]};
+  }
+
+  return bounds;
+}
+
+void UnloadSkeletonBounds(SkeletonBounds bounds) {
+  free(bounds.bones);
+  UnloadPose(bounds.inverseBindPose);
+}
+
+/* Bounds of `globalPose` from bone bounds only. Box of every bone is
+   transformed with skinning matrix of bone (center and absolute extents,
+   matrix is not stored).
+   Sphere is centered on box and encloses posed capsules (or box, if
+   smaller). Capsule radius grows by largest scale of skinning transform
+   (its largest stretch, rotations being normalized). Sphere center is
+   known only after all boxes, so capsules are posed again in a second
+   pass (no allocation, see `GetPoseBoundsScratch()` to keep them). */
+PoseBounds GetPoseBounds(SkeletonBounds *bounds, Pose globalPose) {
+  return GetPoseBoundsScratch(bounds, globalPose, NULL);
+}
+
+// Capsule of `bone` posed by skinning transform (and its matrix).
+BoneBounds BoneBoundsPoseCapsule(BoneBounds *bone, Transform skinning, Matrix m) {
+  BoneBounds posed = *bone;
+  float scale = fmaxf(fabsf(skinning.scale.x), fmaxf(fabsf(skinning.scale.y), fabsf(skinning.scale.z)));
+
+  posed.capsuleStart = Vector3Transform(bone->capsuleStart, m);
+  posed.capsuleEnd = Vector3Transform(bone->capsuleEnd, m);
+  posed.capsuleRadius = bone->capsuleRadius * scale;
+
+  return posed;
+}
+
+/* Same as `GetPoseBounds()`, posed capsules are kept in `scratch` (one per
+   bone, owned by caller) instead of computing skinning matrices twice.
+   Faster when bounds of many poses are computed (e.g. every clip frame). */
+PoseBounds GetPoseBoundsScratch(SkeletonBounds *bounds, Pose globalPose, BoneBounds *scratch) {
+  PoseBounds poseBounds = {0};
+  int found = 0;
+
+  for (int i = 0; i < bounds->boneCount; i++) {
+    BoneBounds *bone = &bounds->bones[i];
+
+    if (!bone->valid) {
+      continue;
+    }
+
+    Transform skinning = TransformToTransformTransformInverse(bounds->inverseBindPose[i], globalPose[i]);
+    Matrix m = TransformToMatrix(skinning);
+
+    Vector3 center = Vector3Scale(Vector3Add(bone->box.min, bone->box.max), 0.5f);
+    Vector3 extent = Vector3Scale(Vector3Subtract(bone->box.max, bone->box.min), 0.5f);
+
+    Vector3 posedCenter = Vector3Transform(center, m);
+    Vector3 posedExtent = {
+      fabsf(m.m0) * extent.x + fabsf(m.m4) * extent.y + fabsf(m.m8) * extent.z,
+      fabsf(m.m1) * extent.x + fabsf(m.m5) * extent.y + fabsf(m.m9) * extent.z,
+      fabsf(m.m2) * extent.x + fabsf(m.m6) * extent.y + fabsf(m.m10) * extent.z,
+    };
+
+    Vector3 min = Vector3Subtract(posedCenter, posedExtent);
+    Vector3 max = Vector3Add(posedCenter, posedExtent);
+
+    if (!found) {
+      poseBounds.box = (BoundingBox){min, max};
+      found = 1;
+    } else {
+      poseBounds.box.min = Vector3Min(poseBounds.box.min, min);
+      poseBounds.box.max = Vector3Max(poseBounds.box.max, max);
+    }
+
+    if (scratch) {
+      scratch[i] = BoneBoundsPoseCapsule(bone, skinning, m);
+    }
+  }
+
+  if (!found) {
+    return poseBounds;
+  }
+
+  poseBounds.center = Vector3Scale(Vector3Add(poseBounds.box.min, poseBounds.box.max), 0.5f);
+  poseBounds.radius = 0.5f * Vector3Distance(poseBounds.box.min, poseBounds.box.max);
+
+  float radius = 0.0f;
+  for (int i = 0; i < bounds->boneCount; i++) {
+    BoneBounds *bone = &bounds->bones[i];
+
+    if (!bone->valid) {
+      continue;
+    }
+
+    BoneBounds posed;
+    if (scratch) {
+      posed = scratch[i];
+    } else {
+      Transform skinning = TransformToTransformTransformInverse(bounds->inverseBindPose[i], globalPose[i]);
+      posed = BoneBoundsPoseCapsule(bone, skinning, TransformToMatrix(skinning));
+    }
+
+    radius = fmaxf(radius, Vector3Distance(poseBounds.center, posed.capsuleStart) + posed.capsuleRadius);
+    radius = fmaxf(radius, Vector3Distance(poseBounds.center, posed.capsuleEnd) + posed.capsuleRadius);
+  }
+
+  poseBounds.radius = fminf(poseBounds.radius, radius);
+
+  return poseBounds;
+}
+
+PoseBounds GetSkeletonBounds(SkeletonBounds *bounds, Skeleton skeleton) {
+  return GetPoseBounds(bounds, skeleton.pose);
+}
+
+/* Bounds in space of `transform` (e.g. world transform of character).
+   Box stays axis aligned (so it grows under rotation). */
+PoseBounds PoseBoundsTransform(PoseBounds poseBounds, Matrix transform) {
+  PoseBounds out = {0};
+  Matrix m = transform;
+
+  Vector3 center = Vector3Scale(Vector3Add(poseBounds.box.min, poseBounds.box.max), 0.5f);
+  Vector3 extent = Vector3Scale(Vector3Subtract(poseBounds.box.max, poseBounds.box.min), 0.5f);
+
+  Vector3 posedCenter = Vector3Transform(center, m);
+  Vector3 posedExtent = {
+    fabsf(m.m0) * extent.x + fabsf(m.m4) * extent.y + fabsf(m.m8) * extent.z,
+    fabsf(m.m1) * extent.x + fabsf(m.m5) * extent.y + fabsf(m.m9) * extent.z,
+    fabsf(m.m2) * extent.x + fabsf(m.m6) * extent.y + fabsf(m.m10) * extent.z,
+  };
+
+  out.box = (BoundingBox){Vector3Subtract(posedCenter, posedExtent), Vector3Add(posedCenter, posedExtent)};
+
+  /* Radius grows by largest stretch of transform (square root of largest
+     eigenvalue of MT*M, bounded by its largest absolute row sum). Exact
+     for rotation with uniform scale, column lengths are not an upper bound
+     under non uniform scale. */
+  float c[3][3] = {{m.m0, m.m1, m.m2}, {m.m4, m.m5, m.m6}, {m.m8, m.m9, m.m10}};
+  float stretchSqr = 0.0f;
+  for (int i = 0; i < 3; i++) {
+    float row = 0.0f;
+    for (int j = 0; j < 3; j++) {
+      row += fabsf(c[i][0] * c[j][0] + c[i][1] * c[j][1] + c[i][2] * c[j][2]);
+    }
+    stretchSqr = fmaxf(stretchSqr, row);
+  }
+
+  out.center = Vector3Transform(poseBounds.center, m);
+  out.radius = poseBounds.radius * sqrtf(stretchSqr);
+
+  return out;
+}
+
+// Bounds enclosing both `a` and `b` (sphere encloses both spheres).
+PoseBounds PoseBoundsMerge(PoseBounds a, PoseBounds b) {
+  PoseBounds out = {0};
+
+  out.box = (BoundingBox){Vector3Min(a.box.min, b.box.min), Vector3Max(a.box.max, b.box.max)};
+
+  float distance = Vector3Distance(a.center, b.center);
+  if (distance + b.radius <= a.radius) {
+    out.center = a.center;
+    out.radius = a.radius;
+  } else if (distance + a.radius <= b.radius) {
+    out.center = b.center;
+    out.radius = b.radius;
+  } else {
+    out.radius = 0.5f * (distance + a.radius + b.radius);
+    out.center = Vector3Add(a.center, Vector3Scale(Vector3Subtract(b.center, a.center), (out.radius - a.radius) / distance));
+  }
+
+  return out;
+}
+
+/* Bounds of every frame of `clip` (global pose of frame, converted with
+   `hierarchy` if clip has local frames only). Baked once, so culling a
+   character playing a clip needs no pose at all. */
+PoseBounds *LoadAnimationClipBounds(SkeletonBounds *bounds, AnimationClip clip,
+                                    SkeletonHierarchy *hierarchy) {
+  if (!AnimationClipIsValid(clip) || (clip.flags & CLIP_ADDITIVE) || clip.boneCount != bounds->boneCount) {
+    TraceLog(LOG_WARNING, "BOUNDS: Can not bake bounds of clip \"%s\"", clip.name);
+    return NULL;
+  }
+
+  PoseBounds *clipBounds = malloc(clip.frameCount * sizeof(PoseBounds));
+  Pose temp = (clip.globalFrames) ? NULL : InitPose(clip.boneCount);
+  BoneBounds *posed = malloc(bounds->boneCount * sizeof(BoneBounds));
+
+  for (int frame = 0; frame < clip.frameCount; frame++) {
+    Pose globalPose = AnimationClipResolvePose(clip, frame, CLIP_GLOBAL_POSE, hierarchy, temp);
+    clipBounds[frame] = GetPoseBoundsScratch(bounds, globalPose, posed);
+  }
+
+  free(posed);
+  if (temp) {
+    UnloadPose(temp);
+  }
+
+  return clipBounds;
+}
+
+void UnloadAnimationClipBounds(PoseBounds *clipBounds) {
+  free(clipBounds);
+}
+
+// Bounds at `seconds` enclosing both frames blended there (see `AnimationClipSamplePoseInto()`).
+PoseBounds AnimationClipSampleBounds(PoseBounds *clipBounds, AnimationClip clip,
+                                     float seconds, int mode) {
+  int frameA, frameB;
+  AnimationClipTimeToFrames(clip, seconds, mode, &frameA, &frameB);
+
+  if (frameA == frameB) {
+    return clipBounds[frameA];
+  }
+
+  return PoseBoundsMerge(clipBounds[frameA], clipBounds[frameB]);
+}
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef __KIRAN_RAY_BONE_INDEX__
+#define __KIRAN_RAY_BONE_INDEX__
+
+#include <raylib.h>
+#include <regex.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bone_mask.h"
+#include "skeleton_hierarchy.h"
+
+#define BONE_INDEX_PATTERN_CACHE 16 // Patterns whose matches are kept per index
+
+// Bone mask rule flags
+#define BONE_RULE_BONES (1 << 0)           // Rule sets matching bones
+#define BONE_RULE_CHILDREN (1 << 1)        // Rule sets whole subtree below matching bones (all descendants)
+#define BONE_RULE_REGEX (1 << 2)           // `pattern` is an extended regex (else exact bone name)
+#define BONE_RULE_DIRECT_CHILDREN (1 << 3) // Rule sets bones whose parent matches (children only)
+
+typedef struct BonePatternMatches {
+  char *pattern;          // Copy of pattern (NULL for free slot)
+  unsigned char *matches; // Per bone: 1 if bone name matches pattern
+} BonePatternMatches;
+
+/* Per skeleton lookup tables for building masks at setup.
+
+   Bone names are hashed (name -> id in O(1)) and every regex pattern used
+   is compiled and run over bone names once. Its per bone matches are kept
+   (last `BONE_INDEX_PATTERN_CACHE` patterns), so masks built again from
+   same patterns do no regex work. Descendants come from subtree ranges of
+   hierarchy instead of walking ancestor chains.
+
+   Matches are logged with LOG_DEBUG only (see `SetTraceLogLevel()`). */
+typedef struct BoneIndex {
+  int boneCount;               // Number of bones
+  BoneInfo *bones;             // Bones of skeleton (not owned)
+  SkeletonHierarchy hierarchy; // Hierarchy of skeleton (not owned)
+
+  int slotCount;               // Size of hash table (power of two)
+  int *slots;                  // Bone id per slot (-1 if free)
+
+  BonePatternMatches patterns[BONE_INDEX_PATTERN_CACHE];
+  int nextPattern;             // Slot replaced when cache is full
+} BoneIndex;
+
+/* One step of `BuildBoneMasks()`. Sets `value` to bones selected by
+   `pattern` and `flags` in mask `maskIndex`. Same as calling mask
+   functions one after another in rule order: `BONE_RULE_BONES` as
+   `MaskBonesByRegex()`, `BONE_RULE_DIRECT_CHILDREN` as
+   `MaskChildBonesByParentRegex()` and `BONE_RULE_CHILDREN` as
+   `MaskDescendantBonesByParentRegexHierarchy()` (whole subtree). */
+typedef struct BoneMaskRule {
+  int maskIndex;       // Index of mask in masks passed
+  const char *pattern; // Bone name or regex (BONE_RULE_REGEX)
+  int flags;           // BONE_RULE_BONES, BONE_RULE_CHILDREN, BONE_RULE_DIRECT_CHILDREN, BONE_RULE_REGEX
+  float value;         // Weight set
+} BoneMaskRule;
+
+BoneIndex LoadBoneIndex(BoneInfo *bones, SkeletonHierarchy hierarchy);
+void UnloadBoneIndex(BoneIndex *index);
+int BoneIndexFind(BoneIndex *index, const char *name);
+unsigned char *BoneIndexMatchPattern(BoneIndex *index, const char *pattern);
+
+void MaskBoneChildIndexed(BoneMask mask, BoneIndex *index, const char *name, float value);
+void BuildBoneMasks(BoneIndex *index, BoneMaskRule *rules, int ruleCount, BoneMask *masks);
+
+// FNV-1a hash of bone name.
+unsigned int BoneNameHash(const char *name) {
+  unsigned int hash = 2166136261u;
+
+  for (int i = 0; i < 32 && name[i] != '\0'; i++) {
+    hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+  }
+
+  return hash;
+}
+
+BoneIndex LoadBoneIndex(BoneInfo *bones, SkeletonHierarchy hierarchy) {
+  BoneIndex index = {0};
+
+  index.boneCount = hierarchy.boneCount;
+  index.bones = bones;
+  index.hierarchy = hierarchy;
+
+  // At most half full
+  index.slotCount = 16;
+  while (index.slotCount < 2 * index.boneCount) {
+    index.slotCount *= 2;
+  }
+
+  index.slots = malloc(index.slotCount * sizeof(int));
+  for (int i = 0; i < index.slotCount; i++) {
+    index.slots[i] = -1;
+  }
+
+  // First bone of a name is kept for duplicate names
+  for (int boneId = 0; boneId < index.boneCount; boneId++) {
+    unsigned int slot = BoneNameHash(bones[boneId].name) & (index.slotCount - 1);
+
+    while (index.slots[slot] != -1 && strncmp(bones[index.slots[slot]].name, bones[boneId].name, 32) != 0) {
+      slot = (slot + 1) & (index.slotCount - 1);
+    }
+    if (index.slots[slot] == -1) {
+      index.slots[slot] = boneId;
+    }
+  }
+
+  return index;
+}
+
+void UnloadBoneIndex(BoneIndex *index) {
+  for (int i = 0; i < BONE_INDEX_PATTERN_CACHE; i++) {
+    free(index->patterns[i].pattern);
+    free(index->patterns[i].matches);
+  }
+  free(index->slots);
+
+  *index = (BoneIndex){0};
+}
+
+// Id of bone named `name` (-1 if not found).
+int BoneIndexFind(BoneIndex *index, const char *name) {
+  unsigned int slot = BoneNameHash(name) & (index->slotCount - 1);
+
+  while (index->slots[slot] != -1) {
+    if (strncmp(index->bones[index->slots[slot]].name, name, 32) == 0) {
+      return index->slots[slot];
+    }
+    slot = (slot + 1) & (index->slotCount - 1);
+  }
+
+  return -1;
+}
+
+/* Per bone matches of extended regex `pattern` (owned by index). Valid
+   till pattern is evicted from cache, which any later call with a pattern
+   not in cache can do (oldest slot is reused in place). Copy matches to
+   keep them across such calls. NULL if pattern does not compile. */
+unsigned char *BoneIndexMatchPattern(BoneIndex *index, const char *pattern) {
+  for (int i = 0; i < BONE_INDEX_PATTERN_CACHE; i++) {
+    if (index->patterns[i].pattern && strcmp(index->patterns[i].pattern, pattern) == 0) {
+      return index->patterns[i].matches;
+    }
+  }
+
+  regex_t regex;
+  if (regcomp(&regex, pattern, REG_EXTENDED | REG_NOSUB)) {
+    TraceLog(LOG_WARNING, "BONE INDEX: Could not compile regex \"%s\"", pattern);
+    return NULL;
+  }
+
+  BonePatternMatches *entry = &index->patterns[index->nextPattern];
+  index->nextPattern = (index->nextPattern + 1) % BONE_INDEX_PATTERN_CACHE;
+
+  free(entry->pattern);
+  entry->pattern = malloc(strlen(pattern) + 1);
+  strcpy(entry->pattern, pattern);
+  if (entry->matches == NULL) {
+    entry->matches = malloc((index->boneCount > 0) ? index->boneCount : 1);
+  }
+
+  for (int boneId = 0; boneId < index->boneCount; boneId++) {
+    entry->matches[boneId] = (regexec(&regex, index->bones[boneId].name, 0, NULL, 0) == 0);
+    if (entry->matches[boneId]) {
+      TraceLog(LOG_DEBUG, "BONE INDEX: Bone \"%s\" (ID: %d) matches \"%s\"", index->bones[boneId].name, boneId, pattern);
+    }
+  }
+
+  regfree(&regex);
+
+  return entry->matches;
+}
+
+// Same as `MaskBoneChild()` (descendants of first bone named `name`).
+void MaskBoneChildIndexed(BoneMask mask, BoneIndex *index, const char *name, float value) {
+  int boneId = BoneIndexFind(index, name);
+
+  if (boneId == -1) {
+    TraceLog(LOG_DEBUG, "BONE INDEX: No bone named \"%s\"", name);
+    return;
+  }
+
+  MaskBoneSubtree(mask, &index->hierarchy, boneId, value, 0);
+}
+
+/* Applies all `rules` to `masks` (allocated by caller, e.g.
+   `BoneMaskZeros()`) in one pass over hierarchy. Name rules use hash
+   lookup and regex rules use cached matches. */
+void BuildBoneMasks(BoneIndex *index, BoneMaskRule *rules, int ruleCount, BoneMask *masks) {
+  int boneCount = index->boneCount;
+
+  // Per rule: matches (regex) or matching bone (name), and per bone "has matching ancestor"
+  unsigned char **matches = calloc(ruleCount, sizeof(unsigned char *));
+  int *matchIds = malloc(ruleCount * sizeof(int));
+  unsigned char *inside = calloc((size_t)ruleCount * boneCount + 1, 1);
+
+  // Matches are copied, a later rule with a new pattern can reuse cache slot of an earlier rule
+  unsigned char *matchCopies = malloc((size_t)ruleCount * boneCount + 1);
+
+  for (int r = 0; r < ruleCount; r++) {
+    matchIds[r] = -1;
+
+    if (rules[r].flags & BONE_RULE_REGEX) {
+      unsigned char *match = BoneIndexMatchPattern(index, rules[r].pattern);
+
+      if (match) {
+        matches[r] = matchCopies + (size_t)r * boneCount;
+        memcpy(matches[r], match, boneCount);
+      }
+    } else {
+      matchIds[r] = BoneIndexFind(index, rules[r].pattern);
+      if (matchIds[r] == -1) {
+        TraceLog(LOG_DEBUG, "BONE INDEX: No bone named \"%s\"", rules[r].pattern);
+      }
+    }
+  }
+
+  for (int i = 0; i < boneCount; i++) {
+    int boneId = index->hierarchy.order[i];
+    int parentId = index->hierarchy.parents[boneId];
+
+    for (int r = 0; r < ruleCount; r++) {
+      unsigned char *ruleInside = inside + (size_t)r * boneCount;
+      int match = (matches[r]) ? matches[r][boneId] : (boneId == matchIds[r]);
+      int below = (parentId != -1) && ruleInside[parentId];
+      int parentMatch = (parentId != -1) && ((matches[r]) ? matches[r][parentId] : (parentId == matchIds[r]));
+
+      ruleInside[boneId] = match || below;
+
+      if (((rules[r].flags & BONE_RULE_BONES) && match) || ((rules[r].flags & BONE_RULE_CHILDREN) && below) ||
+          ((rules[r].flags & BONE_RULE_DIRECT_CHILDREN) && parentMatch)) {
+        masks[rules[r].maskIndex][boneId] = rules[r].value;
+      }
+    }
+  }
+
+  free(matchCopies);
+  free(inside);
+  free(matchIds);
+  free(matches);
+}
+
+#endif
@@ -2,11 +2,14 @@
 #define __KIRAN_RAY_BONE_MASK__
 
 #include <raylib.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <regex.h>
 
+#include "skeleton_hierarchy.h"
+
 typedef float* BoneMask;
 
 BoneMask BoneMaskZeros(int boneCount);
@@ -17,10 +20,55 @@ void MaskBoneChild(BoneMask mask, BoneInfo *bones, char * name, float value, int
 void MaskBonesByRegex(BoneMask mask, BoneInfo *bones, char *pattern, float value, int boneCount);
 void MaskChildBonesByParentRegex(BoneMask mask, BoneInfo *bones, char *pattern, float value, int boneCount);
 
+/* Same as above using compiled hierarchy. `MaskBoneChildHierarchy()`
+   masks subtree range of each matching bone (all descendants, not the bone
+   itself) in one linear pass instead of walking parent chain of every bone.
+   `MaskChildBonesByParentRegexHierarchy()` masks direct children of
+   matching bones (like `MaskChildBonesByParentRegex()`), and
+   `MaskDescendantBonesByParentRegexHierarchy()` masks all descendants. */
+void MaskBoneSubtree(BoneMask mask, SkeletonHierarchy *hierarchy, int boneId, float value, int includeBone);
+void MaskBoneChildHierarchy(BoneMask mask, BoneInfo *bones, SkeletonHierarchy *hierarchy, char *name, float value);
+void MaskChildBonesByParentRegexHierarchy(BoneMask mask, BoneInfo *bones, SkeletonHierarchy *hierarchy, char *pattern, float value);
+void MaskDescendantBonesByParentRegexHierarchy(BoneMask mask, BoneInfo *bones, SkeletonHierarchy *hierarchy, char *pattern, float value);
+
 BoneMask CopyBoneMask(BoneMask mask, int boneCount);
 void BoneMaskInvert(BoneMask mask, int boneCount);
 void UnloadBoneMask(BoneMask mask);
 
+#define BONE_MASK_EMPTY 0    // All weights are zero
+#define BONE_MASK_FULL 1     // All weights are one
+#define BONE_MASK_BINARY 2   // Weights are zero or one
+#define BONE_MASK_WEIGHTED 3 // Any weights
+
+#define BONE_MASK_WEIGHT_ONE 65535 // Quantized weight of one
+
+/* Sparse form of a `BoneMask`. Blends using it (see
+   `PoseOverrideBlendCompiledInto()`) only touch bones with non zero weight,
+   so a mask covering a few bones costs a few bones. Empty and full masks
+   take fast paths (no blend / unmasked blend) and binary masks need no
+   weights.
+
+   Weights are quantized against largest weight of mask (`weightScale`),
+   so weights above one (e.g. 1.5 on an additive layer) blend as they do
+   with the dense mask. Negative weights are not kept (clamped to zero
+   with a warning).
+
+   Compiled from a dense mask once (when masks are built) and does not
+   follow later changes of it. */
+typedef struct CompiledBoneMask {
+  int type;                // BONE_MASK_EMPTY, BONE_MASK_FULL, BONE_MASK_BINARY or BONE_MASK_WEIGHTED
+  int boneCount;           // Number of bones of skeleton
+  int count;               // Number of bones with non zero weight
+  int *bones;              // Bones with non zero weight (ascending)
+  unsigned short *weights; // Weights of `bones` quantized to BONE_MASK_WEIGHT_ONE (weighted masks only, else NULL)
+  float weightScale;       // Weight of quantized BONE_MASK_WEIGHT_ONE (largest weight, 1 if not weighted)
+  unsigned int *bits;      // Bitset of bones with non zero weight
+} CompiledBoneMask;
+
+CompiledBoneMask LoadCompiledBoneMask(BoneMask mask, int boneCount);
+void UnloadCompiledBoneMask(CompiledBoneMask mask);
+int CompiledBoneMaskHasBone(CompiledBoneMask *mask, int boneId);
+
 BoneMask BoneMaskZeros(int boneCount) {
   BoneMask mask = malloc(boneCount * sizeof(float));
 
@@ -51,75 +99,138 @@ BoneMask BoneMaskHalf(int boneCount) {
   return mask;
 }
 
+// Name of every bone is compared once, ancestor chains are walked on flags.
 void MaskBoneChild(BoneMask mask, BoneInfo *bones, char * name, float value, int boneCount) {
-    for (int boneId = 0; boneId < boneCount; boneId++) {
-        int currentBoneId = boneId;
-        while (bones[currentBoneId].parent != -1) {
-            if (strcmp(bones[bones[currentBoneId].parent].name, name) == 0) {
-                mask[boneId] = value;
-                break;
-            }
-            currentBoneId = bones[currentBoneId].parent;
-        }
+  unsigned char *named = malloc(boneCount + 1);
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    named[boneId] = (strcmp(bones[boneId].name, name) == 0);
+  }
+
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    for (int parentId = bones[boneId].parent; parentId != -1; parentId = bones[parentId].parent) {
+      if (named[parentId]) {
+        mask[boneId] = value;
+        break;
+      }
     }
+  }
+
+  free(named);
 }
 
+/* Matches are logged with LOG_DEBUG (quiet by default). For many masks of
+   one skeleton see `BuildBoneMasks()` in bone_index.h. */
 void MaskBonesByRegex(BoneMask mask, BoneInfo *bones, char *pattern, float value, int boneCount) {
-    regex_t regex;
-    int ret;
-
-    ret = regcomp(&regex, pattern, REG_EXTENDED);
-    if (ret) {
-        printf("Could not compile regex\n");
-        free(mask);
-        return;
-    }
+  regex_t regex;
+
+  if (regcomp(&regex, pattern, REG_EXTENDED | REG_NOSUB)) {
+    TraceLog(LOG_WARNING, "BONE MASK: Could not compile regex \"%s\"", pattern);
+    return;
+  }
 
-    for (int i = 0; i < boneCount; i++) {
-        ret = regexec(&regex, bones[i].name, 0, NULL, 0);
-        if (ret == 0) {
-            mask[i] = value;
-            printf("Bone \"%s\" matches the pattern.\n", bones[i].name);
-        }
+  for (int i = 0; i < boneCount; i++) {
+    if (regexec(&regex, bones[i].name, 0, NULL, 0) == 0) {
+      mask[i] = value;
+      TraceLog(LOG_DEBUG, "BONE MASK: Bone \"%s\" matches the pattern", bones[i].name);
     }
+  }
 
-    regfree(&regex);
+  regfree(&regex);
 }
 
+/* Masks direct children of bones matching `pattern` (deeper descendants
+   are not masked). Regex runs once per bone. */
 void MaskChildBonesByParentRegex(BoneMask mask, BoneInfo *bones, char *pattern, float value, int boneCount) {
-    regex_t regex;
-    int ret;
+  regex_t regex;
 
-    for (int i = 0; i < boneCount; i++) {
-        mask[i] = 0.0f;
+  for (int i = 0; i < boneCount; i++) {
+    mask[i] = 0.0f;
+  }
+
+  if (regcomp(&regex, pattern, REG_EXTENDED | REG_NOSUB)) {
+    TraceLog(LOG_WARNING, "BONE MASK: Could not compile regex \"%s\"", pattern);
+    return;
+  }
+
+  unsigned char *matches = malloc(boneCount + 1);
+  for (int i = 0; i < boneCount; i++) {
+    matches[i] = (regexec(&regex, bones[i].name, 0, NULL, 0) == 0);
+  }
+  regfree(&regex);
+
+  for (int i = 0; i < boneCount; i++) {
+    int parentBoneId = bones[i].parent;
+
+    if (parentBoneId != -1 && matches[parentBoneId]) {
+      mask[i] = value;
+      TraceLog(LOG_DEBUG, "BONE MASK: Bone \"%s\" (ID: %d) is a child of bone \"%s\" (ID: %d) which matches the pattern",
+               bones[i].name, i, bones[parentBoneId].name, parentBoneId);
     }
+  }
 
-    ret = regcomp(&regex, pattern, REG_EXTENDED);
-    if (ret) {
-        printf("Could not compile regex\n");
-        free(mask);
-        return;
+  free(matches);
+}
+
+void MaskBoneSubtree(BoneMask mask, SkeletonHierarchy *hierarchy, int boneId, float value, int includeBone) {
+  int start = hierarchy->orderIndex[boneId] + ((includeBone) ? 0 : 1);
+  int end = hierarchy->orderIndex[boneId] + hierarchy->subtreeSize[boneId];
+
+  for (int i = start; i < end; i++) {
+    mask[hierarchy->order[i]] = value;
+  }
+}
+
+void MaskBoneChildHierarchy(BoneMask mask, BoneInfo *bones, SkeletonHierarchy *hierarchy, char *name, float value) {
+  for (int boneId = 0; boneId < hierarchy->boneCount; boneId++) {
+    if (strcmp(bones[boneId].name, name) == 0) {
+      MaskBoneSubtree(mask, hierarchy, boneId, value, 0);
     }
+  }
+}
 
-    for (int i = 0; i < boneCount; i++) {
-        int currentBoneId = i;
-        while (bones[currentBoneId].parent != -1) {
-            int parentBoneId = bones[currentBoneId].parent;
-
-            ret = regexec(&regex, bones[parentBoneId].name, 0, NULL, 0);
-            if (ret == 0) {
-                mask[currentBoneId] = value;
-                printf("Bone \"%s\" (ID: %d) is a child of bone \"%s\" (ID: %d) which matches the pattern.\n",
-                       bones[currentBoneId].name, currentBoneId, bones[parentBoneId].name, parentBoneId);
-                break;
-            }
-            currentBoneId = parentBoneId;
-        }
+void MaskChildBonesByParentRegexHierarchy(BoneMask mask, BoneInfo *bones, SkeletonHierarchy *hierarchy, char *pattern, float value) {
+  regex_t regex;
+
+  for (int i = 0; i < hierarchy->boneCount; i++) {
+    mask[i] = 0.0f;
+  }
+
+  if (regcomp(&regex, pattern, REG_EXTENDED | REG_NOSUB)) {
+    TraceLog(LOG_WARNING, "BONE MASK: Could not compile regex \"%s\"", pattern);
+    return;
+  }
+
+  for (int boneId = 0; boneId < hierarchy->boneCount; boneId++) {
+    if (regexec(&regex, bones[boneId].name, 0, NULL, 0) == 0) {
+      for (int c = hierarchy->childStart[boneId]; c < hierarchy->childStart[boneId + 1]; c++) {
+        mask[hierarchy->children[c]] = value;
+      }
     }
+  }
 
-    regfree(&regex);
+  regfree(&regex);
 }
 
+void MaskDescendantBonesByParentRegexHierarchy(BoneMask mask, BoneInfo *bones, SkeletonHierarchy *hierarchy, char *pattern, float value) {
+  regex_t regex;
+
+  for (int i = 0; i < hierarchy->boneCount; i++) {
+    mask[i] = 0.0f;
+  }
+
+  if (regcomp(&regex, pattern, REG_EXTENDED | REG_NOSUB)) {
+    TraceLog(LOG_WARNING, "BONE MASK: Could not compile regex \"%s\"", pattern);
+    return;
+  }
+
+  for (int boneId = 0; boneId < hierarchy->boneCount; boneId++) {
+    if (regexec(&regex, bones[boneId].name, 0, NULL, 0) == 0) {
+      MaskBoneSubtree(mask, hierarchy, boneId, value, 0);
+    }
+  }
+
+  regfree(&regex);
+}
 
 BoneMask CopyBoneMask(BoneMask mask, int boneCount) {
   BoneMask newMask = BoneMaskZeros(boneCount);
@@ -143,4 +254,70 @@ void UnloadBoneMask(BoneMask mask) {
   }
 }
 
+// `NULL` mask compiles to full mask. Bitset and lists in one allocation.
+CompiledBoneMask LoadCompiledBoneMask(BoneMask mask, int boneCount) {
+  CompiledBoneMask compiled = {0};
+  int wordCount = (boneCount + 31) / 32;
+  int count = 0, binary = 1, negative = 0;
+  float maxWeight = 0.0f;
+
+  for (int i = 0; i < boneCount; i++) {
+    float weight = (mask) ? mask[i] : 1.0f;
+
+    if (weight != 0.0f) {
+      count++;
+      binary = binary && (weight == 1.0f);
+      negative = negative || (weight < 0.0f);
+      maxWeight = fmaxf(maxWeight, weight);
+    }
+  }
+
+  if (negative) {
+    TraceLog(LOG_WARNING, "BONE MASK: Negative weights of compiled mask clamped to zero");
+  }
+
+  size_t size = wordCount * sizeof(unsigned int) + count * sizeof(int) + ((binary) ? 0 : count * sizeof(unsigned short));
+  compiled.bits = calloc(1, (size > 0) ? size : 1);
+  if (compiled.bits == NULL) {
+    TraceLog(LOG_WARNING, "BONE MASK: Failed to allocate compiled mask");
+    return compiled;
+  }
+
+  compiled.boneCount = boneCount;
+  compiled.weightScale = (!binary && maxWeight > 0.0f) ? maxWeight : 1.0f;
+  compiled.bones = (int *)(compiled.bits + wordCount);
+  compiled.weights = (binary) ? NULL : (unsigned short *)(compiled.bones + count);
+
+  for (int i = 0; i < boneCount; i++) {
+    float weight = (mask) ? mask[i] : 1.0f;
+
+    if (weight != 0.0f) {
+      if (compiled.weights) {
+        weight = (weight < 0.0f) ? 0.0f : fminf(weight / compiled.weightScale, 1.0f);
+        compiled.weights[compiled.count] = (unsigned short)(weight * BONE_MASK_WEIGHT_ONE + 0.5f);
+      }
+      compiled.bones[compiled.count++] = i;
+      compiled.bits[i / 32] |= 1u << (i % 32);
+    }
+  }
+
+  if (count == 0) {
+    compiled.type = BONE_MASK_EMPTY;
+  } else if (binary && count == boneCount) {
+    compiled.type = BONE_MASK_FULL;
+  } else {
+    compiled.type = (binary) ? BONE_MASK_BINARY : BONE_MASK_WEIGHTED;
+  }
+
+  return compiled;
+}
+
+void UnloadCompiledBoneMask(CompiledBoneMask mask) {
+  free(mask.bits);
+}
+
+int CompiledBoneMaskHasBone(CompiledBoneMask *mask, int boneId) {
+  return (mask->bits[boneId / 32] >> (boneId % 32)) & 1u;
+}
+
 #endif
@@ -0,0 +1,346 @@
+#ifndef __KIRAN_RAY_CPU_SKINNING__
+#define __KIRAN_RAY_CPU_SKINNING__
+
+#include <raylib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "job_system.h"
+#include "pose_simd.h"
+
+#define CPU_SKIN_MAX_INFLUENCES 4 // Influences per vertex in raylib meshes
+#define CPU_SKIN_GRAIN 2048       // Vertices per job when skinning on threads
+#define CPU_SKIN_BONE_FLOATS 28   // Per bone: 4 position columns and 3 normal columns (4 floats each)
+
+#if defined(KANIM_SIMD_AVX2) || defined(KANIM_SIMD_SSE4)
+#define CPU_SKIN_SSE
+#endif
+
+/* Skinning of mesh vertices on CPU (servers without GPU, hit detection,
+   baking). Result is same as `skinning-lighting.vs.glsl`: positions are
+   weighted sum of bone matrices applied to bind position and normals are
+   weighted sum of inverse transpose of bone matrices applied to bind
+   normal (normalized).
+
+   At load, influences with zero weight are dropped and vertices are
+   sorted by influence count (stable), so every group runs a loop with
+   fixed count. Bind positions/normals and influences are stored in that
+   order, packed per group. Vertices without influence keep their bind
+   position and normal.
+
+   Blend is done 4 floats at a time (SSE, when compiled with `-msse4.1`,
+   `-mavx2` or `-march=native`, see pose_simd.h). Large meshes are split
+   across threads of a `JobSystem`. Output is written in vertex order of
+   mesh (same layout as `mesh.vertices`/`mesh.normals`). */
+typedef struct CpuSkin {
+  int vertexCount;            // Number of vertices of mesh
+  int boneCount;              // Number of bones palette must have
+  int groupStart[CPU_SKIN_MAX_INFLUENCES + 2];  // First sorted vertex of each influence count (0 to 4, last is `vertexCount`)
+  int groupOffset[CPU_SKIN_MAX_INFLUENCES + 1]; // First influence of each group
+
+  int *vertices;              // Mesh vertex of every sorted vertex
+  float *positions;           // Bind positions (x, y, z, 1) in sorted order
+  float *normals;             // Bind normals (x, y, z, 0) in sorted order (NULL if mesh has none)
+  unsigned short *bones;      // Bone of every influence
+  float *weights;             // Weight of every influence
+
+  float *boneColumns;         // Palette converted for skinning (`CPU_SKIN_BONE_FLOATS` per bone)
+} CpuSkin;
+
+typedef struct CpuSkinJob {
+  CpuSkin *skin;
+  float *positions;
+  float *normals;
+} CpuSkinJob;
+
+CpuSkin LoadCpuSkin(Mesh mesh, int boneCount);
+void UnloadCpuSkin(CpuSkin *skin);
+void CpuSkinSetPalette(CpuSkin *skin, Matrix *palette);
+void CpuSkinVertices(CpuSkin *skin, int begin, int end, float *positions, float *normals);
+void SkinMeshCpu(CpuSkin *skin, Matrix *palette, float *positions, float *normals, JobSystem *jobs);
+
+/* Streams of `mesh` (needs `vertices`, `boneIds` and `boneWeights`).
+   `boneCount` is size of palettes used (0 to use `mesh.boneCount`).
+   Influences of bones out of range are dropped. */
+CpuSkin LoadCpuSkin(Mesh mesh, int boneCount) {
+  CpuSkin skin = {0};
+
+  if (boneCount <= 0) {
+    boneCount = mesh.boneCount;
+  }
+
+  if (mesh.vertices == NULL || mesh.boneIds == NULL || mesh.boneWeights == NULL || boneCount <= 0) {
+    TraceLog(LOG_WARNING, "CPU SKIN: Mesh has no vertices, bone ids or bone weights");
+    return skin;
+  }
+
+  skin.vertexCount = mesh.vertexCount;
+  skin.boneCount = boneCount;
+
+  // Influence count of every vertex and size of every group
+  unsigned char *counts = malloc(mesh.vertexCount + 1);
+  int groupCounts[CPU_SKIN_MAX_INFLUENCES + 1] = {0};
+
+  for (int v = 0; v < mesh.vertexCount; v++) {
+    int count = 0;
+    for (int j = 0; j < CPU_SKIN_MAX_INFLUENCES; j++) {
+      if (mesh.boneWeights[4 * v + j] != 0.0f && mesh.boneIds[4 * v + j] < boneCount) {
+        count++;
+      }
+    }
+    counts[v] = (unsigned char)count;
+    groupCounts[count]++;
+  }
+
+  int influenceCount = 0;
+  for (int k = 0; k <= CPU_SKIN_MAX_INFLUENCES; k++) {
+    skin.groupStart[k + 1] = skin.groupStart[k] + groupCounts[k];
+    skin.groupOffset[k] = influenceCount;
+    influenceCount += k * groupCounts[k];
+  }
+
+  skin.vertices = malloc((mesh.vertexCount + 1) * sizeof(int));
+  skin.positions = malloc((4 * mesh.vertexCount + 4) * sizeof(float));
+  skin.bones = malloc((influenceCount + 1) * sizeof(unsigned short));
+  skin.weights = malloc((influenceCount + 1) * sizeof(float));
+  skin.boneColumns = calloc(boneCount * CPU_SKIN_BONE_FLOATS, sizeof(float));
+  if (mesh.normals) {
+    skin.normals = malloc((4 * mesh.vertexCount + 4) * sizeof(float));
+  }
+
+  int next[CPU_SKIN_MAX_INFLUENCES + 1];
+  for (int k = 0; k <= CPU_SKIN_MAX_INFLUENCES; k++) {
+    next[k] = skin.groupStart[k];
+  }
+
+  for (int v = 0; v < mesh.vertexCount; v++) {
+    int k = counts[v];
+    int slot = next[k]++;
+    int influence = skin.groupOffset[k] + (slot - skin.groupStart[k]) * k;
+
+    skin.vertices[slot] = v;
+    skin.positions[4 * slot + 0] = mesh.vertices[3 * v + 0];
+    skin.positions[4 * slot + 1] = mesh.vertices[3 * v + 1];
+    skin.positions[4 * slot + 2] = mesh.vertices[3 * v + 2];
+    skin.positions[4 * slot + 3] = 1.0f;
+
+    if (skin.normals) {
+      skin.normals[4 * slot + 0] = mesh.normals[3 * v + 0];
+      skin.normals[4 * slot + 1] = mesh.normals[3 * v + 1];
+      skin.normals[4 * slot + 2] = mesh.normals[3 * v + 2];
+      skin.normals[4 * slot + 3] = 0.0f;
+    }
+
+    for (int j = 0; j < CPU_SKIN_MAX_INFLUENCES; j++) {
+      if (mesh.boneWeights[4 * v + j] != 0.0f && mesh.boneIds[4 * v + j] < boneCount) {
+        skin.bones[influence] = mesh.boneIds[4 * v + j];
+        skin.weights[influence] = mesh.boneWeights[4 * v + j];
+        influence++;
+      }
+    }
+  }
+
+  free(counts);
+
+  return skin;
+}
+
+void UnloadCpuSkin(CpuSkin *skin) {
+  free(skin->vertices);
+  free(skin->positions);
+  free(skin->normals);
+  free(skin->bones);
+  free(skin->weights);
+  free(skin->boneColumns);
+
+  *skin = (CpuSkin){0};
+}
+
+/* Converts `palette` (`skin->boneCount` matrices, e.g. `mesh.boneMatrices`
+   after `UpdateModelMeshFromPose()`) to columns used by skinning. Normal
+   matrix is inverse transpose of 3x3 part (columns are cross products of
+   matrix columns over determinant). */
+void CpuSkinSetPalette(CpuSkin *skin, Matrix *palette) {
+  for (int b = 0; b < skin->boneCount; b++) {
+    Matrix m = palette[b];
+    float *c = skin->boneColumns + b * CPU_SKIN_BONE_FLOATS;
+
+    Vector3 c0 = {m.m0, m.m1, m.m2};
+    Vector3 c1 = {m.m4, m.m5, m.m6};
+    Vector3 c2 = {m.m8, m.m9, m.m10};
+
+    Vector3 n0 = Vector3CrossProduct(c1, c2);
+    Vector3 n1 = Vector3CrossProduct(c2, c0);
+    Vector3 n2 = Vector3CrossProduct(c0, c1);
+
+    float det = Vector3DotProduct(c0, n0);
+    float invDet = (det != 0.0f) ? 1.0f / det : 1.0f;
+
+    float columns[CPU_SKIN_BONE_FLOATS] = {
+      m.m0, m.m1, m.m2, 0.0f,
+      m.m4, m.m5, m.m6, 0.0f,
+      m.m8, m.m9, m.m10, 0.0f,
+      m.m12, m.m13, m.m14, 0.0f,
+      n0.x * invDet, n0.y * invDet, n0.z * invDet, 0.0f,
+      n1.x * invDet, n1.y * invDet, n1.z * invDet, 0.0f,
+      n2.x * invDet, n2.y * invDet, n2.z * invDet, 0.0f,
+    };
+
+    memcpy(c, columns, sizeof(columns));
+  }
+}
+
+#if defined(CPU_SKIN_SSE)
+
+// Blends columns of `count` influences and skins one vertex.
+void CpuSkinVertex(CpuSkin *skin, int slot, int count, const unsigned short *bones,
+                   const float *weights, float *positions, float *normals) {
+  __m128 c[7];
+
+  const float *columns = skin->boneColumns + bones[0] * CPU_SKIN_BONE_FLOATS;
+  __m128 w = _mm_set1_ps(weights[0]);
+  for (int i = 0; i < 7; i++) {
+    c[i] = _mm_mul_ps(w, _mm_loadu_ps(columns + 4 * i));
+  }
+
+  for (int j = 1; j < count; j++) {
+    columns = skin->boneColumns + bones[j] * CPU_SKIN_BONE_FLOATS;
+    w = _mm_set1_ps(weights[j]);
+    for (int i = 0; i < 7; i++) {
+      c[i] = _mm_add_ps(c[i], _mm_mul_ps(w, _mm_loadu_ps(columns + 4 * i)));
+    }
+  }
+
+  int vertex = skin->vertices[slot];
+  float result[4];
+
+  const float *p = skin->positions + 4 * slot;
+  __m128 position = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0], _mm_set1_ps(p[0])), _mm_mul_ps(c[1], _mm_set1_ps(p[1]))),
+                               _mm_add_ps(_mm_mul_ps(c[2], _mm_set1_ps(p[2])), c[3]));
+  _mm_storeu_ps(result, position);
+  memcpy(positions + 3 * vertex, result, 3 * sizeof(float));
+
+  if (normals && skin->normals) {
+    const float *n = skin->normals + 4 * slot;
+    __m128 normal = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[4], _mm_set1_ps(n[0])), _mm_mul_ps(c[5], _mm_set1_ps(n[1]))),
+                               _mm_mul_ps(c[6], _mm_set1_ps(n[2])));
+    __m128 lengthSqr = _mm_dp_ps(normal, normal, 0x7f);
+    __m128 length = _mm_sqrt_ps(lengthSqr);
+    normal = _mm_and_ps(_mm_div_ps(normal, length), _mm_cmpgt_ps(lengthSqr, _mm_setzero_ps()));
+    _mm_storeu_ps(result, normal);
+    memcpy(normals + 3 * vertex, result, 3 * sizeof(float));
+  }
+}
+
+#else
+
+// Blends columns of `count` influences and skins one vertex.
+void CpuSkinVertex(CpuSkin *skin, int slot, int count, const unsigned short *bones,
+                   const float *weights, float *positions, float *normals) {
+  float c[CPU_SKIN_BONE_FLOATS];
+
+  const float *columns = skin->boneColumns + bones[0] * CPU_SKIN_BONE_FLOATS;
+  for (int i = 0; i < CPU_SKIN_BONE_FLOATS; i++) {
+    c[i] = weights[0] * columns[i];
+  }
+
+  for (int j = 1; j < count; j++) {
+    columns = skin->boneColumns + bones[j] * CPU_SKIN_BONE_FLOATS;
+    for (int i = 0; i < CPU_SKIN_BONE_FLOATS; i++) {
+      c[i] += weights[j] * columns[i];
+    }
+  }
+
+  int vertex = skin->vertices[slot];
+
+  const float *p = skin->positions + 4 * slot;
+  for (int i = 0; i < 3; i++) {
+    positions[3 * vertex + i] = (c[i] * p[0] + c[4 + i] * p[1]) + (c[8 + i] * p[2] + c[12 + i]);
+  }
+
+  if (normals && skin->normals) {
+    const float *n = skin->normals + 4 * slot;
+    float normal[3];
+    for (int i = 0; i < 3; i++) {
+      normal[i] = (c[16 + i] * n[0] + c[20 + i] * n[1]) + c[24 + i] * n[2];
+    }
+
+    float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    float invLength = (length > 0.0f) ? 1.0f / length : 0.0f;
+    for (int i = 0; i < 3; i++) {
+      normals[3 * vertex + i] = normal[i] * invLength;
+    }
+  }
+}
+
+#endif
+
+/* Skins sorted vertices `begin` to `end - 1` with palette set last by
+   `CpuSkinSetPalette()`. Ranges not overlapping can run on different
+   threads. */
+void CpuSkinVertices(CpuSkin *skin, int begin, int end, float *positions, float *normals) {
+  // Vertices without influence
+  for (int slot = begin; slot < end && slot < skin->groupStart[1]; slot++) {
+    int vertex = skin->vertices[slot];
+    memcpy(positions + 3 * vertex, skin->positions + 4 * slot, 3 * sizeof(float));
+    if (normals && skin->normals) {
+      memcpy(normals + 3 * vertex, skin->normals + 4 * slot, 3 * sizeof(float));
+    }
+  }
+
+  for (int k = 1; k <= CPU_SKIN_MAX_INFLUENCES; k++) {
+    int first = (begin > skin->groupStart[k]) ? begin : skin->groupStart[k];
+    int last = (end < skin->groupStart[k + 1]) ? end : skin->groupStart[k + 1];
+
+    const unsigned short *bones = skin->bones + skin->groupOffset[k] + (first - skin->groupStart[k]) * k;
+    const float *weights = skin->weights + skin->groupOffset[k] + (first - skin->groupStart[k]) * k;
+
+    // Constant count per group, so inner loops of every case are unrolled
+    switch (k) {
+    case 1:
+      for (int slot = first; slot < last; slot++, bones += 1, weights += 1) {
+        CpuSkinVertex(skin, slot, 1, bones, weights, positions, normals);
+      }
+      break;
+    case 2:
+      for (int slot = first; slot < last; slot++, bones += 2, weights += 2) {
+        CpuSkinVertex(skin, slot, 2, bones, weights, positions, normals);
+      }
+      break;
+    case 3:
+      for (int slot = first; slot < last; slot++, bones += 3, weights += 3) {
+        CpuSkinVertex(skin, slot, 3, bones, weights, positions, normals);
+      }
+      break;
+    default:
+      for (int slot = first; slot < last; slot++, bones += 4, weights += 4) {
+        CpuSkinVertex(skin, slot, 4, bones, weights, positions, normals);
+      }
+      break;
+    }
+  }
+}
+
+void CpuSkinJobRun(void *data, int begin, int end, int workerId) {
+  CpuSkinJob *job = (CpuSkinJob *)data;
+  (void)workerId;
+
+  CpuSkinVertices(job->skin, begin, end, job->positions, job->normals);
+}
+
+/* Skins all vertices with `palette` into `positions` (3 floats per vertex)
+   and `normals` (can be NULL). Meshes larger than `CPU_SKIN_GRAIN`
+   vertices are split across `jobs` (can be NULL). */
+void SkinMeshCpu(CpuSkin *skin, Matrix *palette, float *positions, float *normals, JobSystem *jobs) {
+  CpuSkinSetPalette(skin, palette);
+
+  if (jobs == NULL || jobs->threadCount <= 1 || skin->vertexCount <= CPU_SKIN_GRAIN) {
+    CpuSkinVertices(skin, 0, skin->vertexCount, positions, normals);
+    return;
+  }
+
+  CpuSkinJob job = {skin, positions, normals};
+  RunJobs(jobs, CpuSkinJobRun, &job, skin->vertexCount, CPU_SKIN_GRAIN);
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "pose.h"
 
+/* Replaces every frame with a newly allocated local pose. Prefer
+   `AnimationClip` with `CLIP_LOCAL_POSE` (one block for all frames). */
 void ModelAnimationToLocalPose(ModelAnimation *anims, int animCount) {
   Pose tempPose;
   for (int animId = 0; animId < animCount; animId ++) {
@@ -14,4 +16,45 @@ void ModelAnimationToLocalPose(ModelAnimation *anims, int animCount) {
   }
 }
 
+/* Flips rotations (q and -q are same rotation) so that every rotation has
+   non negative dot with rotation of same bone in `referencePose` (identity
+   if `referencePose` is NULL).
+
+   Alignment only holds in space it was done in. So, call it after any
+   `ModelAnimationToLocalPose()` and do not use `BLEND_SAME_HEMISPHERE` on
+   poses converted at runtime. */
+void PoseAlignRotations(Pose pose, Pose referencePose, int boneCount) {
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    Quaternion q = pose[boneId].rotation;
+    Quaternion r = (referencePose) ? referencePose[boneId].rotation : QuaternionIdentity();
+
+    if (q.x*r.x + q.y*r.y + q.z*r.z + q.w*r.w < 0.0f) {
+      pose[boneId].rotation = (Quaternion){-q.x, -q.y, -q.z, -q.w};
+    }
+  }
+}
+
+/* Aligns first frame of every animation to `referencePose` (identity if
+   NULL) and each later frame, per bone, to frame before it. So, blends
+   between consecutive frames of a clip can use `BLEND_SAME_HEMISPHERE`.
+
+   Not covered (keep shortest path check there):
+    - last frame into first frame of looping clips (a bone turning a full
+      circle over clip ends flipped)
+    - blends between clips or between distant frames. Two rotations each
+      aligned to reference can still be more than 180 degrees apart in
+      quaternion space (e.g. both more than 90 degrees from it). Only poses
+      staying within 90 degrees of rotation of `referencePose` are safe. */
+void ModelAnimationAlignRotations(ModelAnimation *anims, int animCount, Pose referencePose) {
+  for (int animId = 0; animId < animCount; animId++) {
+    ModelAnimation anim = anims[animId];
+
+    for (int frameId = 0; frameId < anim.frameCount; frameId++) {
+      Pose previous = (frameId == 0) ? referencePose : anim.framePoses[frameId - 1];
+
+      PoseAlignRotations(anim.framePoses[frameId], previous, anim.boneCount);
+    }
+  }
+}
+
 #endif
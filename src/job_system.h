@@ -0,0 +1,357 @@
+#ifndef __KIRAN_RAY_JOB_SYSTEM__
+#define __KIRAN_RAY_JOB_SYSTEM__
+
+#include <raylib.h>
+#include <stdlib.h>
+
+#if defined(_WIN32) && !defined(JOB_SYSTEM_NO_THREADS)
+#define JOB_SYSTEM_NO_THREADS
+#endif
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define JOB_SYSTEM_MAX_THREADS 64
+
+/* Job function. Processes items `begin` to `end - 1` of a batch.
+   `workerId` (0 to `threadCount - 1`) can index per worker scratch memory
+   (e.g. one `PoseArena` per worker). */
+typedef void (*JobFunction)(void *data, int begin, int end, int workerId);
+
+typedef struct JobRange {
+  JobFunction function;
+  void *data;
+  int begin;
+  int end;
+} JobRange;
+
+// Deque of one worker. Owner pops from bottom, other workers steal from top.
+typedef struct JobDeque {
+  JobRange *ranges;
+  int capacity;
+  int top;
+  int bottom;
+
+  int jobsRun;   // Ranges run by owner in last batch
+  int steals;    // Ranges stolen by owner from other deques in last batch
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  pthread_mutex_t mutex;
+#endif
+} JobDeque;
+
+/* Work stealing job system.
+
+   `RunJobs()` splits a batch of `count` independent items into ranges of
+   `grainSize` items, deals them to per worker deques and runs them on all
+   threads (calling thread is worker 0) till batch is done. A worker that
+   runs out of ranges steals from top of other deques.
+
+   Items of a batch must not share mutable state. For characters: each
+   one owns its pose (`Skeleton.pose`) and `LayerStack`, and temporaries
+   come from a per worker `PoseArena` (`Skeleton.arena` set from
+   `workerId` inside job), never from one shared arena.
+
+   Define JOB_SYSTEM_NO_THREADS to run batches on calling thread (default
+   on Windows). */
+typedef struct JobSystem {
+  int threadCount;    // Number of workers (including calling thread)
+  JobDeque deques[JOB_SYSTEM_MAX_THREADS];
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  pthread_t threads[JOB_SYSTEM_MAX_THREADS];
+  pthread_mutex_t mutex;
+  pthread_cond_t wake;  // Signalled when a batch starts (or on quit)
+  pthread_cond_t done;  // Signalled when last range of batch is done
+  int generation;       // Batch counter
+  int pending;          // Ranges of batch not done yet
+  int quit;
+#endif
+} JobSystem;
+
+typedef struct JobWorkerStart {
+  JobSystem *system;
+  int workerId;
+} JobWorkerStart;
+
+int GetCpuCount(void);
+JobSystem *LoadJobSystem(int threadCount);
+void UnloadJobSystem(JobSystem *system);
+void RunJobs(JobSystem *system, JobFunction function, void *data, int count, int grainSize);
+
+int GetCpuCount(void) {
+#if !defined(JOB_SYSTEM_NO_THREADS) && defined(_SC_NPROCESSORS_ONLN)
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return (count > 0) ? (int)count : 1;
+#else
+  return 1;
+#endif
+}
+
+int JobDequePop(JobDeque *deque, JobRange *range) {
+  int found = 0;
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  pthread_mutex_lock(&deque->mutex);
+#endif
+  if (deque->bottom > deque->top) {
+    *range = deque->ranges[--deque->bottom];
+    found = 1;
+  }
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  pthread_mutex_unlock(&deque->mutex);
+#endif
+
+  return found;
+}
+
+int JobDequeSteal(JobDeque *deque, JobRange *range) {
+  int found = 0;
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  pthread_mutex_lock(&deque->mutex);
+#endif
+  if (deque->bottom > deque->top) {
+    *range = deque->ranges[deque->top++];
+    found = 1;
+  }
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  pthread_mutex_unlock(&deque->mutex);
+#endif
+
+  return found;
+}
+
+// Runs ranges of own deque, then stolen ones, till every deque is empty.
+void JobSystemWork(JobSystem *system, int workerId) {
+  JobDeque *own = &system->deques[workerId];
+  JobRange range;
+
+  while (1) {
+    int found = JobDequePop(own, &range);
+    int stolen = 0;
+
+    for (int i = 1; !found && (i < system->threadCount); i++) {
+      found = JobDequeSteal(&system->deques[(workerId + i) % system->threadCount], &range);
+      stolen = found;
+    }
+
+    if (!found) {
+      break;
+    }
+
+    range.function(range.data, range.begin, range.end, workerId);
+
+    // Stats are written under system lock (batch setup resets them under it)
+#if !defined(JOB_SYSTEM_NO_THREADS)
+    pthread_mutex_lock(&system->mutex);
+#endif
+    own->jobsRun++;
+    own->steals += stolen;
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+    if (--system->pending == 0) {
+      pthread_cond_broadcast(&system->done);
+    }
+    pthread_mutex_unlock(&system->mutex);
+#endif
+  }
+}
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+void *JobSystemWorker(void *data) {
+  JobWorkerStart start = *(JobWorkerStart *)data;
+  JobSystem *system = start.system;
+  free(data);
+
+  pthread_mutex_lock(&system->mutex);
+  int generation = system->generation;
+
+  while (1) {
+    while (generation == system->generation && !system->quit) {
+      pthread_cond_wait(&system->wake, &system->mutex);
+    }
+    if (system->quit) {
+      break;
+    }
+    generation = system->generation;
+
+    pthread_mutex_unlock(&system->mutex);
+    JobSystemWork(system, start.workerId);
+    pthread_mutex_lock(&system->mutex);
+  }
+  pthread_mutex_unlock(&system->mutex);
+
+  return NULL;
+}
+#endif
+
+/* Starts `threadCount - 1` worker threads (calling thread is worker 0).
+   0 means one worker per CPU. */
+JobSystem *LoadJobSystem(int threadCount) {
+  if (threadCount <= 0) {
+    threadCount = GetCpuCount();
+  }
+  if (threadCount > JOB_SYSTEM_MAX_THREADS) {
+    threadCount = JOB_SYSTEM_MAX_THREADS;
+  }
+#if defined(JOB_SYSTEM_NO_THREADS)
+  threadCount = 1;
+#endif
+
+  JobSystem *system = calloc(1, sizeof(JobSystem));
+  if (system == NULL) {
+    TraceLog(LOG_WARNING, "JOBS: Failed to allocate job system");
+    return NULL;
+  }
+
+  system->threadCount = threadCount;
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  pthread_mutex_init(&system->mutex, NULL);
+  pthread_cond_init(&system->wake, NULL);
+  pthread_cond_init(&system->done, NULL);
+
+  for (int i = 0; i < threadCount; i++) {
+    pthread_mutex_init(&system->deques[i].mutex, NULL);
+  }
+
+  for (int i = 1; i < threadCount; i++) {
+    JobWorkerStart *start = malloc(sizeof(JobWorkerStart));
+    *start = (JobWorkerStart){system, i};
+
+    if (pthread_create(&system->threads[i], NULL, JobSystemWorker, start) != 0) {
+      TraceLog(LOG_WARNING, "JOBS: Failed to start worker %d, using %d workers", i, i);
+      free(start);
+      system->threadCount = i;
+      break;
+    }
+  }
+#endif
+
+  return system;
+}
+
+void UnloadJobSystem(JobSystem *system) {
+  if (system == NULL) {
+    return;
+  }
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  pthread_mutex_lock(&system->mutex);
+  system->quit = 1;
+  pthread_cond_broadcast(&system->wake);
+  pthread_mutex_unlock(&system->mutex);
+
+  for (int i = 1; i < system->threadCount; i++) {
+    pthread_join(system->threads[i], NULL);
+  }
+  for (int i = 0; i < system->threadCount; i++) {
+    pthread_mutex_destroy(&system->deques[i].mutex);
+  }
+
+  pthread_cond_destroy(&system->done);
+  pthread_cond_destroy(&system->wake);
+  pthread_mutex_destroy(&system->mutex);
+#endif
+
+  for (int i = 0; i < system->threadCount; i++) {
+    free(system->deques[i].ranges);
+  }
+  free(system);
+}
+
+/* Runs `function` over items 0 to `count - 1` in ranges of `grainSize`
+   items (0 picks a grain giving every worker a few ranges to steal).
+   Returns when all items are done. */
+void RunJobs(JobSystem *system, JobFunction function, void *data, int count, int grainSize) {
+  if (count <= 0) {
+    return;
+  }
+
+  if (grainSize <= 0) {
+    grainSize = count / (4 * system->threadCount);
+    grainSize = (grainSize > 0) ? grainSize : 1;
+  }
+
+  int rangeCount = (count + grainSize - 1) / grainSize;
+  int perWorker = (rangeCount + system->threadCount - 1) / system->threadCount;
+
+  for (int w = 0; w < system->threadCount; w++) {
+    JobDeque *deque = &system->deques[w];
+
+    if (deque->capacity < perWorker) {
+#if !defined(JOB_SYSTEM_NO_THREADS)
+      pthread_mutex_lock(&deque->mutex);
+#endif
+      JobRange *ranges = realloc(deque->ranges, perWorker * sizeof(JobRange));
+      if (ranges) {
+        deque->ranges = ranges;
+        deque->capacity = perWorker;
+      }
+#if !defined(JOB_SYSTEM_NO_THREADS)
+      pthread_mutex_unlock(&deque->mutex);
+#endif
+
+      if (ranges == NULL) {
+        TraceLog(LOG_WARNING, "JOBS: Failed to grow job deque, running batch on calling thread");
+        function(data, 0, count, 0);
+        return;
+      }
+    }
+  }
+
+  // Pending count is set before ranges are visible (a worker still leaving
+  // last batch can pick them up right away)
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  pthread_mutex_lock(&system->mutex);
+  system->pending = rangeCount;
+#endif
+
+  // Deal ranges to deques (consecutive ranges go to one worker for locality)
+  for (int w = 0; w < system->threadCount; w++) {
+    JobDeque *deque = &system->deques[w];
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+    pthread_mutex_lock(&deque->mutex);
+#endif
+    deque->top = 0;
+    deque->bottom = 0;
+    deque->jobsRun = 0;
+    deque->steals = 0;
+
+    // Pushed in reverse so owner pops them in order
+    int first = w * perWorker;
+    int last = (first + perWorker < rangeCount) ? first + perWorker : rangeCount;
+    for (int r = last - 1; r >= first; r--) {
+      int begin = r * grainSize;
+      int end = (begin + grainSize < count) ? begin + grainSize : count;
+
+      deque->ranges[deque->bottom++] = (JobRange){function, data, begin, end};
+    }
+#if !defined(JOB_SYSTEM_NO_THREADS)
+    pthread_mutex_unlock(&deque->mutex);
+#endif
+  }
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  system->generation++;
+  pthread_cond_broadcast(&system->wake);
+  pthread_mutex_unlock(&system->mutex);
+#endif
+
+  JobSystemWork(system, 0);
+
+#if !defined(JOB_SYSTEM_NO_THREADS)
+  pthread_mutex_lock(&system->mutex);
+  while (system->pending > 0) {
+    pthread_cond_wait(&system->done, &system->mutex);
+  }
+  pthread_mutex_unlock(&system->mutex);
+#endif
+}
+
+#endif
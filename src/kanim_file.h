@@ -0,0 +1,315 @@
+#ifndef __KIRAN_RAY_KANIM_FILE__
+#define __KIRAN_RAY_KANIM_FILE__
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+#define KANIM_NO_MMAP
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "animation_clip.h"
+
+/* `.kanim` baked clip file.
+
+   Clips are stored as they are used at runtime (local space frames of
+   `AnimationClip`) along with one bone table shared by all clips. Loader
+   maps the file read only and clips point into the mapping, so there is
+   no parsing or conversion on load and processes loading the same file
+   share its pages.
+
+   Layout (little endian, every block 16 byte aligned):
+     KanimHeader
+     BoneInfo[boneCount]            (raylib layout: name[32], parent)
+     KanimClipEntry[clipCount]
+     Transform[frameCount * boneCount] of every clip (at `framesOffset`) */
+
+#define KANIM_MAGIC "KANM"
+#define KANIM_VERSION 2 // 2: frame rate of clips
+#define KANIM_ALIGNMENT 16
+
+typedef struct KanimHeader {
+  char magic[4];            // KANIM_MAGIC
+  uint32_t version;         // KANIM_VERSION
+  uint32_t headerSize;      // sizeof(KanimHeader)
+  uint32_t transformSize;   // sizeof(Transform)
+  uint32_t boneCount;       // Number of bones in bone table
+  uint32_t clipCount;       // Number of clips
+  uint64_t boneTableOffset; // Offset of BoneInfo[boneCount]
+  uint64_t clipTableOffset; // Offset of KanimClipEntry[clipCount]
+  uint64_t fileSize;        // Size of whole file
+  uint32_t reserved[4];
+} KanimHeader;
+
+typedef struct KanimClipEntry {
+  char name[32];         // Name of clip
+  uint32_t frameCount;   // Number of frames
+  uint32_t flags;        // AnimationClip flags (CLIP_LOCAL_POSE and optionally CLIP_ADDITIVE)
+  uint64_t framesOffset; // Offset of local frames
+  float frameRate;       // Frames per second
+  uint32_t reserved[3];
+} KanimClipEntry;
+
+/* Loaded file. `bones` and frames of `clips` point into file data. Clips
+   are owned by file and their frames are read only: do not write into or
+   `UnloadAnimationClip()` them, unload file with `UnloadKanimFile()`
+   instead. */
+typedef struct KanimFile {
+  int boneCount;         // Number of bones (shared by all clips)
+  int clipCount;         // Number of clips
+  BoneInfo *bones;       // Bone table (in file data)
+  AnimationClip *clips;  // Clips (frames in file data)
+
+  void *data;            // File data (mapped or read)
+  size_t dataSize;       // Size of file data
+} KanimFile;
+
+int ExportKanimFile(const char *fileName, BoneInfo *bones, int boneCount,
+                    AnimationClip *clips, int clipCount);
+KanimFile LoadKanimFile(const char *fileName);
+void UnloadKanimFile(KanimFile file);
+int KanimFileFindClip(KanimFile file, const char *name);
+
+uint64_t KanimAlign(uint64_t offset) {
+  return (offset + KANIM_ALIGNMENT - 1) & ~(uint64_t)(KANIM_ALIGNMENT - 1);
+}
+
+int KanimWritePadding(FILE *file, uint64_t *offset) {
+  static const char zeros[KANIM_ALIGNMENT] = {0};
+  uint64_t aligned = KanimAlign(*offset);
+  size_t count = (size_t)(aligned - *offset);
+
+  *offset = aligned;
+
+  return fwrite(zeros, 1, count, file) == count;
+}
+
+/* Writes clips with their bone table. Clips must have `boneCount` bones.
+   Clips not storing local frames are converted (using `bones`) while
+   writing. Returns true on success. */
+int ExportKanimFile(const char *fileName, BoneInfo *bones, int boneCount,
+                    AnimationClip *clips, int clipCount) {
+  for (int i = 0; i < clipCount; i++) {
+    if (!AnimationClipIsValid(clips[i]) || clips[i].boneCount != boneCount) {
+      TraceLog(LOG_WARNING, "KANIM: Clip \"%s\" does not match bone table", clips[i].name);
+      return 0;
+    }
+    if ((clips[i].flags & CLIP_ADDITIVE) && !clips[i].localFrames) {
+      TraceLog(LOG_WARNING, "KANIM: Additive clip \"%s\" has no local frames", clips[i].name);
+      return 0;
+    }
+  }
+
+  FILE *file = fopen(fileName, "wb");
+  if (file == NULL) {
+    TraceLog(LOG_WARNING, "KANIM: [%s] Failed to open file for writing", fileName);
+    return 0;
+  }
+
+  KanimHeader header = {0};
+  memcpy(header.magic, KANIM_MAGIC, 4);
+  header.version = KANIM_VERSION;
+  header.headerSize = sizeof(KanimHeader);
+  header.transformSize = sizeof(Transform);
+  header.boneCount = boneCount;
+  header.clipCount = clipCount;
+  header.boneTableOffset = KanimAlign(sizeof(KanimHeader));
+  header.clipTableOffset = KanimAlign(header.boneTableOffset + (uint64_t)boneCount * sizeof(BoneInfo));
+
+  KanimClipEntry *entries = calloc(clipCount + 1, sizeof(KanimClipEntry));
+  uint64_t offset = KanimAlign(header.clipTableOffset + (uint64_t)clipCount * sizeof(KanimClipEntry));
+
+  for (int i = 0; i < clipCount; i++) {
+    memcpy(entries[i].name, clips[i].name, sizeof(entries[i].name));
+    entries[i].name[sizeof(entries[i].name) - 1] = '\0';
+    entries[i].frameCount = clips[i].frameCount;
+    entries[i].flags = CLIP_LOCAL_POSE | (clips[i].flags & CLIP_ADDITIVE);
+    entries[i].framesOffset = offset;
+    entries[i].frameRate = clips[i].frameRate;
+
+    offset = KanimAlign(offset + (uint64_t)clips[i].frameCount * boneCount * sizeof(Transform));
+  }
+  header.fileSize = offset;
+
+  SkeletonHierarchy hierarchy = LoadSkeletonHierarchy(bones, boneCount);
+  Pose temp = InitPose(boneCount);
+
+  offset = 0;
+  int success = fwrite(&header, sizeof(KanimHeader), 1, file) == 1;
+  offset += sizeof(KanimHeader);
+
+  success = success && KanimWritePadding(file, &offset);
+  success = success && fwrite(bones, sizeof(BoneInfo), boneCount, file) == (size_t)boneCount;
+  offset += (uint64_t)boneCount * sizeof(BoneInfo);
+
+  success = success && KanimWritePadding(file, &offset);
+  success = success && fwrite(entries, sizeof(KanimClipEntry), clipCount, file) == (size_t)clipCount;
+  offset += (uint64_t)clipCount * sizeof(KanimClipEntry);
+
+  for (int i = 0; success && (i < clipCount); i++) {
+    success = KanimWritePadding(file, &offset);
+
+    for (int frame = 0; success && (frame < clips[i].frameCount); frame++) {
+      Pose pose = AnimationClipResolvePose(clips[i], frame, CLIP_LOCAL_POSE, &hierarchy, temp);
+      success = fwrite(pose, sizeof(Transform), boneCount, file) == (size_t)boneCount;
+    }
+    offset += (uint64_t)clips[i].frameCount * boneCount * sizeof(Transform);
+  }
+  success = success && KanimWritePadding(file, &offset);
+
+  if (fclose(file) != 0) {
+    success = 0;
+  }
+  if (!success) {
+    TraceLog(LOG_WARNING, "KANIM: [%s] Failed to write file", fileName);
+  }
+
+  UnloadPose(temp);
+  UnloadSkeletonHierarchy(hierarchy);
+  free(entries);
+
+  return success;
+}
+
+// 1 if `count` elements of `elementSize` bytes at `offset` fit in `dataSize` (no overflow).
+int KanimRangeFits(uint64_t offset, uint64_t count, uint64_t elementSize, size_t dataSize) {
+  return offset <= dataSize && count <= (dataSize - offset) / elementSize;
+}
+
+/* Checks that header and tables fit in data and clip frames are in bounds.
+   Offsets and counts come from file, so checks are written not to overflow
+   and counts must fit in `int` (as loaded into `AnimationClip`). */
+int KanimFileValidate(const unsigned char *data, size_t dataSize) {
+  if (dataSize < sizeof(KanimHeader)) {
+    return 0;
+  }
+
+  const KanimHeader *header = (const KanimHeader *)data;
+  if (memcmp(header->magic, KANIM_MAGIC, 4) != 0 || header->version != KANIM_VERSION ||
+      header->headerSize != sizeof(KanimHeader) || header->transformSize != sizeof(Transform) ||
+      header->fileSize != dataSize) {
+    return 0;
+  }
+
+  if (header->boneCount > INT_MAX || header->clipCount > INT_MAX) {
+    return 0;
+  }
+
+  if (header->boneTableOffset % KANIM_ALIGNMENT || header->clipTableOffset % KANIM_ALIGNMENT ||
+      !KanimRangeFits(header->boneTableOffset, header->boneCount, sizeof(BoneInfo), dataSize) ||
+      !KanimRangeFits(header->clipTableOffset, header->clipCount, sizeof(KanimClipEntry), dataSize)) {
+    return 0;
+  }
+
+  const KanimClipEntry *entries = (const KanimClipEntry *)(data + header->clipTableOffset);
+  for (uint32_t i = 0; i < header->clipCount; i++) {
+    // Both counts are 32 bit, so their product fits in 64 bits
+    uint64_t transformCount = (uint64_t)entries[i].frameCount * header->boneCount;
+
+    if (entries[i].frameCount > INT_MAX || transformCount > INT_MAX) {
+      return 0;
+    }
+    if (entries[i].framesOffset % KANIM_ALIGNMENT ||
+        !KanimRangeFits(entries[i].framesOffset, transformCount, sizeof(Transform), dataSize)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* Maps file read only (read into memory where mmap is not available) and
+   points bone table and clip frames into it. */
+KanimFile LoadKanimFile(const char *fileName) {
+  KanimFile file = {0};
+  unsigned char *data = NULL;
+  size_t dataSize = 0;
+
+#if defined(KANIM_NO_MMAP)
+  int size = 0;
+  data = LoadFileData(fileName, &size);
+  dataSize = (size_t)size;
+#else
+  int fd = open(fileName, O_RDONLY);
+  struct stat st;
+  if (fd != -1 && fstat(fd, &st) == 0 && st.st_size > 0) {
+    dataSize = (size_t)st.st_size;
+    data = mmap(NULL, dataSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      data = NULL;
+    }
+  }
+  if (fd != -1) {
+    close(fd);
+  }
+#endif
+
+  if (data == NULL) {
+    TraceLog(LOG_WARNING, "KANIM: [%s] Failed to open file", fileName);
+    return file;
+  }
+
+  file.data = data;
+  file.dataSize = dataSize;
+
+  if (!KanimFileValidate(data, dataSize)) {
+    TraceLog(LOG_WARNING, "KANIM: [%s] Invalid or unsupported file", fileName);
+    UnloadKanimFile(file);
+    return (KanimFile){0};
+  }
+
+  const KanimHeader *header = (const KanimHeader *)data;
+  const KanimClipEntry *entries = (const KanimClipEntry *)(data + header->clipTableOffset);
+
+  // Counts were checked to fit in int
+  file.boneCount = (int)header->boneCount;
+  file.clipCount = (int)header->clipCount;
+  file.bones = (BoneInfo *)(data + header->boneTableOffset);
+  file.clips = calloc(file.clipCount, sizeof(AnimationClip));
+
+  for (int i = 0; i < file.clipCount; i++) {
+    AnimationClip *clip = &file.clips[i];
+
+    clip->boneCount = file.boneCount;
+    clip->frameCount = (int)entries[i].frameCount;
+    clip->flags = entries[i].flags;
+    clip->frameRate = entries[i].frameRate;
+    clip->localFrames = (Transform *)(data + entries[i].framesOffset);
+    memcpy(clip->name, entries[i].name, sizeof(clip->name));
+  }
+
+  TraceLog(LOG_INFO, "KANIM: [%s] Loaded %d clips (%d bones)", fileName, file.clipCount, file.boneCount);
+
+  return file;
+}
+
+void UnloadKanimFile(KanimFile file) {
+  if (file.data) {
+#if defined(KANIM_NO_MMAP)
+    UnloadFileData(file.data);
+#else
+    munmap(file.data, file.dataSize);
+#endif
+  }
+
+  free(file.clips);
+}
+
+// Index of clip named `name` (-1 if not found).
+int KanimFileFindClip(KanimFile file, const char *name) {
+  for (int i = 0; i < file.clipCount; i++) {
+    if (strncmp(file.clips[i].name, name, sizeof(file.clips[i].name)) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+#endif
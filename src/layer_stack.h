@@ -0,0 +1,430 @@
+#ifndef __KIRAN_RAY_LAYER_STACK__
+#define __KIRAN_RAY_LAYER_STACK__
+
+#include "skeleton.h"
+
+#define LAYER_OVERRIDE 0
+#define LAYER_ADDITIVE 1
+
+// Layer flags
+#define LAYER_LOCAL_POSE (1 << 0)      // `pose` is already in local space
+#define LAYER_LOCAL_REFERENCE (1 << 1) // `referencePose` is already in local space
+#define LAYER_BAKED_ADDITIVE (1 << 2)  // `pose` is baked local additive pose (no reference)
+
+/* Fused local space layer evaluator.
+
+   Layers are only recorded by `LayerStackPush...()` functions. Then
+   `EvaluateLayerStack()` blends all of them in local space and does exactly
+   one local->global conversion at the end. Whereas every `USE_LOCAL_POSE`
+   skeleton layer function does a full round trip on its own.
+
+   While evaluating:
+    - Layers with zero effective weight (zero factor or all zero mask) are
+      skipped.
+    - Layers below the last full override layer (factor 1, no mask) are
+      skipped as their result is overwritten anyway.
+
+   Poses (and masks) pushed are not copied. So, they must stay valid till
+   evaluation. */
+typedef struct AnimationLayer {
+  int type;            // LAYER_OVERRIDE or LAYER_ADDITIVE
+  Pose pose;           // Pose of layer (global unless LAYER_LOCAL_POSE)
+  Pose referencePose;  // Reference pose (additive layers only)
+  float factor;        // Weight of layer
+  float *boneMask;     // Per bone weight (NULL for all ones)
+  int flags;           // LAYER_LOCAL_POSE, LAYER_LOCAL_REFERENCE
+  Pose nextPose;       // Optional. Next frame `pose` is blended to (time sampled layers)
+  float sampleFactor;  // Blend factor from `pose` to `nextPose`
+  CompiledBoneMask *compiledMask; // Optional. Used instead of `boneMask` (see `LayerStackSetLayerMask()`)
+} AnimationLayer;
+
+typedef struct LayerStack {
+  SkeletonHierarchy hierarchy; // Hierarchy of skeleton (not owned)
+
+  int layerCount;         // Number of layers pushed
+  int layerCapacity;      // Number of layers memory is allocated for
+  AnimationLayer *layers; // Layers in order of application
+
+  Pose localPose;         // Working pose (local space)
+  Pose layerPose;         // Layer pose converted to local space
+  Pose referencePose;     // Reference pose converted to local space
+
+  int flags;              // Blend flags (BLEND_NLERP, BLEND_SAME_HEMISPHERE), also used between frames of time sampled layers
+} LayerStack;
+
+LayerStack LoadLayerStack(Skeleton skeleton);
+void UnloadLayerStack(LayerStack *stack);
+void ClearLayerStack(LayerStack *stack);
+
+void LayerStackPushPose(LayerStack *stack, Pose pose);
+void LayerStackPushOverride(LayerStack *stack, Pose pose, float factor,
+                            float *boneMask);
+void LayerStackPushAdditive(LayerStack *stack, Pose pose, Pose referencePose,
+                            float factor, float *boneMask);
+
+void LayerStackPushModelAnimation(LayerStack *stack, ModelAnimation anim,
+                                  int frame);
+void LayerStackPushModelAnimationOverride(LayerStack *stack,
+                                          ModelAnimation anim, int frame,
+                                          float factor, float *boneMask);
+void LayerStackPushModelAnimationAdditive(LayerStack *stack,
+                                          ModelAnimation anim, int frame,
+                                          Pose referencePose, float factor,
+                                          float *boneMask);
+
+/* Clip layers use local frames of clip when stored (no conversion while
+   evaluating). Otherwise its global frames are used. */
+void LayerStackPushAnimationClip(LayerStack *stack, AnimationClip clip,
+                                 int frame);
+void LayerStackPushAnimationClipOverride(LayerStack *stack,
+                                         AnimationClip clip, int frame,
+                                         float factor, float *boneMask);
+void LayerStackPushAnimationClipAdditive(LayerStack *stack,
+                                         AnimationClip clip, int frame,
+                                         AnimationClip referenceClip,
+                                         int referenceFrame, float factor,
+                                         float *boneMask);
+
+/* Baked additive clip layer (`LoadAdditiveAnimationClip()` with
+   `CLIP_LOCAL_POSE`). Clip without local additive poses is ignored. */
+void LayerStackPushAdditiveClip(LayerStack *stack, AnimationClip additiveClip,
+                                int frame, float factor, float *boneMask);
+
+/* Time sampled clip layers (see `AnimationClipSamplePoseInto()`). Two
+   neighbouring frames are recorded and blended while evaluating (with
+   blend `flags` of stack). */
+void LayerStackPushAnimationClipTime(LayerStack *stack, AnimationClip clip,
+                                     float seconds, int mode);
+void LayerStackPushAnimationClipTimeOverride(LayerStack *stack,
+                                             AnimationClip clip, float seconds,
+                                             int mode, float factor,
+                                             float *boneMask);
+void LayerStackPushAdditiveClipTime(LayerStack *stack,
+                                    AnimationClip additiveClip, float seconds,
+                                    int mode, float factor, float *boneMask);
+
+void LayerStackPushLayer(LayerStack *stack, AnimationLayer layer);
+
+/* Sets compiled mask of last pushed layer (replaces its `boneMask`). Layer
+   then only samples and blends bones of mask, when its pose is local. */
+void LayerStackSetLayerMask(LayerStack *stack, CompiledBoneMask *mask);
+
+void EvaluateLayerStack(LayerStack *stack, Pose out);
+void UpdateSkeletonFromLayerStack(Skeleton skeleton, LayerStack *stack);
+
+LayerStack LoadLayerStack(Skeleton skeleton) {
+  LayerStack stack = {0};
+  int boneCount = skeleton.boneCount;
+
+  stack.hierarchy = skeleton.hierarchy;
+
+  // Working poses in one allocation (freed with `localPose`)
+  stack.localPose = InitPose(3 * boneCount);
+  stack.layerPose = stack.localPose + boneCount;
+  stack.referencePose = stack.layerPose + boneCount;
+
+  return stack;
+}
+
+void UnloadLayerStack(LayerStack *stack) {
+  UnloadPose(stack->localPose);
+  free(stack->layers);
+
+  *stack = (LayerStack){0};
+}
+
+// Removes all layers (call once per frame before pushing layers)
+void ClearLayerStack(LayerStack *stack) {
+  stack->layerCount = 0;
+}
+
+void LayerStackPushLayer(LayerStack *stack, AnimationLayer layer) {
+  if (stack->layerCount == stack->layerCapacity) {
+    int capacity = (stack->layerCapacity) ? 2 * stack->layerCapacity : 8;
+    AnimationLayer *layers = realloc(stack->layers, capacity * sizeof(AnimationLayer));
+    if (layers == NULL) {
+      TraceLog(LOG_WARNING, "LAYER STACK: Failed to grow layers. Layer is ignored.");
+      return;
+    }
+
+    stack->layers = layers;
+    stack->layerCapacity = capacity;
+  }
+
+  stack->layers[stack->layerCount++] = layer;
+}
+
+void LayerStackSetLayerMask(LayerStack *stack, CompiledBoneMask *mask) {
+  if (stack->layerCount > 0) {
+    stack->layers[stack->layerCount - 1].boneMask = NULL;
+    stack->layers[stack->layerCount - 1].compiledMask = mask;
+  }
+}
+
+void LayerStackPushPose(LayerStack *stack, Pose pose) {
+  LayerStackPushOverride(stack, pose, 1.0f, NULL);
+}
+
+void LayerStackPushOverride(LayerStack *stack, Pose pose, float factor,
+                            float *boneMask) {
+  LayerStackPushLayer(stack, (AnimationLayer){LAYER_OVERRIDE, pose, NULL, factor, boneMask, 0, NULL, 0.0f, NULL});
+}
+
+void LayerStackPushAdditive(LayerStack *stack, Pose pose, Pose referencePose,
+                            float factor, float *boneMask) {
+  LayerStackPushLayer(stack, (AnimationLayer){LAYER_ADDITIVE, pose, referencePose, factor, boneMask, 0, NULL, 0.0f, NULL});
+}
+
+void LayerStackPushModelAnimation(LayerStack *stack, ModelAnimation anim,
+                                  int frame) {
+  LayerStackPushModelAnimationOverride(stack, anim, frame, 1.0f, NULL);
+}
+
+void LayerStackPushModelAnimationOverride(LayerStack *stack,
+                                          ModelAnimation anim, int frame,
+                                          float factor, float *boneMask) {
+  if ((anim.frameCount > 0) && (anim.framePoses != NULL)) {
+    LayerStackPushOverride(stack, anim.framePoses[frame % anim.frameCount], factor, boneMask);
+  }
+}
+
+void LayerStackPushModelAnimationAdditive(LayerStack *stack,
+                                          ModelAnimation anim, int frame,
+                                          Pose referencePose, float factor,
+                                          float *boneMask) {
+  if ((anim.frameCount > 0) && (anim.framePoses != NULL)) {
+    LayerStackPushAdditive(stack, anim.framePoses[frame % anim.frameCount], referencePose, factor, boneMask);
+  }
+}
+
+// Local frame of clip if stored, else global frame. Sets `localFlag` in `flags` for local.
+Pose AnimationClipLayerPose(AnimationClip clip, int frame, int *flags, int localFlag) {
+  if (clip.localFrames) {
+    *flags |= localFlag;
+    return AnimationClipGetLocalPose(clip, frame);
+  }
+
+  return AnimationClipGetGlobalPose(clip, frame);
+}
+
+void LayerStackPushAnimationClip(LayerStack *stack, AnimationClip clip,
+                                 int frame) {
+  LayerStackPushAnimationClipOverride(stack, clip, frame, 1.0f, NULL);
+}
+
+void LayerStackPushAnimationClipOverride(LayerStack *stack,
+                                         AnimationClip clip, int frame,
+                                         float factor, float *boneMask) {
+  if (AnimationClipIsValid(clip)) {
+    AnimationLayer layer = {LAYER_OVERRIDE, NULL, NULL, factor, boneMask, 0, NULL, 0.0f, NULL};
+    layer.pose = AnimationClipLayerPose(clip, frame, &layer.flags, LAYER_LOCAL_POSE);
+
+    LayerStackPushLayer(stack, layer);
+  }
+}
+
+void LayerStackPushAnimationClipAdditive(LayerStack *stack,
+                                         AnimationClip clip, int frame,
+                                         AnimationClip referenceClip,
+                                         int referenceFrame, float factor,
+                                         float *boneMask) {
+  if (AnimationClipIsValid(clip) && AnimationClipIsValid(referenceClip)) {
+    AnimationLayer layer = {LAYER_ADDITIVE, NULL, NULL, factor, boneMask, 0, NULL, 0.0f, NULL};
+    layer.pose = AnimationClipLayerPose(clip, frame, &layer.flags, LAYER_LOCAL_POSE);
+    layer.referencePose = AnimationClipLayerPose(referenceClip, referenceFrame, &layer.flags, LAYER_LOCAL_REFERENCE);
+
+    LayerStackPushLayer(stack, layer);
+  }
+}
+
+void LayerStackPushAdditiveClip(LayerStack *stack, AnimationClip additiveClip,
+                                int frame, float factor, float *boneMask) {
+  if (AnimationClipIsValid(additiveClip) && additiveClip.localFrames) {
+    LayerStackPushLayer(stack, (AnimationLayer){LAYER_ADDITIVE, AnimationClipGetLocalPose(additiveClip, frame), NULL, factor, boneMask,
+                                                LAYER_LOCAL_POSE | LAYER_BAKED_ADDITIVE, NULL, 0.0f, NULL});
+  }
+}
+
+void LayerStackPushAnimationClipTime(LayerStack *stack, AnimationClip clip,
+                                     float seconds, int mode) {
+  LayerStackPushAnimationClipTimeOverride(stack, clip, seconds, mode, 1.0f, NULL);
+}
+
+void LayerStackPushAnimationClipTimeOverride(LayerStack *stack,
+                                             AnimationClip clip, float seconds,
+                                             int mode, float factor,
+                                             float *boneMask) {
+  if (AnimationClipIsValid(clip)) {
+    int frameA, frameB;
+    AnimationLayer layer = {LAYER_OVERRIDE, NULL, NULL, factor, boneMask, 0, NULL, 0.0f, NULL};
+
+    layer.sampleFactor = AnimationClipTimeToFrames(clip, seconds, mode, &frameA, &frameB);
+    layer.pose = AnimationClipLayerPose(clip, frameA, &layer.flags, LAYER_LOCAL_POSE);
+    if (layer.sampleFactor != 0.0f) {
+      layer.nextPose = AnimationClipLayerPose(clip, frameB, &layer.flags, LAYER_LOCAL_POSE);
+    }
+
+    LayerStackPushLayer(stack, layer);
+  }
+}
+
+void LayerStackPushAdditiveClipTime(LayerStack *stack,
+                                    AnimationClip additiveClip, float seconds,
+                                    int mode, float factor, float *boneMask) {
+  if (AnimationClipIsValid(additiveClip) && additiveClip.localFrames) {
+    int frameA, frameB;
+    AnimationLayer layer = {LAYER_ADDITIVE, NULL, NULL, factor, boneMask,
+                            LAYER_LOCAL_POSE | LAYER_BAKED_ADDITIVE, NULL, 0.0f, NULL};
+
+    layer.sampleFactor = AnimationClipTimeToFrames(additiveClip, seconds, mode, &frameA, &frameB);
+    layer.pose = AnimationClipGetLocalPose(additiveClip, frameA);
+    if (layer.sampleFactor != 0.0f) {
+      layer.nextPose = AnimationClipGetLocalPose(additiveClip, frameB);
+    }
+
+    LayerStackPushLayer(stack, layer);
+  }
+}
+
+int AnimationLayerIsActive(AnimationLayer layer, int boneCount) {
+  if (layer.factor == 0.0f) {
+    return 0;
+  }
+
+  if (layer.compiledMask) {
+    return layer.compiledMask->type != BONE_MASK_EMPTY;
+  }
+
+  if (layer.boneMask) {
+    for (int i = 0; i < boneCount; i++) {
+      if (layer.boneMask[i] != 0.0f) {
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  return 1;
+}
+
+/* Local space pose of layer. Time sampled frames are blended and global
+   poses converted into `scratch` (returned then). */
+Pose LayerStackLayerLocalPose(LayerStack *stack, AnimationLayer layer, Pose scratch) {
+  Pose pose = layer.pose;
+
+  if (layer.nextPose) {
+    TransformLerpBatch(scratch, layer.pose, layer.nextPose, stack->hierarchy.boneCount, layer.sampleFactor, NULL, stack->flags);
+    pose = scratch;
+  }
+
+  if (!(layer.flags & LAYER_LOCAL_POSE)) {
+    PoseToLocalTransformPoseHierarchyInto(scratch, pose, &stack->hierarchy);
+    pose = scratch;
+  }
+
+  return pose;
+}
+
+/* Same as above for layer with a partial compiled mask and local pose.
+   Only bones of mask are sampled. */
+Pose LayerStackLayerLocalPoseMasked(LayerStack *stack, AnimationLayer layer, Pose scratch) {
+  if (layer.nextPose) {
+    PoseLerpBonesInto(scratch, layer.pose, layer.nextPose, layer.compiledMask->bones, layer.compiledMask->count,
+                      layer.sampleFactor, NULL, 1.0f, stack->flags);
+    return scratch;
+  }
+
+  return layer.pose;
+}
+
+/* Blends layer with partial compiled mask into working pose, touching only
+   bones of mask (global layer and reference poses are converted whole). */
+void LayerStackBlendMaskedLayer(LayerStack *stack, AnimationLayer layer) {
+  int boneCount = stack->hierarchy.boneCount;
+  CompiledBoneMask *mask = layer.compiledMask;
+
+  Pose layerPose = (layer.flags & LAYER_LOCAL_POSE) ? LayerStackLayerLocalPoseMasked(stack, layer, stack->layerPose)
+                                                    : LayerStackLayerLocalPose(stack, layer, stack->layerPose);
+
+  if (layer.type == LAYER_ADDITIVE && !(layer.flags & LAYER_BAKED_ADDITIVE)) {
+    Pose referencePose = layer.referencePose;
+    if (!(layer.flags & LAYER_LOCAL_REFERENCE)) {
+      PoseToLocalTransformPoseHierarchyInto(stack->referencePose, layer.referencePose, &stack->hierarchy);
+      referencePose = stack->referencePose;
+    }
+
+    for (int i = 0; i < mask->count; i++) {
+      int boneId = mask->bones[i];
+      stack->layerPose[boneId] = RelativeTransform(layerPose[boneId], referencePose[boneId]);
+    }
+    layerPose = stack->layerPose;
+  }
+
+  if (layer.type == LAYER_ADDITIVE) {
+    PoseAdditiveBlendCompiledInto(stack->localPose, stack->localPose, layerPose, boneCount, 1.0f, layer.factor, mask, stack->flags);
+  } else {
+    PoseOverrideBlendCompiledInto(stack->localPose, stack->localPose, layerPose, boneCount, layer.factor, mask, stack->flags);
+  }
+}
+
+/* Blends all layers on top of `out` (global pose) and writes the result
+   (global pose) back to `out`. */
+void EvaluateLayerStack(LayerStack *stack, Pose out) {
+  int boneCount = stack->hierarchy.boneCount;
+
+  AnimationLayer *layers = stack->layers;
+
+  // Everything below last full override layer is overwritten by it
+  int base = -1;
+  for (int i = stack->layerCount - 1; i >= 0; i--) {
+    int fullMask = (layers[i].compiledMask == NULL || layers[i].compiledMask->type == BONE_MASK_FULL);
+    if (layers[i].type == LAYER_OVERRIDE && layers[i].factor == 1.0f && layers[i].boneMask == NULL && fullMask) {
+      base = i;
+      break;
+    }
+  }
+
+  if (base != -1) {
+    CopyPoseInto(stack->localPose, LayerStackLayerLocalPose(stack, layers[base], stack->localPose), boneCount);
+  } else {
+    PoseToLocalTransformPoseHierarchyInto(stack->localPose, out, &stack->hierarchy);
+  }
+
+  for (int i = base + 1; i < stack->layerCount; i++) {
+    AnimationLayer layer = layers[i];
+    if (!AnimationLayerIsActive(layer, boneCount)) {
+      continue;
+    }
+
+    if (layer.compiledMask && layer.compiledMask->type != BONE_MASK_FULL) {
+      LayerStackBlendMaskedLayer(stack, layer);
+      continue;
+    }
+
+    Pose layerPose = LayerStackLayerLocalPose(stack, layer, stack->layerPose);
+
+    if (layer.type == LAYER_ADDITIVE && (layer.flags & LAYER_BAKED_ADDITIVE)) {
+      PoseAdditiveBlendExInto(stack->localPose, stack->localPose, layerPose, boneCount, 1.0f, layer.factor, layer.boneMask, stack->flags);
+    } else if (layer.type == LAYER_ADDITIVE) {
+      Pose referencePose = layer.referencePose;
+      if (!(layer.flags & LAYER_LOCAL_REFERENCE)) {
+        PoseToLocalTransformPoseHierarchyInto(stack->referencePose, layer.referencePose, &stack->hierarchy);
+        referencePose = stack->referencePose;
+      }
+
+      PoseGenerateAdditivePoseInto(stack->layerPose, layerPose, referencePose, boneCount);
+
+      PoseAdditiveBlendExInto(stack->localPose, stack->localPose, stack->layerPose, boneCount, 1.0f, layer.factor, layer.boneMask, stack->flags);
+    } else {
+      PoseOverrideBlendExInto(stack->localPose, stack->localPose, layerPose, boneCount, layer.factor, layer.boneMask, stack->flags);
+    }
+  }
+
+  PoseToGlobalTransformPoseHierarchyInto(out, stack->localPose, &stack->hierarchy);
+}
+
+void UpdateSkeletonFromLayerStack(Skeleton skeleton, LayerStack *stack) {
+  EvaluateLayerStack(stack, skeleton.pose);
+}
+
+#endif
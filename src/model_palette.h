@@ -0,0 +1,192 @@
+#ifndef __KIRAN_RAY_MODEL_PALETTE__
+#define __KIRAN_RAY_MODEL_PALETTE__
+
+#include <raylib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pose.h"
+
+// Vertex buffer of bone ids in raylib meshes (`RL_DEFAULT_SHADER_ATTRIB_LOCATION_BONEIDS`)
+#ifndef MODEL_PALETTE_BONEIDS_BUFFER
+#define MODEL_PALETTE_BONEIDS_BUFFER 6
+#endif
+
+// Model palette flags
+#define PALETTE_REMAP_MESHES (1 << 0) // Meshes using fewer bones than model get a compact palette
+
+typedef struct ModelPaletteMesh {
+  Matrix *boneMatrices;   // Matrices allocated by raylib for mesh (restored on unload)
+  int boneCount;          // Bone count of mesh as loaded
+  int usedCount;          // Number of bones used by mesh (0 if mesh references palette directly)
+  int *usedBones;         // Model bones used by mesh (remapped meshes only)
+  unsigned char *boneIds; // Bone ids of vertices as loaded (remapped meshes only)
+} ModelPaletteMesh;
+
+/* One skinning palette shared by all meshes of a model.
+
+   raylib gives every mesh its own `boneMatrices` and
+   `UpdateModelMeshFromPose()` copies same palette into each one. Here,
+   skinned meshes point their `boneMatrices` to one palette, so palette is
+   computed once and nothing is copied per mesh.
+
+   With `PALETTE_REMAP_MESHES` a mesh using only some bones has its vertex
+   bone ids rewritten to a compact range and gets (in its own matrices)
+   only those bones gathered from palette, so less is uploaded per draw.
+
+   Palette can be owned (`UpdateModelPaletteFromPose()`) or come from
+   elsewhere, e.g. a `SkeletonInstance` palette bound before drawing
+   (`BindModelPalette()`). Unload palette before model (mesh pointers and
+   bone ids are restored). */
+typedef struct ModelPalette {
+  Model model;              // Model (not owned)
+  int boneCount;            // Number of bones of model
+  Matrix *palette;          // Palette bound to meshes
+  Matrix *ownPalette;       // Palette owned (computed from pose)
+  Pose inverseBindPose;     // Inverse of bind pose of model (computed once)
+
+  ModelPaletteMesh *meshes; // Per mesh state (`model.meshCount`)
+} ModelPalette;
+
+ModelPalette LoadModelPalette(Model model, int flags);
+void UnloadModelPalette(ModelPalette *palette);
+void BindModelPalette(ModelPalette *palette, Matrix *matrices);
+void UpdateModelPaletteFromPose(ModelPalette *palette, Pose pose);
+
+ModelPalette LoadModelPalette(Model model, int flags) {
+  ModelPalette palette = {0};
+
+  palette.model = model;
+  palette.boneCount = model.boneCount;
+  palette.ownPalette = malloc(model.boneCount * sizeof(Matrix));
+  palette.inverseBindPose = malloc(model.boneCount * sizeof(Transform));
+  palette.meshes = calloc(model.meshCount, sizeof(ModelPaletteMesh));
+
+  for (int i = 0; i < model.boneCount; i++) {
+    palette.ownPalette[i] = MatrixIdentity();
+    palette.inverseBindPose[i] = TransformInvert(model.bindPose[i]);
+  }
+
+  int *compactIds = malloc(model.boneCount * sizeof(int));
+
+  for (int m = 0; m < model.meshCount; m++) {
+    Mesh *mesh = &model.meshes[m];
+    ModelPaletteMesh *state = &palette.meshes[m];
+
+    state->boneMatrices = mesh->boneMatrices;
+    state->boneCount = mesh->boneCount;
+
+    if (mesh->boneMatrices == NULL || !(flags & PALETTE_REMAP_MESHES) || mesh->boneIds == NULL || mesh->boneWeights == NULL) {
+      continue;
+    }
+
+    // Bones with weight in any vertex of mesh (ascending)
+    for (int b = 0; b < model.boneCount; b++) {
+      compactIds[b] = -1;
+    }
+    for (int v = 0; v < 4 * mesh->vertexCount; v++) {
+      if (mesh->boneWeights[v] > 0.0f && mesh->boneIds[v] < model.boneCount) {
+        compactIds[mesh->boneIds[v]] = 0;
+      }
+    }
+
+    int usedCount = 0;
+    for (int b = 0; b < model.boneCount; b++) {
+      if (compactIds[b] == 0) {
+        compactIds[b] = usedCount++;
+      }
+    }
+
+    if (usedCount == 0 || usedCount >= model.boneCount || usedCount > mesh->boneCount) {
+      continue;
+    }
+
+    state->usedCount = usedCount;
+    state->usedBones = malloc(usedCount * sizeof(int));
+    state->boneIds = malloc(4 * mesh->vertexCount);
+    memcpy(state->boneIds, mesh->boneIds, 4 * mesh->vertexCount);
+
+    for (int b = 0; b < model.boneCount; b++) {
+      if (compactIds[b] != -1) {
+        state->usedBones[compactIds[b]] = b;
+      }
+    }
+
+    // Unweighted influences point to first used bone
+    for (int v = 0; v < 4 * mesh->vertexCount; v++) {
+      int boneId = mesh->boneIds[v];
+      mesh->boneIds[v] = (boneId < model.boneCount && compactIds[boneId] != -1) ? (unsigned char)compactIds[boneId] : 0;
+    }
+
+    if (mesh->vboId && mesh->vboId[MODEL_PALETTE_BONEIDS_BUFFER]) {
+      UpdateMeshBuffer(*mesh, MODEL_PALETTE_BONEIDS_BUFFER, mesh->boneIds, 4 * mesh->vertexCount, 0);
+    }
+    mesh->boneCount = usedCount;
+  }
+
+  free(compactIds);
+
+  BindModelPalette(&palette, palette.ownPalette);
+
+  return palette;
+}
+
+void UnloadModelPalette(ModelPalette *palette) {
+  for (int m = 0; m < palette->model.meshCount; m++) {
+    Mesh *mesh = &palette->model.meshes[m];
+    ModelPaletteMesh *state = &palette->meshes[m];
+
+    mesh->boneMatrices = state->boneMatrices;
+    mesh->boneCount = state->boneCount;
+
+    if (state->usedCount > 0) {
+      memcpy(mesh->boneIds, state->boneIds, 4 * mesh->vertexCount);
+      if (mesh->vboId && mesh->vboId[MODEL_PALETTE_BONEIDS_BUFFER]) {
+        UpdateMeshBuffer(*mesh, MODEL_PALETTE_BONEIDS_BUFFER, mesh->boneIds, 4 * mesh->vertexCount, 0);
+      }
+    }
+
+    free(state->usedBones);
+    free(state->boneIds);
+  }
+
+  free(palette->meshes);
+  free(palette->ownPalette);
+  free(palette->inverseBindPose);
+
+  *palette = (ModelPalette){0};
+}
+
+/* Makes `matrices` (`boneCount` long, e.g. `SkeletonInstance.palette`)
+   palette of model. Meshes referencing palette directly only get a pointer
+   set. Remapped meshes gather their bones. */
+void BindModelPalette(ModelPalette *palette, Matrix *matrices) {
+  palette->palette = matrices;
+
+  for (int m = 0; m < palette->model.meshCount; m++) {
+    Mesh *mesh = &palette->model.meshes[m];
+    ModelPaletteMesh *state = &palette->meshes[m];
+
+    if (state->boneMatrices == NULL) {
+      continue;
+    }
+
+    if (state->usedCount == 0) {
+      mesh->boneMatrices = matrices;
+      continue;
+    }
+
+    for (int i = 0; i < state->usedCount; i++) {
+      mesh->boneMatrices[i] = matrices[state->usedBones[i]];
+    }
+  }
+}
+
+// Computes owned palette from `pose` (global) against bind pose of model.
+void UpdateModelPaletteFromPose(ModelPalette *palette, Pose pose) {
+  PoseToSkinningMatricesInto(palette->ownPalette, palette->inverseBindPose, pose, palette->boneCount);
+
+  BindModelPalette(palette, palette->ownPalette);
+}
+
+#endif
@@ -2,6 +2,8 @@
 #define __KIRAN_RAY_POSE__
 
 #include "bone_mask.h"
+#include "pose_simd.h"
+#include "skeleton_hierarchy.h"
 #include "transform.h"
 
 #include <stdlib.h>
@@ -34,6 +36,80 @@ Matrix *PoseToTransformMatrix(Pose pose, int boneCount);
 Pose PoseToLocalTransformPose(Pose pose, BoneInfo *bones, int boneCount);
 Pose PoseToGlobalTransformPose(Pose pose, BoneInfo *bones, int boneCount);
 
+/* Destination passing variants of above functions.
+   - Result is written to `out` (caller owned, `boneCount` long).
+   - `out` can be same as any of input poses.
+   - Never allocate memory. `NULL` bone mask means mask of ones. */
+void CopyPoseInto(Pose out, Pose pose, int boneCount);
+
+void PoseScaleInto(Pose out, Pose pose, int boneCount, float factor);
+void PoseInvertInto(Pose out, Pose pose, int boneCount);
+void PoseApplyInto(Pose out, Pose poseA, Pose poseB, int boneCount);
+void PoseGenerateAdditivePoseInto(Pose out, Pose pose, Pose referencePose,
+                                  int boneCount);
+void PoseLerpInto(Pose out, Pose poseA, Pose poseB, int boneCount,
+                  float factor);
+
+void PoseOverrideBlendInto(Pose out, Pose poseA, Pose poseB, int boneCount,
+                           float factor, float *boneMask);
+void PoseAdditiveBlendInto(Pose out, Pose poseA, Pose poseB, int boneCount,
+                           float factorA, float factorB, float *boneMask);
+
+/* Same as above with blend `flags` (`BLEND_NLERP`, `BLEND_SAME_HEMISPHERE`).
+   Passing 0 gives exactly the non `Ex` result. */
+void PoseOverrideBlendExInto(Pose out, Pose poseA, Pose poseB, int boneCount,
+                             float factor, float *boneMask, int flags);
+void PoseAdditiveBlendExInto(Pose out, Pose poseA, Pose poseB, int boneCount,
+                             float factorA, float factorB, float *boneMask,
+                             int flags);
+
+/* Same as above with compiled mask (see bone_mask.h). Only bones of mask
+   are blended, other bones are copied from `poseA` (skipped when `out` is
+   `poseA`). `NULL` mask means mask of ones. */
+void PoseOverrideBlendCompiledInto(Pose out, Pose poseA, Pose poseB,
+                                   int boneCount, float factor,
+                                   CompiledBoneMask *mask, int flags);
+void PoseAdditiveBlendCompiledInto(Pose out, Pose poseA, Pose poseB,
+                                   int boneCount, float factorA, float factorB,
+                                   CompiledBoneMask *mask, int flags);
+
+/* `out[bones[i]]` = blend of `poseA` and `poseB` by `factor` (times
+   `weights[i]` quantized against `weightScale` if not NULL, see
+   `CompiledBoneMask`). Other bones of `out` are not touched. */
+void PoseLerpBonesInto(Pose out, Pose poseA, Pose poseB, int *bones,
+                       int count, float factor, unsigned short *weights,
+                       float weightScale, int flags);
+
+void PoseToPoseTransformInto(Pose out, Pose poseA, Pose poseB, int boneCount);
+void PoseToPoseTransformMatricesInto(Matrix *out, Pose poseA, Pose poseB,
+                                     int boneCount);
+void PoseToTransformMatrixInto(Matrix *out, Pose pose, int boneCount);
+
+/* Skinning matrices with inverse bind pose computed once per skeleton
+   (`PoseInvertInto(inverseBindPose, bindPose, boneCount)`). Same as
+   `PoseToPoseTransformMatricesInto(out, bindPose, pose, boneCount)`. */
+void PoseToSkinningMatricesInto(Matrix *out, Pose inverseBindPose, Pose pose,
+                                int boneCount);
+
+/* Local pose to skinning matrices in one pass over hierarchy. Global
+   transforms are written to `globalPose` (which can be `localPose`), so
+   no intermediate pose is needed. */
+void PoseToSkinningMatricesHierarchyInto(Matrix *out, Pose globalPose,
+                                         Pose localPose, Pose inverseBindPose,
+                                         SkeletonHierarchy *hierarchy);
+
+void PoseToLocalTransformPoseInto(Pose out, Pose pose, BoneInfo *bones,
+                                  int boneCount);
+void PoseToGlobalTransformPoseInto(Pose out, Pose pose, BoneInfo *bones,
+                                   int boneCount);
+
+/* Same as above but walk compiled hierarchy (see skeleton_hierarchy.h). So,
+   bones can be in any order. */
+void PoseToLocalTransformPoseHierarchyInto(Pose out, Pose pose,
+                                           SkeletonHierarchy *hierarchy);
+void PoseToGlobalTransformPoseHierarchyInto(Pose out, Pose pose,
+                                            SkeletonHierarchy *hierarchy);
+
 void UpdateModelMeshFromPose(Model model, Pose pose);
 
 void DrawPose(Pose pose, BoneInfo *bones, int boneCount, Matrix mat,
@@ -48,7 +124,7 @@ Pose InitPose(int boneCount) {
 Pose CopyPose(Pose pose, int boneCount) {
   Pose p = InitPose(boneCount);
 
-  memcpy(p, pose, boneCount * sizeof(Transform));
+  CopyPoseInto(p, pose, boneCount);
 
   return p;
 }
@@ -56,19 +132,16 @@ Pose CopyPose(Pose pose, int boneCount) {
 Pose PoseScale(Pose pose, int boneCount, float factor) {
   Pose poseResult = InitPose(boneCount);
 
-  for (int i = 0; i < boneCount; i++) {
-    poseResult[i] = TransformScale(pose[i], factor);
-  }
+  PoseScaleInto(poseResult, pose, boneCount, factor);
 
-  return pose;
+  return poseResult;
 }
 
 Pose PoseGenerateAdditivePose(Pose targetPose, Pose referencePose,
                               int boneCount) {
   Pose pose = InitPose(boneCount);
-  for (int i = 0; i < boneCount; i++) {
-    pose[i] = RelativeTransform(targetPose[i], referencePose[i]);
-  }
+
+  PoseGenerateAdditivePoseInto(pose, targetPose, referencePose, boneCount);
 
   return pose;
 }
@@ -76,9 +149,7 @@ Pose PoseGenerateAdditivePose(Pose targetPose, Pose referencePose,
 Pose PoseLerp(Pose poseA, Pose poseB, int boneCount, float factor) {
   Pose pose = InitPose(boneCount);
 
-  for (int i = 0; i < boneCount; i++) {
-    pose[i] = TransformLerp(poseA[i], poseB[i], factor);
-  }
+  PoseLerpInto(pose, poseA, poseB, boneCount, factor);
 
   return pose;
 }
@@ -87,19 +158,7 @@ Pose PoseOverrideBlend(Pose poseA, Pose poseB, int boneCount, float factor,
                        float *boneMask) {
   Pose pose = InitPose(boneCount);
 
-  bool boneMaskGiven = true;
-  if (boneMask == NULL) {
-    boneMaskGiven = false;
-    boneMask = BoneMaskOnes(boneCount);
-  }
-
-  for (int i = 0; i < boneCount; i++) {
-    pose[i] = TransformLerp(poseA[i], poseB[i], factor * boneMask[i]);
-  }
-
-  if (boneMaskGiven == false) {
-    free(boneMask);
-  }
+  PoseOverrideBlendInto(pose, poseA, poseB, boneCount, factor, boneMask);
 
   return pose;
 }
@@ -108,23 +167,8 @@ Pose PoseAdditiveBlend(Pose poseA, Pose poseB, int boneCount, float weightA,
                        float weightB, float *boneMask) {
   Pose pose = InitPose(boneCount);
 
-  bool boneMaskGiven = true;
-  if (boneMask == NULL) {
-    boneMaskGiven = false;
-    boneMask = BoneMaskOnes(boneCount);
-  }
-
-  for (int i = 0; i < boneCount; i++) {
-
-    Transform in = TransformScale(poseA[i], weightA);
-    Transform out = TransformScale(poseB[i], weightB * boneMask[i]);
-
-    pose[i] = TransformApply(in, out);
-  }
-
-  if (boneMaskGiven == false) {
-    free(boneMask);
-  }
+  PoseAdditiveBlendInto(pose, poseA, poseB, boneCount, weightA, weightB,
+                        boneMask);
 
   return pose;
 }
@@ -132,9 +176,7 @@ Pose PoseAdditiveBlend(Pose poseA, Pose poseB, int boneCount, float weightA,
 Pose PoseApply(Pose poseA, Pose poseB, int boneCount) {
   Pose pose = InitPose(boneCount);
 
-  for (int i = 0; i < boneCount; i++) {
-    pose[i] = TransformApply(poseA[i], poseB[i]);
-  }
+  PoseApplyInto(pose, poseA, poseB, boneCount);
 
   return pose;
 }
@@ -142,9 +184,7 @@ Pose PoseApply(Pose poseA, Pose poseB, int boneCount) {
 Matrix *PoseToMatrices(Pose pose, int boneCount) {
   Matrix *matrices = malloc(boneCount * sizeof(Matrix));
 
-  for (int boneId = 0; boneId < boneCount; boneId++) {
-    matrices[boneId] = TransformToMatrix(pose[boneId]);
-  }
+  PoseToTransformMatrixInto(matrices, pose, boneCount);
 
   return matrices;
 }
@@ -152,31 +192,23 @@ Matrix *PoseToMatrices(Pose pose, int boneCount) {
 Pose PoseToPoseTransform(Pose poseA, Pose poseB, int boneCount) {
   Pose resultPose = InitPose(boneCount);
 
-  // Update all bones and boneMatrices of first mesh with bones.
-  for (int boneId = 0; boneId < boneCount; boneId++) {
-    Transform in = poseA[boneId];
-    Transform out = poseB[boneId];
-
-    resultPose[boneId] = TransformToTransformTransform(in, out);
-  }
+  PoseToPoseTransformInto(resultPose, poseA, poseB, boneCount);
 
   return resultPose;
 }
 
 Matrix *PoseToPoseTransformMatrices(Pose poseA, Pose poseB, int boneCount) {
-  Pose transformPose = PoseToPoseTransform(poseA, poseB, boneCount);
-  Matrix *boneMatrices = PoseToTransformMatrix(transformPose, boneCount);
+  Matrix *boneMatrices = malloc(boneCount * sizeof(Matrix));
+
+  PoseToPoseTransformMatricesInto(boneMatrices, poseA, poseB, boneCount);
 
-  UnloadPose(transformPose);
   return boneMatrices;
 }
 
 Matrix *PoseToTransformMatrix(Pose pose, int boneCount) {
   Matrix *boneMatrices = malloc(boneCount * sizeof(Matrix));
 
-  for (int boneId = 0; boneId < boneCount; boneId++) {
-    boneMatrices[boneId] = TransformToMatrix(pose[boneId]);
-  }
+  PoseToTransformMatrixInto(boneMatrices, pose, boneCount);
 
   return boneMatrices;
 }
@@ -184,102 +216,297 @@ Matrix *PoseToTransformMatrix(Pose pose, int boneCount) {
 Pose PoseInvert(Pose pose, int boneCount) {
   Pose invPose = InitPose(boneCount);
 
-  // Update all bones and boneMatrices of first mesh with bones.
-  for (int boneId = 0; boneId < boneCount; boneId++) {
-    invPose[boneId] = TransformInvert(pose[boneId]);
-  }
+  PoseInvertInto(invPose, pose, boneCount);
 
   return invPose;
 }
 
+/* Palette is computed into first skinned mesh and copied to others (not
+   copied to meshes sharing its matrices). To compute it once for all
+   meshes see `ModelPalette` (model_palette.h). */
 void UpdateModelMeshFromPose(Model model, Pose pose) {
-  Matrix *matrices =
-      PoseToPoseTransformMatrices(model.bindPose, pose, model.boneCount);
+  Matrix *matrices = NULL;
 
   for (int i = 0; i < model.meshCount; i++) {
-    if (model.meshes[i].boneMatrices) {
-      memcpy(model.meshes[i].boneMatrices, matrices,
-             model.meshes[i].boneCount * sizeof(Matrix));
+    Mesh mesh = model.meshes[i];
+
+    if (mesh.boneMatrices == NULL || mesh.boneMatrices == matrices) {
+      continue;
     }
-  }
 
-  free(matrices);
+    if (matrices == NULL && mesh.boneCount >= model.boneCount) {
+      matrices = mesh.boneMatrices;
+      PoseToPoseTransformMatricesInto(matrices, model.bindPose, pose, model.boneCount);
+    } else if (matrices) {
+      memcpy(mesh.boneMatrices, matrices, mesh.boneCount * sizeof(Matrix));
+    } else {
+      PoseToPoseTransformMatricesInto(mesh.boneMatrices, model.bindPose, pose, mesh.boneCount);
+    }
+  }
 }
 
 Pose PoseToLocalTransformPose(Pose globalPose, BoneInfo *bones, int boneCount) {
   Pose relativePose = InitPose(boneCount);
 
-  for (int i = 0; i < boneCount; i++) {
-    int parentIndex = bones[i].parent;
-    if (parentIndex == -1) {
-      relativePose[i] = globalPose[i];
-    } else {
-      Transform parentGlobalTransform = globalPose[parentIndex];
+  PoseToLocalTransformPoseInto(relativePose, globalPose, bones, boneCount);
 
-      Vector3 relativeTranslation = Vector3RotateByQuaternion(
-          Vector3Subtract(globalPose[i].translation,
-                          parentGlobalTransform.translation),
-          QuaternionInvert(parentGlobalTransform.rotation));
+  return relativePose;
+}
 
-      Quaternion relativeRotation =
-          QuaternionMultiply(QuaternionInvert(parentGlobalTransform.rotation),
-                             globalPose[i].rotation);
+Pose PoseToGlobalTransformPose(Pose localPose, BoneInfo *bones, int boneCount) {
+  Pose globalPose = InitPose(boneCount);
 
-      Vector3 relativeScale =
-          Vector3Divide(globalPose[i].scale, parentGlobalTransform.scale);
+  PoseToGlobalTransformPoseInto(globalPose, localPose, bones, boneCount);
 
-      relativePose[i].translation = relativeTranslation;
-      relativePose[i].rotation = relativeRotation;
-      relativePose[i].scale = relativeScale;
-    }
+  return globalPose;
+}
+
+void UnloadPose(Pose pose) {
+  if (pose) {
+    free(pose);
   }
+}
 
-  return relativePose;
+void UnloadPosePtr(Pose *pose_ptr) {
+  if (pose_ptr) {
+    UnloadPose(*pose_ptr);
+  }
 }
 
-Pose PoseToGlobalTransformPose(Pose localPose, BoneInfo *bones, int boneCount) {
-  Pose globalPose = InitPose(boneCount);
 
+void CopyPoseInto(Pose out, Pose pose, int boneCount) {
+  if (out != pose) {
+    memmove(out, pose, boneCount * sizeof(Transform));
+  }
+}
+
+void PoseScaleInto(Pose out, Pose pose, int boneCount, float factor) {
   for (int i = 0; i < boneCount; i++) {
-    int parentIndex = bones[i].parent;
+    out[i] = TransformScale(pose[i], factor);
+  }
+}
 
-    if (parentIndex == -1) {
-      globalPose[i] = localPose[i];
-    } else {
-      Transform parentGlobalTransform = globalPose[parentIndex];
+void PoseInvertInto(Pose out, Pose pose, int boneCount) {
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    out[boneId] = TransformInvert(pose[boneId]);
+  }
+}
+
+void PoseApplyInto(Pose out, Pose poseA, Pose poseB, int boneCount) {
+  for (int i = 0; i < boneCount; i++) {
+    out[i] = TransformApply(poseA[i], poseB[i]);
+  }
+}
+
+void PoseGenerateAdditivePoseInto(Pose out, Pose targetPose,
+                                  Pose referencePose, int boneCount) {
+  for (int i = 0; i < boneCount; i++) {
+    out[i] = RelativeTransform(targetPose[i], referencePose[i]);
+  }
+}
+
+void PoseLerpInto(Pose out, Pose poseA, Pose poseB, int boneCount,
+                  float factor) {
+  TransformLerpBatch(out, poseA, poseB, boneCount, factor, NULL, 0);
+}
+
+void PoseOverrideBlendInto(Pose out, Pose poseA, Pose poseB, int boneCount,
+                           float factor, float *boneMask) {
+  PoseOverrideBlendExInto(out, poseA, poseB, boneCount, factor, boneMask, 0);
+}
+
+void PoseAdditiveBlendInto(Pose out, Pose poseA, Pose poseB, int boneCount,
+                           float weightA, float weightB, float *boneMask) {
+  PoseAdditiveBlendExInto(out, poseA, poseB, boneCount, weightA, weightB,
+                          boneMask, 0);
+}
+
+void PoseOverrideBlendExInto(Pose out, Pose poseA, Pose poseB, int boneCount,
+                             float factor, float *boneMask, int flags) {
+  TransformLerpBatch(out, poseA, poseB, boneCount, factor, boneMask, flags);
+}
 
-      Vector3 globalTranslation =
-          Vector3Add(parentGlobalTransform.translation,
-                     Vector3RotateByQuaternion(localPose[i].translation,
-                                               parentGlobalTransform.rotation));
+void PoseAdditiveBlendExInto(Pose out, Pose poseA, Pose poseB, int boneCount,
+                             float weightA, float weightB, float *boneMask,
+                             int flags) {
+  TransformAdditiveBatch(out, poseA, poseB, boneCount, weightA, weightB,
+                         boneMask, flags);
+}
 
-      Quaternion globalRotation = QuaternionMultiply(
-          parentGlobalTransform.rotation, localPose[i].rotation);
+// Bones gathered per batch of `PoseLerpBonesInto()` (keeps SIMD kernels busy)
+#define POSE_GATHER_COUNT 32
+
+void PoseLerpBonesInto(Pose out, Pose poseA, Pose poseB, int *bones,
+                       int count, float factor, unsigned short *weights,
+                       float weightScale, int flags) {
+  Transform a[POSE_GATHER_COUNT], b[POSE_GATHER_COUNT];
+  float w[POSE_GATHER_COUNT];
+  float unit = weightScale * (1.0f / BONE_MASK_WEIGHT_ONE);
+
+  for (int i = 0; i < count; i += POSE_GATHER_COUNT) {
+    int n = (count - i < POSE_GATHER_COUNT) ? count - i : POSE_GATHER_COUNT;
+
+    for (int k = 0; k < n; k++) {
+      a[k] = poseA[bones[i + k]];
+      b[k] = poseB[bones[i + k]];
+      if (weights) {
+        w[k] = weights[i + k] * unit;
+      }
+    }
 
-      Vector3 globalScale =
-          Vector3Multiply(parentGlobalTransform.scale, localPose[i].scale);
+    TransformLerpBatch(a, a, b, n, factor, (weights) ? w : NULL, flags);
 
-      globalPose[i].translation = globalTranslation;
-      globalPose[i].rotation = globalRotation;
-      globalPose[i].scale = globalScale;
+    for (int k = 0; k < n; k++) {
+      out[bones[i + k]] = a[k];
     }
   }
+}
 
-  return globalPose;
+void PoseOverrideBlendCompiledInto(Pose out, Pose poseA, Pose poseB,
+                                   int boneCount, float factor,
+                                   CompiledBoneMask *mask, int flags) {
+  if (mask == NULL || mask->type == BONE_MASK_FULL) {
+    TransformLerpBatch(out, poseA, poseB, boneCount, factor, NULL, flags);
+    return;
+  }
+
+  // Mask bones first: `out` can be `poseB` (untouched bones are read till copied)
+  if (mask->type != BONE_MASK_EMPTY) {
+    PoseLerpBonesInto(out, poseA, poseB, mask->bones, mask->count, factor, mask->weights, mask->weightScale, flags);
+  }
+
+  if (out != poseA) {
+    for (int i = 0; i < boneCount; i++) {
+      if (!CompiledBoneMaskHasBone(mask, i)) {
+        out[i] = poseA[i];
+      }
+    }
+  }
 }
 
-void UnloadPose(Pose pose) {
-  if (pose) {
-    free(pose);
+void PoseAdditiveBlendCompiledInto(Pose out, Pose poseA, Pose poseB,
+                                   int boneCount, float weightA, float weightB,
+                                   CompiledBoneMask *mask, int flags) {
+  if (mask == NULL || mask->type == BONE_MASK_FULL) {
+    TransformAdditiveBatch(out, poseA, poseB, boneCount, weightA, weightB, NULL, flags);
+    return;
+  }
+
+  for (int i = 0; i < mask->count; i++) {
+    int boneId = mask->bones[i];
+    float weight = (mask->weights) ? weightB * mask->weights[i] * (mask->weightScale / BONE_MASK_WEIGHT_ONE) : weightB;
+
+    out[boneId] = TransformApply(TransformScaleEx(poseA[boneId], weightA, flags), TransformScaleEx(poseB[boneId], weight, flags));
+  }
+
+  // Bones outside mask only get `poseA` scaled by `weightA`
+  if (out != poseA || weightA != 1.0f) {
+    for (int i = 0; i < boneCount; i++) {
+      if (!CompiledBoneMaskHasBone(mask, i)) {
+        out[i] = (weightA == 1.0f) ? poseA[i] : TransformScaleEx(poseA[i], weightA, flags);
+      }
+    }
   }
 }
 
-void UnloadPosePtr(Pose *pose_ptr) {
-  if (pose_ptr) {
-    UnloadPose(*pose_ptr);
+void PoseToPoseTransformInto(Pose out, Pose poseA, Pose poseB,
+                             int boneCount) {
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    out[boneId] = TransformToTransformTransform(poseA[boneId], poseB[boneId]);
+  }
+}
+
+void PoseToPoseTransformMatricesInto(Matrix *out, Pose poseA, Pose poseB,
+                                     int boneCount) {
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    out[boneId] = TransformToMatrix(
+        TransformToTransformTransform(poseA[boneId], poseB[boneId]));
+  }
+}
+
+void PoseToSkinningMatricesInto(Matrix *out, Pose inverseBindPose, Pose pose,
+                                int boneCount) {
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    out[boneId] = TransformToMatrix(
+        TransformToTransformTransformInverse(inverseBindPose[boneId], pose[boneId]));
+  }
+}
+
+void PoseToSkinningMatricesHierarchyInto(Matrix *out, Pose globalPose,
+                                         Pose localPose, Pose inverseBindPose,
+                                         SkeletonHierarchy *hierarchy) {
+  for (int i = 0; i < hierarchy->boneCount; i++) {
+    int boneId = hierarchy->order[i];
+    int parentIndex = hierarchy->parents[boneId];
+
+    Transform global = (parentIndex == -1) ? localPose[boneId] : TransformLocalToGlobal(localPose[boneId], globalPose[parentIndex]);
+
+    globalPose[boneId] = global;
+    out[boneId] = TransformToMatrix(TransformToTransformTransformInverse(inverseBindPose[boneId], global));
+  }
+}
+
+void PoseToTransformMatrixInto(Matrix *out, Pose pose, int boneCount) {
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    out[boneId] = TransformToMatrix(pose[boneId]);
+  }
+}
+
+// Children are visited before parents so that parent's global transform is
+// still present when `out` is same as `globalPose`.
+void PoseToLocalTransformPoseInto(Pose out, Pose globalPose, BoneInfo *bones,
+                                  int boneCount) {
+  for (int i = boneCount - 1; i >= 0; i--) {
+    int parentIndex = bones[i].parent;
+    if (parentIndex == -1) {
+      out[i] = globalPose[i];
+    } else {
+      out[i] = TransformGlobalToLocal(globalPose[i], globalPose[parentIndex]);
+    }
+  }
+}
+
+void PoseToGlobalTransformPoseInto(Pose out, Pose localPose, BoneInfo *bones,
+                                   int boneCount) {
+  for (int i = 0; i < boneCount; i++) {
+    int parentIndex = bones[i].parent;
+
+    if (parentIndex == -1) {
+      out[i] = localPose[i];
+    } else {
+      out[i] = TransformLocalToGlobal(localPose[i], out[parentIndex]);
+    }
+  }
+}
+
+void PoseToLocalTransformPoseHierarchyInto(Pose out, Pose globalPose,
+                                           SkeletonHierarchy *hierarchy) {
+  // Children first so `out` can be same as `globalPose`
+  for (int i = hierarchy->boneCount - 1; i >= 0; i--) {
+    int boneId = hierarchy->order[i];
+    int parentIndex = hierarchy->parents[boneId];
+
+    if (parentIndex == -1) {
+      out[boneId] = globalPose[boneId];
+    } else {
+      out[boneId] = TransformGlobalToLocal(globalPose[boneId], globalPose[parentIndex]);
+    }
   }
 }
 
+void PoseToGlobalTransformPoseHierarchyInto(Pose out, Pose localPose,
+                                            SkeletonHierarchy *hierarchy) {
+  for (int i = 0; i < hierarchy->boneCount; i++) {
+    int boneId = hierarchy->order[i];
+    int parentIndex = hierarchy->parents[boneId];
+
+    if (parentIndex == -1) {
+      out[boneId] = localPose[boneId];
+    } else {
+      out[boneId] = TransformLocalToGlobal(localPose[boneId], out[parentIndex]);
+    }
+  }
+}
 
 void DrawPose(Pose pose, BoneInfo *bones, int boneCount, Matrix mat,
               Color color) {
@@ -0,0 +1,182 @@
+#ifndef __KIRAN_RAY_POSE_ARENA__
+#define __KIRAN_RAY_POSE_ARENA__
+
+#include "pose.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define POSE_ARENA_ALIGNMENT 16
+
+/* Linear (bump) allocator for temporary poses.
+
+   Allocating is a pointer increment and nothing is freed individually.
+   Call `ResetPoseArena()` once per frame to give back everything at once,
+   or use `PoseArenaGetMark()`/`PoseArenaRewind()` to give back temporaries
+   of a single function. If arena runs out of memory, allocation falls back
+   to heap and is still counted in `highWaterMark`. So, size the arena with
+   `highWaterMark` of your worst frame to never touch the heap. */
+typedef struct PoseArenaOverflow {
+  struct PoseArenaOverflow *next;
+} PoseArenaOverflow;
+
+typedef struct PoseArena {
+  unsigned char *buffer;  // Arena memory
+  size_t capacity;        // Size of buffer in bytes
+  size_t offset;          // Bytes in use (including alignment padding)
+
+  size_t overflowSize;         // Bytes taken from heap (not given back yet)
+  PoseArenaOverflow *overflow; // Heap allocations (not given back yet)
+
+  size_t highWaterMark;   // Max bytes ever in use at once
+} PoseArena;
+
+typedef struct PoseArenaMark {
+  size_t offset;
+  size_t overflowSize;
+  PoseArenaOverflow *overflow;
+} PoseArenaMark;
+
+PoseArena LoadPoseArena(size_t capacity);
+PoseArena LoadPoseArenaForPoses(int boneCount, int poseCount);
+void UnloadPoseArena(PoseArena *arena);
+void ResetPoseArena(PoseArena *arena);
+
+void *PoseArenaAlloc(PoseArena *arena, size_t size);
+void *PoseArenaAllocAligned(PoseArena *arena, size_t size, size_t alignment);
+
+PoseArenaMark PoseArenaGetMark(PoseArena *arena);
+void PoseArenaRewind(PoseArena *arena, PoseArenaMark mark);
+
+/* Pose helpers. When `arena` is NULL these fall back to `InitPose()`
+   and `UnloadPose()`, so functions can take arena optionally. */
+Pose PoseArenaInitPose(PoseArena *arena, int boneCount);
+Pose PoseArenaCopyPose(PoseArena *arena, Pose pose, int boneCount);
+void PoseArenaUnloadPose(PoseArena *arena, Pose pose);
+
+PoseArena LoadPoseArena(size_t capacity) {
+  PoseArena arena = {0};
+
+  arena.buffer = malloc(capacity + POSE_ARENA_ALIGNMENT);
+  arena.capacity = (arena.buffer) ? capacity + POSE_ARENA_ALIGNMENT : 0;
+
+  return arena;
+}
+
+PoseArena LoadPoseArenaForPoses(int boneCount, int poseCount) {
+  size_t poseSize = boneCount * sizeof(Transform);
+  poseSize = (poseSize + POSE_ARENA_ALIGNMENT - 1) & ~(size_t)(POSE_ARENA_ALIGNMENT - 1);
+
+  return LoadPoseArena(poseSize * poseCount);
+}
+
+void UnloadPoseArena(PoseArena *arena) {
+  if (arena == NULL) {
+    return;
+  }
+
+  ResetPoseArena(arena);
+
+  free(arena->buffer);
+  *arena = (PoseArena){0};
+}
+
+void ResetPoseArena(PoseArena *arena) {
+  PoseArenaRewind(arena, (PoseArenaMark){0});
+}
+
+// NULL without arena (callers taking arena optionally fall back to heap).
+void *PoseArenaAllocAligned(PoseArena *arena, size_t size, size_t alignment) {
+  if (arena == NULL) {
+    return NULL;
+  }
+
+  uintptr_t base = (uintptr_t)arena->buffer;
+  uintptr_t current = base + arena->offset;
+  uintptr_t aligned = (current + alignment - 1) & ~(uintptr_t)(alignment - 1);
+  size_t newOffset = (aligned - base) + size;
+
+  void *memory = NULL;
+  if (arena->buffer && newOffset <= arena->capacity) {
+    arena->offset = newOffset;
+    memory = (void *)aligned;
+  } else {
+    // Out of arena memory. Take it from heap and keep it till rewind/reset.
+    size_t header = (sizeof(PoseArenaOverflow) + alignment - 1) & ~(size_t)(alignment - 1);
+    PoseArenaOverflow *overflow = malloc(header + size + alignment);
+    if (overflow == NULL) {
+      return NULL;
+    }
+
+    overflow->next = arena->overflow;
+    arena->overflow = overflow;
+    arena->overflowSize += size;
+
+    uintptr_t start = (uintptr_t)overflow + header;
+    memory = (void *)((start + alignment - 1) & ~(uintptr_t)(alignment - 1));
+  }
+
+  if (arena->offset + arena->overflowSize > arena->highWaterMark) {
+    arena->highWaterMark = arena->offset + arena->overflowSize;
+  }
+
+  return memory;
+}
+
+void *PoseArenaAlloc(PoseArena *arena, size_t size) {
+  return PoseArenaAllocAligned(arena, size, POSE_ARENA_ALIGNMENT);
+}
+
+PoseArenaMark PoseArenaGetMark(PoseArena *arena) {
+  PoseArenaMark mark = {0};
+
+  if (arena) {
+    mark.offset = arena->offset;
+    mark.overflowSize = arena->overflowSize;
+    mark.overflow = arena->overflow;
+  }
+
+  return mark;
+}
+
+// Gives back everything allocated from arena after `mark` was taken.
+void PoseArenaRewind(PoseArena *arena, PoseArenaMark mark) {
+  if (arena == NULL) {
+    return;
+  }
+
+  while (arena->overflow && arena->overflow != mark.overflow) {
+    PoseArenaOverflow *next = arena->overflow->next;
+    free(arena->overflow);
+    arena->overflow = next;
+  }
+
+  arena->overflowSize = mark.overflowSize;
+  if (mark.offset <= arena->offset) {
+    arena->offset = mark.offset;
+  }
+}
+
+Pose PoseArenaInitPose(PoseArena *arena, int boneCount) {
+  if (arena == NULL) {
+    return InitPose(boneCount);
+  }
+
+  return PoseArenaAlloc(arena, boneCount * sizeof(Transform));
+}
+
+Pose PoseArenaCopyPose(PoseArena *arena, Pose pose, int boneCount) {
+  Pose p = PoseArenaInitPose(arena, boneCount);
+
+  CopyPoseInto(p, pose, boneCount);
+
+  return p;
+}
+
+void PoseArenaUnloadPose(PoseArena *arena, Pose pose) {
+  if (arena == NULL) {
+    UnloadPose(pose);
+  }
+}
+
+#endif
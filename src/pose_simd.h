@@ -0,0 +1,422 @@
+#ifndef __KIRAN_RAY_POSE_SIMD__
+#define __KIRAN_RAY_POSE_SIMD__
+
+#include "transform.h"
+
+#include <math.h>
+#include <string.h>
+
+/* Batched (SIMD) transform blending kernels.
+
+   Kernels blend `KANIM_SIMD_LANES` bones per instruction. Instruction set
+   is selected at compile time:
+    - AVX2   (8 lanes) when compiled with `-mavx2` (or `-march=native`)
+    - SSE4.1 (4 lanes) when compiled with `-msse4.1`
+    - Scalar (1 lane)  otherwise or if `KANIM_NO_SIMD` is defined. Scalar
+      path is exactly `TransformLerp()`/`TransformScale()`/`TransformApply()`.
+
+   SIMD path follows raylib's `QuaternionSlerp()` (including its nlerp and
+   degenerate branches, picked from a dot summed in same order) but uses
+   polynomial acos/sin. With `BLEND_NLERP` no trigonometry is done at all.
+   Difference from scalar path is within `KANIM_SIMD_TOLERANCE` for every
+   component (measured under 5e-7 by `tools/simd_blend_check.c`, also for
+   nearly identical and nearly antipodal rotations). Scale of additive
+   blend uses `powf()` per lane. */
+
+#define KANIM_SIMD_TOLERANCE 1e-5f
+
+#if !defined(KANIM_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define KANIM_SIMD_AVX2
+#define KANIM_SIMD_LANES 8
+
+typedef __m256 KanimVec;
+#define KV_SET1(x) _mm256_set1_ps(x)
+#define KV_LOAD(p) _mm256_loadu_ps(p)
+#define KV_STORE(p, v) _mm256_storeu_ps(p, v)
+#define KV_ADD(a, b) _mm256_add_ps(a, b)
+#define KV_SUB(a, b) _mm256_sub_ps(a, b)
+#define KV_MUL(a, b) _mm256_mul_ps(a, b)
+#define KV_DIV(a, b) _mm256_div_ps(a, b)
+#define KV_SQRT(a) _mm256_sqrt_ps(a)
+#define KV_AND(a, b) _mm256_and_ps(a, b)
+#define KV_XOR(a, b) _mm256_xor_ps(a, b)
+#define KV_LT(a, b) _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define KV_GT(a, b) _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define KV_GE(a, b) _mm256_cmp_ps(a, b, _CMP_GE_OQ)
+#define KV_EQ(a, b) _mm256_cmp_ps(a, b, _CMP_EQ_OQ)
+#define KV_SELECT(a, b, mask) _mm256_blendv_ps(a, b, mask)
+#define KV_ROUND(a) _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+
+#elif !defined(KANIM_NO_SIMD) && defined(__SSE4_1__)
+#include <smmintrin.h>
+#define KANIM_SIMD_SSE4
+#define KANIM_SIMD_LANES 4
+
+typedef __m128 KanimVec;
+#define KV_SET1(x) _mm_set1_ps(x)
+#define KV_LOAD(p) _mm_loadu_ps(p)
+#define KV_STORE(p, v) _mm_storeu_ps(p, v)
+#define KV_ADD(a, b) _mm_add_ps(a, b)
+#define KV_SUB(a, b) _mm_sub_ps(a, b)
+#define KV_MUL(a, b) _mm_mul_ps(a, b)
+#define KV_DIV(a, b) _mm_div_ps(a, b)
+#define KV_SQRT(a) _mm_sqrt_ps(a)
+#define KV_AND(a, b) _mm_and_ps(a, b)
+#define KV_XOR(a, b) _mm_xor_ps(a, b)
+#define KV_LT(a, b) _mm_cmplt_ps(a, b)
+#define KV_GT(a, b) _mm_cmpgt_ps(a, b)
+#define KV_GE(a, b) _mm_cmpge_ps(a, b)
+#define KV_EQ(a, b) _mm_cmpeq_ps(a, b)
+#define KV_SELECT(a, b, mask) _mm_blendv_ps(a, b, mask)
+#define KV_ROUND(a) _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+
+#else
+#define KANIM_SIMD_LANES 1
+#endif
+
+// Channels of a transform as stored in `Transform` (and `PoseSoA`).
+#define KANIM_TRANSFORM_CHANNELS 10
+
+/* `out[i] = TransformLerpEx(a[i], b[i], factor * weights[i], flags)`.
+   `weights` can be NULL (all ones). `out` can be same as `a` or `b`. */
+void TransformLerpBatch(Transform *out, Transform *a, Transform *b, int count,
+                        float factor, float *weights, int flags);
+
+/* `out[i] = TransformApply(TransformScaleEx(a[i], weightA, flags),
+                            TransformScaleEx(b[i], weightB * weights[i], flags))`. */
+void TransformAdditiveBatch(Transform *out, Transform *a, Transform *b,
+                            int count, float weightA, float weightB,
+                            float *weights, int flags);
+
+#if KANIM_SIMD_LANES > 1
+
+/* Block kernels. Each pointer points to `KANIM_SIMD_LANES` floats of one
+   channel (tx, ty, tz, qx, qy, qz, qw, sx, sy, sz). `weights` holds final
+   per lane weight. */
+void TransformLerpBlock(float **out, float **a, float **b, float *weights,
+                        int flags);
+void TransformAdditiveBlock(float **out, float **a, float **b, float weightA,
+                            float *weights, int flags);
+
+// acos() for x in [0, 1]. Abramowitz & Stegun 4.4.46, error < 2e-8.
+KanimVec KanimVecAcos(KanimVec x) {
+  KanimVec p = KV_SET1(-0.0012624911f);
+  p = KV_ADD(KV_MUL(p, x), KV_SET1(0.0066700901f));
+  p = KV_ADD(KV_MUL(p, x), KV_SET1(-0.0170881256f));
+  p = KV_ADD(KV_MUL(p, x), KV_SET1(0.0308918810f));
+  p = KV_ADD(KV_MUL(p, x), KV_SET1(-0.0501743046f));
+  p = KV_ADD(KV_MUL(p, x), KV_SET1(0.0889789874f));
+  p = KV_ADD(KV_MUL(p, x), KV_SET1(-0.2145988016f));
+  p = KV_ADD(KV_MUL(p, x), KV_SET1(1.5707963050f));
+
+  return KV_MUL(KV_SQRT(KV_SUB(KV_SET1(1.0f), x)), p);
+}
+
+// sin() for any x. Reduced to [-PI/2, PI/2] then odd polynomial (error < 6e-8).
+KanimVec KanimVecSin(KanimVec x) {
+  KanimVec k = KV_ROUND(KV_MUL(x, KV_SET1(0.15915494309189535f)));
+  x = KV_SUB(x, KV_MUL(k, KV_SET1(6.28125f)));
+  x = KV_SUB(x, KV_MUL(k, KV_SET1(0.0019353071795864769f)));
+
+  KanimVec halfPi = KV_SET1(1.5707963267948966f);
+  KanimVec pi = KV_SET1(3.1415926535897932f);
+  x = KV_SELECT(x, KV_SUB(pi, x), KV_GT(x, halfPi));
+  x = KV_SELECT(x, KV_SUB(KV_SUB(KV_SET1(0.0f), pi), x),
+                KV_LT(x, KV_SUB(KV_SET1(0.0f), halfPi)));
+
+  KanimVec x2 = KV_MUL(x, x);
+  KanimVec p = KV_SET1(-2.5052108385441720e-8f);
+  p = KV_ADD(KV_MUL(p, x2), KV_SET1(2.7557319223985893e-6f));
+  p = KV_ADD(KV_MUL(p, x2), KV_SET1(-1.9841269841269841e-4f));
+  p = KV_ADD(KV_MUL(p, x2), KV_SET1(8.3333333333333333e-3f));
+  p = KV_ADD(KV_MUL(p, x2), KV_SET1(-1.6666666666666667e-1f));
+
+  return KV_ADD(x, KV_MUL(KV_MUL(x, x2), p));
+}
+
+/* Lane wise quaternion dot, summed left to right like scalar code. Other
+   orders round differently, and near 1 (or 0.95) that picks other branch
+   of slerp than scalar path. */
+KanimVec KanimVecDot4(KanimVec *a, KanimVec *b) {
+  KanimVec dot = KV_MUL(a[0], b[0]);
+  dot = KV_ADD(dot, KV_MUL(a[1], b[1]));
+  dot = KV_ADD(dot, KV_MUL(a[2], b[2]));
+
+  return KV_ADD(dot, KV_MUL(a[3], b[3]));
+}
+
+// Lane wise `QuaternionSlerp(a, b, t)` (same branches as raylib).
+void KanimVecSlerp(KanimVec *out, KanimVec *a, KanimVec *b, KanimVec t) {
+  KanimVec one = KV_SET1(1.0f);
+  KanimVec zero = KV_SET1(0.0f);
+
+  KanimVec cosHalfTheta = KanimVecDot4(a, b);
+
+  // Shortest path: flip b where dot is negative
+  KanimVec sign = KV_AND(KV_LT(cosHalfTheta, zero), KV_SET1(-0.0f));
+  KanimVec q2[4];
+  for (int c = 0; c < 4; c++) {
+    q2[c] = KV_XOR(b[c], sign);
+  }
+  cosHalfTheta = KV_XOR(cosHalfTheta, sign);
+
+  // Nlerp (used when rotations are close)
+  KanimVec nlerp[4];
+  KanimVec lengthSqr = zero;
+  for (int c = 0; c < 4; c++) {
+    nlerp[c] = KV_ADD(a[c], KV_MUL(t, KV_SUB(q2[c], a[c])));
+    lengthSqr = KV_ADD(lengthSqr, KV_MUL(nlerp[c], nlerp[c]));
+  }
+  KanimVec length = KV_SQRT(lengthSqr);
+  length = KV_SELECT(length, one, KV_EQ(length, zero));
+  KanimVec invLength = KV_DIV(one, length);
+
+  // Slerp
+  KanimVec halfTheta = KanimVecAcos(cosHalfTheta);
+  KanimVec sinHalfTheta = KV_SQRT(KV_SUB(one, KV_MUL(cosHalfTheta, cosHalfTheta)));
+  KanimVec ratioA = KV_DIV(KanimVecSin(KV_MUL(KV_SUB(one, t), halfTheta)), sinHalfTheta);
+  KanimVec ratioB = KV_DIV(KanimVecSin(KV_MUL(t, halfTheta)), sinHalfTheta);
+
+  KanimVec useNlerp = KV_GT(cosHalfTheta, KV_SET1(0.95f));
+  KanimVec useHalf = KV_LT(sinHalfTheta, KV_SET1(EPSILON));
+  KanimVec useA = KV_GE(cosHalfTheta, one);
+
+  for (int c = 0; c < 4; c++) {
+    KanimVec r = KV_ADD(KV_MUL(a[c], ratioA), KV_MUL(q2[c], ratioB));
+    r = KV_SELECT(r, KV_ADD(KV_MUL(a[c], KV_SET1(0.5f)), KV_MUL(q2[c], KV_SET1(0.5f))), useHalf);
+    r = KV_SELECT(r, KV_MUL(nlerp[c], invLength), useNlerp);
+    out[c] = KV_SELECT(r, a[c], useA);
+  }
+}
+
+// Lane wise `QuaternionNlerpShortest(a, b, t, flags)`.
+void KanimVecNlerp(KanimVec *out, KanimVec *a, KanimVec *b, KanimVec t,
+                   int flags) {
+  KanimVec one = KV_SET1(1.0f);
+  KanimVec zero = KV_SET1(0.0f);
+
+  KanimVec q2[4] = {b[0], b[1], b[2], b[3]};
+  if (!(flags & BLEND_SAME_HEMISPHERE)) {
+    KanimVec dot = KanimVecDot4(a, b);
+    KanimVec sign = KV_AND(KV_LT(dot, zero), KV_SET1(-0.0f));
+    for (int c = 0; c < 4; c++) {
+      q2[c] = KV_XOR(b[c], sign);
+    }
+  }
+
+  KanimVec lengthSqr = zero;
+  for (int c = 0; c < 4; c++) {
+    out[c] = KV_ADD(a[c], KV_MUL(t, KV_SUB(q2[c], a[c])));
+    lengthSqr = KV_ADD(lengthSqr, KV_MUL(out[c], out[c]));
+  }
+
+  KanimVec length = KV_SQRT(lengthSqr);
+  length = KV_SELECT(length, one, KV_EQ(length, zero));
+  KanimVec invLength = KV_DIV(one, length);
+
+  for (int c = 0; c < 4; c++) {
+    out[c] = KV_MUL(out[c], invLength);
+  }
+}
+
+void KanimVecBlendRotation(KanimVec *out, KanimVec *a, KanimVec *b,
+                           KanimVec t, int flags) {
+  if (flags & BLEND_NLERP) {
+    KanimVecNlerp(out, a, b, t, flags);
+  } else {
+    KanimVecSlerp(out, a, b, t);
+  }
+}
+
+// Lane wise `TransformScaleEx()` rotation (`q` is kept as is where `t` is 1).
+void KanimVecScaleRotation(KanimVec *q, KanimVec t, int flags) {
+  KanimVec identity[4] = {KV_SET1(0.0f), KV_SET1(0.0f), KV_SET1(0.0f),
+                          KV_SET1(1.0f)};
+  KanimVec scaled[4];
+
+  KanimVecBlendRotation(scaled, identity, q, t, flags);
+
+  KanimVec keep = KV_EQ(t, KV_SET1(1.0f));
+  for (int c = 0; c < 4; c++) {
+    q[c] = KV_SELECT(scaled[c], q[c], keep);
+  }
+}
+
+void TransformLerpBlock(float **out, float **a, float **b, float *weights,
+                        int flags) {
+  KanimVec t = KV_LOAD(weights);
+
+  KanimVec qa[4], qb[4], q[4];
+  for (int c = 0; c < 4; c++) {
+    qa[c] = KV_LOAD(a[3 + c]);
+    qb[c] = KV_LOAD(b[3 + c]);
+  }
+
+  KanimVecBlendRotation(q, qa, qb, t, flags);
+
+  for (int c = 0; c < 3; c++) {
+    KanimVec ta = KV_LOAD(a[c]), tb = KV_LOAD(b[c]);
+    KanimVec sa = KV_LOAD(a[7 + c]), sb = KV_LOAD(b[7 + c]);
+
+    KV_STORE(out[c], KV_ADD(ta, KV_MUL(t, KV_SUB(tb, ta))));
+    KV_STORE(out[7 + c], KV_ADD(sa, KV_MUL(t, KV_SUB(sb, sa))));
+  }
+
+  for (int c = 0; c < 4; c++) {
+    KV_STORE(out[3 + c], q[c]);
+  }
+}
+
+void TransformAdditiveBlock(float **out, float **a, float **b, float weightA,
+                            float *weights, int flags) {
+  KanimVec wa = KV_SET1(weightA);
+  KanimVec wb = KV_LOAD(weights);
+
+  KanimVec qa[4], qb[4];
+  for (int c = 0; c < 4; c++) {
+    qa[c] = KV_LOAD(a[3 + c]);
+    qb[c] = KV_LOAD(b[3 + c]);
+  }
+
+  if (weightA != 1.0f) {
+    KanimVecScaleRotation(qa, wa, flags);
+  }
+  KanimVecScaleRotation(qb, wb, flags);
+
+  // QuaternionMultiply(qa, qb)
+  KanimVec x = KV_SUB(KV_ADD(KV_ADD(KV_MUL(qa[0], qb[3]), KV_MUL(qa[3], qb[0])), KV_MUL(qa[1], qb[2])), KV_MUL(qa[2], qb[1]));
+  KanimVec y = KV_SUB(KV_ADD(KV_ADD(KV_MUL(qa[1], qb[3]), KV_MUL(qa[3], qb[1])), KV_MUL(qa[2], qb[0])), KV_MUL(qa[0], qb[2]));
+  KanimVec z = KV_SUB(KV_ADD(KV_ADD(KV_MUL(qa[2], qb[3]), KV_MUL(qa[3], qb[2])), KV_MUL(qa[0], qb[1])), KV_MUL(qa[1], qb[0]));
+  KanimVec w = KV_SUB(KV_SUB(KV_SUB(KV_MUL(qa[3], qb[3]), KV_MUL(qa[0], qb[0])), KV_MUL(qa[1], qb[1])), KV_MUL(qa[2], qb[2]));
+
+  float scale[3][KANIM_SIMD_LANES];
+  for (int c = 0; c < 3; c++) {
+    KanimVec ta = KV_LOAD(a[c]), tb = KV_LOAD(b[c]);
+    KV_STORE(out[c], KV_ADD(KV_MUL(ta, wa), KV_MUL(tb, wb)));
+
+    for (int i = 0; i < KANIM_SIMD_LANES; i++) {
+      scale[c][i] = powf(a[7 + c][i], weightA) * powf(b[7 + c][i], weights[i]);
+    }
+  }
+
+  KV_STORE(out[3], x);
+  KV_STORE(out[4], y);
+  KV_STORE(out[5], z);
+  KV_STORE(out[6], w);
+
+  for (int c = 0; c < 3; c++) {
+    memcpy(out[7 + c], scale[c], sizeof(scale[c]));
+  }
+}
+
+// Transposes `count` (<= KANIM_SIMD_LANES) transforms into channel block.
+// Missing lanes get identity transform.
+void KanimTransformsToBlock(float block[KANIM_TRANSFORM_CHANNELS][KANIM_SIMD_LANES],
+                            Transform *transforms, int count) {
+  const float *f = (const float *)transforms;
+
+  for (int c = 0; c < KANIM_TRANSFORM_CHANNELS; c++) {
+    for (int i = 0; i < count; i++) {
+      block[c][i] = f[i * KANIM_TRANSFORM_CHANNELS + c];
+    }
+  }
+
+  static const float identity[KANIM_TRANSFORM_CHANNELS] = {
+      0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+  for (int i = count; i < KANIM_SIMD_LANES; i++) {
+    for (int c = 0; c < KANIM_TRANSFORM_CHANNELS; c++) {
+      block[c][i] = identity[c];
+    }
+  }
+}
+
+void KanimBlockToTransforms(Transform *transforms,
+                            float block[KANIM_TRANSFORM_CHANNELS][KANIM_SIMD_LANES],
+                            int count) {
+  float *f = (float *)transforms;
+
+  for (int i = 0; i < count; i++) {
+    for (int c = 0; c < KANIM_TRANSFORM_CHANNELS; c++) {
+      f[i * KANIM_TRANSFORM_CHANNELS + c] = block[c][i];
+    }
+  }
+}
+
+#endif
+
+void TransformLerpBatch(Transform *out, Transform *a, Transform *b, int count,
+                        float factor, float *weights, int flags) {
+#if KANIM_SIMD_LANES > 1
+  float blockA[KANIM_TRANSFORM_CHANNELS][KANIM_SIMD_LANES];
+  float blockB[KANIM_TRANSFORM_CHANNELS][KANIM_SIMD_LANES];
+  float *channelsA[KANIM_TRANSFORM_CHANNELS], *channelsB[KANIM_TRANSFORM_CHANNELS];
+  for (int c = 0; c < KANIM_TRANSFORM_CHANNELS; c++) {
+    channelsA[c] = blockA[c];
+    channelsB[c] = blockB[c];
+  }
+
+  for (int i = 0; i < count; i += KANIM_SIMD_LANES) {
+    int n = (count - i < KANIM_SIMD_LANES) ? count - i : KANIM_SIMD_LANES;
+
+    float w[KANIM_SIMD_LANES];
+    for (int l = 0; l < KANIM_SIMD_LANES; l++) {
+      w[l] = (l < n) ? ((weights) ? factor * weights[i + l] : factor) : 0.0f;
+    }
+
+    KanimTransformsToBlock(blockA, a + i, n);
+    KanimTransformsToBlock(blockB, b + i, n);
+
+    TransformLerpBlock(channelsA, channelsA, channelsB, w, flags);
+
+    KanimBlockToTransforms(out + i, blockA, n);
+  }
+#else
+  for (int i = 0; i < count; i++) {
+    float weight = (weights) ? factor * weights[i] : factor;
+
+    out[i] = TransformLerpEx(a[i], b[i], weight, flags);
+  }
+#endif
+}
+
+void TransformAdditiveBatch(Transform *out, Transform *a, Transform *b,
+                            int count, float weightA, float weightB,
+                            float *weights, int flags) {
+#if KANIM_SIMD_LANES > 1
+  float blockA[KANIM_TRANSFORM_CHANNELS][KANIM_SIMD_LANES];
+  float blockB[KANIM_TRANSFORM_CHANNELS][KANIM_SIMD_LANES];
+  float *channelsA[KANIM_TRANSFORM_CHANNELS], *channelsB[KANIM_TRANSFORM_CHANNELS];
+  for (int c = 0; c < KANIM_TRANSFORM_CHANNELS; c++) {
+    channelsA[c] = blockA[c];
+    channelsB[c] = blockB[c];
+  }
+
+  for (int i = 0; i < count; i += KANIM_SIMD_LANES) {
+    int n = (count - i < KANIM_SIMD_LANES) ? count - i : KANIM_SIMD_LANES;
+
+    float w[KANIM_SIMD_LANES];
+    for (int l = 0; l < KANIM_SIMD_LANES; l++) {
+      w[l] = (l < n) ? ((weights) ? weightB * weights[i + l] : weightB) : 0.0f;
+    }
+
+    KanimTransformsToBlock(blockA, a + i, n);
+    KanimTransformsToBlock(blockB, b + i, n);
+
+    TransformAdditiveBlock(channelsA, channelsA, channelsB, weightA, w, flags);
+
+    KanimBlockToTransforms(out + i, blockA, n);
+  }
+#else
+  for (int i = 0; i < count; i++) {
+    float weight = (weights) ? weightB * weights[i] : weightB;
+
+    Transform base = TransformScaleEx(a[i], weightA, flags);
+    Transform additive = TransformScaleEx(b[i], weight, flags);
+
+    out[i] = TransformApply(base, additive);
+  }
+#endif
+}
+
+#endif
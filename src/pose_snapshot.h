@@ -0,0 +1,530 @@
+#ifndef __KIRAN_RAY_POSE_SNAPSHOT__
+#define __KIRAN_RAY_POSE_SNAPSHOT__
+
+#include "quantized_clip.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define POSE_SNAPSHOT_HISTORY 32       // Snapshots kept as baselines (sender and receiver)
+#define POSE_SNAPSHOT_NO_BASELINE 0xFFFF // Baseline field of snapshots encoded against reference pose
+#define POSE_SNAPSHOT_HEADER_SIZE 5    // Sequence (2), baseline (2), channels (1)
+
+// Channels of a snapshot (bit set if channel mask and values follow)
+#define SNAPSHOT_ROTATION (1 << 0)
+#define SNAPSHOT_TRANSLATION (1 << 1)
+#define SNAPSHOT_SCALE (1 << 2)
+
+/* Quantization and send thresholds of snapshots. Sender and receiver must
+   use same config. Translations and scales out of range are clamped. */
+typedef struct PoseSnapshotConfig {
+  float rotationThreshold;    // Min rotation change (radians) of a bone to send it
+  float translationThreshold; // Min translation change (distance) of a bone to send it
+  float scaleThreshold;       // Min scale change (distance) of a bone to send it
+  float translationRange;     // Local translations quantized in [-range, range] (16 bits per axis)
+  float scaleRange;           // Scales quantized in [0, range] (16 bits per axis)
+} PoseSnapshotConfig;
+
+/* Ring of reconstructed poses by sequence. Sender keeps what receiver
+   rebuilt for each snapshot, so baselines are bit identical on both sides
+   and quantization error never accumulates. */
+typedef struct PoseSnapshotHistory {
+  int boneCount;
+  Pose poses[POSE_SNAPSHOT_HISTORY];    // Reconstructed local pose of each snapshot
+  int sequences[POSE_SNAPSHOT_HISTORY]; // Sequence of each pose (-1 if free)
+  int next;                             // Slot written next
+} PoseSnapshotHistory;
+
+/* Sender side. Every snapshot is one local pose encoded against last
+   acknowledged snapshot (or reference pose when none is acknowledged or
+   it is no longer in history).
+
+   Snapshot layout (little endian):
+    - sequence (uint16), baseline sequence (uint16, or
+      `POSE_SNAPSHOT_NO_BASELINE`), channels (uint8)
+    - per channel in `channels` (rotation, translation, scale): bitmask of
+      bones sent (`(boneCount + 7) / 8` bytes), then 6 bytes per bone sent
+      (rotation: smallest three, see `QuantizeRotation()`, others: 16 bits
+      per axis normalized to config range)
+
+   A bone channel is sent only if it moved more than its threshold from
+   baseline. So a held pose costs only the header. */
+typedef struct PoseSnapshotEncoder {
+  int boneCount;
+  PoseSnapshotConfig config;
+  Pose referencePose;          // Baseline when none is acknowledged (copy)
+  PoseSnapshotHistory history; // Poses receiver has for each sequence sent
+  int sequence;                // Sequence of next snapshot
+  int ackedSequence;           // Latest sequence acknowledged (-1 if none)
+} PoseSnapshotEncoder;
+
+// Receiver side. Rebuilds local poses and keeps them as baselines.
+typedef struct PoseSnapshotDecoder {
+  int boneCount;
+  PoseSnapshotConfig config;
+  Pose referencePose;          // Same reference pose as encoder (copy)
+  PoseSnapshotHistory history; // Poses rebuilt by sequence
+} PoseSnapshotDecoder;
+
+/* Received poses by time, sampled with delay for smooth playback between
+   snapshots (`PoseLerpInto()`). */
+typedef struct PoseInterpolationBuffer {
+  int boneCount;
+  int capacity;    // Max snapshots kept
+  int count;       // Snapshots kept (sorted by time)
+  float *times;    // Time of each snapshot
+  Pose *poses;     // Pose of each snapshot
+} PoseInterpolationBuffer;
+
+PoseSnapshotConfig PoseSnapshotDefaultConfig(void);
+int PoseSnapshotMaxSize(int boneCount);
+
+PoseSnapshotEncoder LoadPoseSnapshotEncoder(Pose referencePose, int boneCount, PoseSnapshotConfig config);
+void UnloadPoseSnapshotEncoder(PoseSnapshotEncoder *encoder);
+int EncodePoseSnapshot(PoseSnapshotEncoder *encoder, Pose localPose, unsigned char *buffer, int bufferSize);
+void PoseSnapshotEncoderAck(PoseSnapshotEncoder *encoder, int sequence);
+
+PoseSnapshotDecoder LoadPoseSnapshotDecoder(Pose referencePose, int boneCount, PoseSnapshotConfig config);
+void UnloadPoseSnapshotDecoder(PoseSnapshotDecoder *decoder);
+int DecodePoseSnapshot(PoseSnapshotDecoder *decoder, const unsigned char *data, int size, Pose out);
+
+PoseInterpolationBuffer LoadPoseInterpolationBuffer(int boneCount, int capacity);
+void UnloadPoseInterpolationBuffer(PoseInterpolationBuffer *buffer);
+void PoseInterpolationBufferPush(PoseInterpolationBuffer *buffer, float time, Pose pose);
+int PoseInterpolationBufferSampleInto(Pose out, PoseInterpolationBuffer *buffer, float time);
+
+/* About 0.1 degree, 1 mm and 0.001 of scale (for models in meters), with
+   translations in [-8, 8] and scales in [0, 4]. */
+PoseSnapshotConfig PoseSnapshotDefaultConfig(void) {
+  PoseSnapshotConfig config = {0};
+
+  config.rotationThreshold = 0.002f;
+  config.translationThreshold = 0.001f;
+  config.scaleThreshold = 0.001f;
+  config.translationRange = 8.0f;
+  config.scaleRange = 4.0f;
+
+  return config;
+}
+
+// Largest snapshot of `boneCount` bones (every channel of every bone sent).
+int PoseSnapshotMaxSize(int boneCount) {
+  return POSE_SNAPSHOT_HEADER_SIZE + 3 * ((boneCount + 7) / 8 + 6 * boneCount);
+}
+
+PoseSnapshotHistory LoadPoseSnapshotHistory(int boneCount) {
+  PoseSnapshotHistory history = {0};
+
+  history.boneCount = boneCount;
+  for (int i = 0; i < POSE_SNAPSHOT_HISTORY; i++) {
+    history.poses[i] = InitPose(boneCount);
+    history.sequences[i] = -1;
+  }
+
+  return history;
+}
+
+void UnloadPoseSnapshotHistory(PoseSnapshotHistory *history) {
+  for (int i = 0; i < POSE_SNAPSHOT_HISTORY; i++) {
+    UnloadPose(history->poses[i]);
+  }
+
+  *history = (PoseSnapshotHistory){0};
+}
+
+// Pose of `sequence` (NULL if not in history).
+Pose PoseSnapshotHistoryFind(PoseSnapshotHistory *history, int sequence) {
+  if (sequence < 0) {
+    return NULL;
+  }
+
+  for (int i = 0; i < POSE_SNAPSHOT_HISTORY; i++) {
+    if (history->sequences[i] == sequence) {
+      return history->poses[i];
+    }
+  }
+
+  return NULL;
+}
+
+// Takes oldest slot for `sequence` (replacing a same sequence if present).
+Pose PoseSnapshotHistoryAdd(PoseSnapshotHistory *history, int sequence) {
+  for (int i = 0; i < POSE_SNAPSHOT_HISTORY; i++) {
+    if (history->sequences[i] == sequence) {
+      return history->poses[i];
+    }
+  }
+
+  int slot = history->next;
+  history->next = (history->next + 1) % POSE_SNAPSHOT_HISTORY;
+  history->sequences[slot] = sequence;
+
+  return history->poses[slot];
+}
+
+void PoseSnapshotWriteUint16(unsigned char *data, int value) {
+  data[0] = (unsigned char)(value & 0xFF);
+  data[1] = (unsigned char)((value >> 8) & 0xFF);
+}
+
+int PoseSnapshotReadUint16(const unsigned char *data) {
+  return data[0] | (data[1] << 8);
+}
+
+// Angle between two rotations (radians).
+float PoseSnapshotRotationDelta(Quaternion a, Quaternion b) {
+  float dot = fabsf(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+
+  return 2.0f * acosf(fminf(dot, 1.0f));
+}
+
+/* Quantized value of one channel of `transform` into `out` (3 uint16) and
+   its dequantized value into `decoded` (exactly as receiver rebuilds it). */
+void PoseSnapshotQuantizeChannel(PoseSnapshotConfig *config, int channel, Transform transform,
+                                 uint16_t *out, Transform *decoded) {
+  if (channel == SNAPSHOT_ROTATION) {
+    QuantizeRotation(out, transform.rotation);
+    decoded->rotation = DequantizeRotation(out);
+    return;
+  }
+
+  Vector3 v = (channel == SNAPSHOT_TRANSLATION) ? transform.translation : transform.scale;
+  float min = (channel == SNAPSHOT_TRANSLATION) ? -config->translationRange : 0.0f;
+  float extent = (channel == SNAPSHOT_TRANSLATION) ? 2.0f * config->translationRange : config->scaleRange;
+
+  out[0] = QuantizeChannel(v.x, min, extent);
+  out[1] = QuantizeChannel(v.y, min, extent);
+  out[2] = QuantizeChannel(v.z, min, extent);
+
+  Vector3 d = {DequantizeChannel(out[0], min, extent), DequantizeChannel(out[1], min, extent),
+               DequantizeChannel(out[2], min, extent)};
+  if (channel == SNAPSHOT_TRANSLATION) {
+    decoded->translation = d;
+  } else {
+    decoded->scale = d;
+  }
+}
+
+// Decodes 3 uint16 of one channel into `transform` (same as sender's decoded value).
+void PoseSnapshotDequantizeChannel(PoseSnapshotConfig *config, int channel, uint16_t *packed,
+                                   Transform *transform) {
+  if (channel == SNAPSHOT_ROTATION) {
+    transform->rotation = DequantizeRotation(packed);
+    return;
+  }
+
+  float min = (channel == SNAPSHOT_TRANSLATION) ? -config->translationRange : 0.0f;
+  float extent = (channel == SNAPSHOT_TRANSLATION) ? 2.0f * config->translationRange : config->scaleRange;
+
+  Vector3 d = {DequantizeChannel(packed[0], min, extent), DequantizeChannel(packed[1], min, extent),
+               DequantizeChannel(packed[2], min, extent)};
+  if (channel == SNAPSHOT_TRANSLATION) {
+    transform->translation = d;
+  } else {
+    transform->scale = d;
+  }
+}
+
+/* `referencePose` (local, e.g. bind pose in local space) is baseline of
+   first snapshots and must be same on receiver. */
+PoseSnapshotEncoder LoadPoseSnapshotEncoder(Pose referencePose, int boneCount, PoseSnapshotConfig config) {
+  PoseSnapshotEncoder encoder = {0};
+
+  encoder.boneCount = boneCount;
+  encoder.config = config;
+  encoder.referencePose = CopyPose(referencePose, boneCount);
+  encoder.history = LoadPoseSnapshotHistory(boneCount);
+  encoder.ackedSequence = -1;
+
+  return encoder;
+}
+
+void UnloadPoseSnapshotEncoder(PoseSnapshotEncoder *encoder) {
+  UnloadPose(encoder->referencePose);
+  UnloadPoseSnapshotHistory(&encoder->history);
+
+  *encoder = (PoseSnapshotEncoder){0};
+}
+
+/* Encodes `localPose` into `buffer` (at least `PoseSnapshotMaxSize()`
+   bytes). Returns size of snapshot (0 if buffer is too small). */
+int EncodePoseSnapshot(PoseSnapshotEncoder *encoder, Pose localPose, unsigned char *buffer, int bufferSize) {
+  int boneCount = encoder->boneCount;
+  int maskSize = (boneCount + 7) / 8;
+
+  if (bufferSize < PoseSnapshotMaxSize(boneCount)) {
+    TraceLog(LOG_WARNING, "SNAPSHOT: Buffer of %d bytes is too small (%d needed)", bufferSize, PoseSnapshotMaxSize(boneCount));
+    return 0;
+  }
+
+  int sequence = encoder->sequence;
+  Pose baseline = PoseSnapshotHistoryFind(&encoder->history, encoder->ackedSequence);
+  int baselineSequence = (baseline) ? encoder->ackedSequence : POSE_SNAPSHOT_NO_BASELINE;
+  if (baseline == NULL) {
+    baseline = encoder->referencePose;
+  }
+
+  /* Rebuilt pose starts as baseline. When acked sequence is exactly
+     `POSE_SNAPSHOT_HISTORY` sends old, baseline is the oldest slot and is
+     the one taken: it already holds baseline, so copy is skipped and
+     deltas are taken against it in place. */
+  Pose rebuilt = PoseSnapshotHistoryAdd(&encoder->history, sequence);
+  if (rebuilt != baseline) {
+    CopyPoseInto(rebuilt, baseline, boneCount);
+  }
+
+  PoseSnapshotWriteUint16(buffer, sequence);
+  PoseSnapshotWriteUint16(buffer + 2, baselineSequence);
+  buffer[4] = 0;
+  int size = POSE_SNAPSHOT_HEADER_SIZE;
+
+  float thresholds[3] = {encoder->config.rotationThreshold, encoder->config.translationThreshold, encoder->config.scaleThreshold};
+
+  for (int c = 0; c < 3; c++) {
+    int channel = 1 << c;
+    unsigned char *mask = buffer + size;
+    int valuesStart = size + maskSize;
+    int valuesSize = 0;
+
+    memset(mask, 0, maskSize);
+
+    for (int boneId = 0; boneId < boneCount; boneId++) {
+      Transform current = localPose[boneId];
+      Transform base = rebuilt[boneId];
+
+      float delta = (channel == SNAPSHOT_ROTATION) ? PoseSnapshotRotationDelta(current.rotation, base.rotation)
+                  : (channel == SNAPSHOT_TRANSLATION) ? Vector3Distance(current.translation, base.translation)
+                  : Vector3Distance(current.scale, base.scale);
+      if (delta <= thresholds[c]) {
+        continue;
+      }
+
+      uint16_t packed[3];
+      PoseSnapshotQuantizeChannel(&encoder->config, channel, current, packed, &rebuilt[boneId]);
+
+      mask[boneId >> 3] |= (unsigned char)(1 << (boneId & 7));
+      for (int i = 0; i < 3; i++) {
+        PoseSnapshotWriteUint16(buffer + valuesStart + valuesSize + 2 * i, packed[i]);
+      }
+      valuesSize += 6;
+    }
+
+    // Channel without bones sent costs nothing (not even its mask)
+    if (valuesSize > 0) {
+      buffer[4] |= (unsigned char)channel;
+      size = valuesStart + valuesSize;
+    }
+  }
+
+  encoder->sequence = (sequence + 1) & 0xFFFF;
+  if (encoder->sequence == POSE_SNAPSHOT_NO_BASELINE) {
+    encoder->sequence = 0;
+  }
+
+  return size;
+}
+
+// Receiver has decoded `sequence`. Later snapshots are encoded against it.
+void PoseSnapshotEncoderAck(PoseSnapshotEncoder *encoder, int sequence) {
+  if (PoseSnapshotHistoryFind(&encoder->history, sequence) == NULL) {
+    return;
+  }
+
+  // Newer of two (sequences wrap around)
+  int ahead = (sequence - encoder->ackedSequence) & 0xFFFF;
+  if (encoder->ackedSequence < 0 || (ahead > 0 && ahead < 0x8000)) {
+    encoder->ackedSequence = sequence;
+  }
+}
+
+PoseSnapshotDecoder LoadPoseSnapshotDecoder(Pose referencePose, int boneCount, PoseSnapshotConfig config) {
+  PoseSnapshotDecoder decoder = {0};
+
+  decoder.boneCount = boneCount;
+  decoder.config = config;
+  decoder.referencePose = CopyPose(referencePose, boneCount);
+  decoder.history = LoadPoseSnapshotHistory(boneCount);
+
+  return decoder;
+}
+
+void UnloadPoseSnapshotDecoder(PoseSnapshotDecoder *decoder) {
+  UnloadPose(decoder->referencePose);
+  UnloadPoseSnapshotHistory(&decoder->history);
+
+  *decoder = (PoseSnapshotDecoder){0};
+}
+
+/* Rebuilds local pose of snapshot into `out` (can be NULL) and keeps it as
+   baseline. Returns sequence of snapshot (acknowledge it to sender), or -1
+   if snapshot is malformed or its baseline is no longer in history. */
+int DecodePoseSnapshot(PoseSnapshotDecoder *decoder, const unsigned char *data, int size, Pose out) {
+  int boneCount = decoder->boneCount;
+  int maskSize = (boneCount + 7) / 8;
+
+  if (size < POSE_SNAPSHOT_HEADER_SIZE) {
+    TraceLog(LOG_WARNING, "SNAPSHOT: Snapshot of %d bytes is too small", size);
+    return -1;
+  }
+
+  int sequence = PoseSnapshotReadUint16(data);
+  int baselineSequence = PoseSnapshotReadUint16(data + 2);
+  int channels = data[4];
+
+  Pose baseline = decoder->referencePose;
+  if (baselineSequence != POSE_SNAPSHOT_NO_BASELINE) {
+    baseline = PoseSnapshotHistoryFind(&decoder->history, baselineSequence);
+    if (baseline == NULL) {
+      TraceLog(LOG_DEBUG, "SNAPSHOT: Baseline %d of snapshot %d not in history", baselineSequence, sequence);
+      return -1;
+    }
+  }
+
+  // Validated before history is touched
+  int offset = POSE_SNAPSHOT_HEADER_SIZE;
+  for (int c = 0; c < 3; c++) {
+    if (!(channels & (1 << c))) {
+      continue;
+    }
+    if (offset + maskSize > size) {
+      TraceLog(LOG_WARNING, "SNAPSHOT: Snapshot %d is truncated", sequence);
+      return -1;
+    }
+
+    int sent = 0;
+    for (int boneId = 0; boneId < boneCount; boneId++) {
+      sent += (data[offset + (boneId >> 3)] >> (boneId & 7)) & 1;
+    }
+    offset += maskSize + 6 * sent;
+  }
+  if (offset > size) {
+    TraceLog(LOG_WARNING, "SNAPSHOT: Snapshot %d is truncated", sequence);
+    return -1;
+  }
+
+  Pose rebuilt = PoseSnapshotHistoryAdd(&decoder->history, sequence);
+  if (rebuilt != baseline) {
+    CopyPoseInto(rebuilt, baseline, boneCount);
+  }
+
+  offset = POSE_SNAPSHOT_HEADER_SIZE;
+  for (int c = 0; c < 3; c++) {
+    int channel = 1 << c;
+    if (!(channels & channel)) {
+      continue;
+    }
+
+    const unsigned char *mask = data + offset;
+    offset += maskSize;
+
+    for (int boneId = 0; boneId < boneCount; boneId++) {
+      if (!((mask[boneId >> 3] >> (boneId & 7)) & 1)) {
+        continue;
+      }
+
+      uint16_t packed[3];
+      for (int i = 0; i < 3; i++) {
+        packed[i] = (uint16_t)PoseSnapshotReadUint16(data + offset + 2 * i);
+      }
+      offset += 6;
+
+      PoseSnapshotDequantizeChannel(&decoder->config, channel, packed, &rebuilt[boneId]);
+    }
+  }
+
+  if (out) {
+    CopyPoseInto(out, rebuilt, boneCount);
+  }
+
+  return sequence;
+}
+
+PoseInterpolationBuffer LoadPoseInterpolationBuffer(int boneCount, int capacity) {
+  PoseInterpolationBuffer buffer = {0};
+
+  buffer.boneCount = boneCount;
+  buffer.capacity = capacity;
+  buffer.times = malloc(capacity * sizeof(float));
+  buffer.poses = malloc(capacity * sizeof(Pose));
+  for (int i = 0; i < capacity; i++) {
+    buffer.poses[i] = InitPose(boneCount);
+  }
+
+  return buffer;
+}
+
+void UnloadPoseInterpolationBuffer(PoseInterpolationBuffer *buffer) {
+  for (int i = 0; i < buffer->capacity; i++) {
+    UnloadPose(buffer->poses[i]);
+  }
+  free(buffer->poses);
+  free(buffer->times);
+
+  *buffer = (PoseInterpolationBuffer){0};
+}
+
+/* Adds copy of `pose` at `time` (e.g. server time of snapshot). Late
+   snapshots are inserted in order; when full, oldest one is dropped. */
+void PoseInterpolationBufferPush(PoseInterpolationBuffer *buffer, float time, Pose pose) {
+  int index = buffer->count;
+  while (index > 0 && buffer->times[index - 1] > time) {
+    index--;
+  }
+
+  // Same time replaces pose in place (before anything is dropped)
+  if (index > 0 && buffer->times[index - 1] == time) {
+    CopyPoseInto(buffer->poses[index - 1], pose, buffer->boneCount);
+    return;
+  }
+
+  if (buffer->count == buffer->capacity) {
+    if (index == 0) {
+      return;
+    }
+
+    // Oldest pose memory is reused at end
+    Pose oldest = buffer->poses[0];
+    memmove(buffer->times, buffer->times + 1, (buffer->count - 1) * sizeof(float));
+    memmove(buffer->poses, buffer->poses + 1, (buffer->count - 1) * sizeof(Pose));
+    buffer->poses[buffer->count - 1] = oldest;
+    buffer->count--;
+    index--;
+  }
+
+  Pose slot = buffer->poses[buffer->count];
+  memmove(buffer->times + index + 1, buffer->times + index, (buffer->count - index) * sizeof(float));
+  memmove(buffer->poses + index + 1, buffer->poses + index, (buffer->count - index) * sizeof(Pose));
+
+  buffer->times[index] = time;
+  buffer->poses[index] = slot;
+  CopyPoseInto(slot, pose, buffer->boneCount);
+  buffer->count++;
+}
+
+/* Pose at `time` (usually current time minus a delay of two or three
+   snapshot intervals) blended from two snapshots around it. Before first
+   or after last snapshot, that snapshot is held. Returns 0 if empty. */
+int PoseInterpolationBufferSampleInto(Pose out, PoseInterpolationBuffer *buffer, float time) {
+  if (buffer->count == 0) {
+    return 0;
+  }
+
+  if (time <= buffer->times[0]) {
+    CopyPoseInto(out, buffer->poses[0], buffer->boneCount);
+    return 1;
+  }
+
+  for (int i = 1; i < buffer->count; i++) {
+    if (time <= buffer->times[i]) {
+      float factor = (time - buffer->times[i - 1]) / (buffer->times[i] - buffer->times[i - 1]);
+      PoseLerpInto(out, buffer->poses[i - 1], buffer->poses[i], buffer->boneCount, factor);
+      return 1;
+    }
+  }
+
+  CopyPoseInto(out, buffer->poses[buffer->count - 1], buffer->boneCount);
+
+  return 1;
+}
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef __KIRAN_RAY_POSE_SOA__
+#define __KIRAN_RAY_POSE_SOA__
+
+#include "pose.h"
+#include "pose_arena.h"
+#include "pose_simd.h"
+
+#include <stdint.h>
+
+/* Struct of arrays layout of `Pose`.
+
+   Each channel of transform is stored in its own array so blending loops
+   walk contiguous floats. Every channel is aligned to `POSE_SOA_ALIGNMENT`
+   bytes and padded to a multiple of `POSE_SOA_LANES` bones. Padding bones
+   hold identity transform, so kernels can always process full lanes.
+
+   Blend functions use SIMD kernels of `pose_simd.h` (when enabled)
+   directly on channels, without any transposition.
+
+   `Pose` (array of `Transform`) is still the layout used by raylib
+   (`ModelAnimation.framePoses`, `Model.bindPose`). Use `PoseToPoseSoA()`
+   and `PoseSoAToPose()` to move between them. */
+
+#define POSE_SOA_ALIGNMENT 64
+#define POSE_SOA_LANES 16
+
+#define POSE_SOA_CHANNELS 10
+
+typedef struct PoseSoA {
+  int boneCount;    // Number of bones
+  int paddedCount;  // Length of each channel (boneCount rounded up to POSE_SOA_LANES)
+
+  float *tx, *ty, *tz;      // Translation
+  float *qx, *qy, *qz, *qw; // Rotation
+  float *sx, *sy, *sz;      // Scale
+
+  void *memory;     // Single allocation holding all channels (NULL if taken from arena)
+} PoseSoA;
+
+PoseSoA LoadPoseSoA(int boneCount);
+PoseSoA LoadPoseSoAFromPose(Pose pose, int boneCount);
+PoseSoA LoadPoseSoAFromArena(PoseArena *arena, int boneCount);
+void UnloadPoseSoA(PoseSoA pose);
+
+Transform PoseSoAGetTransform(PoseSoA pose, int boneId);
+void PoseSoASetTransform(PoseSoA pose, int boneId, Transform transform);
+
+void PoseToPoseSoA(PoseSoA out, Pose pose);
+void PoseSoAToPose(Pose out, PoseSoA pose);
+void CopyPoseSoAInto(PoseSoA out, PoseSoA pose);
+
+/* Same as `Pose...Into()` functions of `pose.h`.
+   `out` can be same as any of the inputs. */
+void PoseSoALerpInto(PoseSoA out, PoseSoA poseA, PoseSoA poseB, float factor);
+void PoseSoAOverrideBlendInto(PoseSoA out, PoseSoA poseA, PoseSoA poseB,
+                              float factor, float *boneMask);
+void PoseSoAAdditiveBlendInto(PoseSoA out, PoseSoA poseA, PoseSoA poseB,
+                              float weightA, float weightB, float *boneMask);
+void PoseSoAGenerateAdditivePoseInto(PoseSoA out, PoseSoA pose,
+                                     PoseSoA referencePose);
+
+void PoseSoAToLocalTransformPoseInto(PoseSoA out, PoseSoA pose,
+                                     BoneInfo *bones);
+void PoseSoAToGlobalTransformPoseInto(PoseSoA out, PoseSoA pose,
+                                      BoneInfo *bones);
+
+void PoseSoAToPoseTransformMatricesInto(Matrix *out, PoseSoA poseA,
+                                        PoseSoA poseB);
+
+int PoseSoAPaddedCount(int boneCount) {
+  return (boneCount + POSE_SOA_LANES - 1) / POSE_SOA_LANES * POSE_SOA_LANES;
+}
+
+Quaternion PoseSoAGetRotation(PoseSoA pose, int i) {
+  return (Quaternion){pose.qx[i], pose.qy[i], pose.qz[i], pose.qw[i]};
+}
+
+void PoseSoASetRotation(PoseSoA pose, int i, Quaternion q) {
+  pose.qx[i] = q.x;
+  pose.qy[i] = q.y;
+  pose.qz[i] = q.z;
+  pose.qw[i] = q.w;
+}
+
+// Pointers to all channels of `pose` starting at `boneId` (in order of
+// `Transform` fields).
+void PoseSoAGetChannels(PoseSoA pose, int boneId, float **channels) {
+  float *all[POSE_SOA_CHANNELS] = {pose.tx, pose.ty, pose.tz,
+                                   pose.qx, pose.qy, pose.qz, pose.qw,
+                                   pose.sx, pose.sy, pose.sz};
+  for (int c = 0; c < POSE_SOA_CHANNELS; c++) {
+    channels[c] = all[c] + boneId;
+  }
+}
+
+// Points channels into `memory` (must be POSE_SOA_ALIGNMENT aligned) and
+// fills every bone with identity transform.
+PoseSoA PoseSoAFromMemory(void *memory, int boneCount) {
+  PoseSoA pose = {0};
+
+  pose.boneCount = boneCount;
+  pose.paddedCount = PoseSoAPaddedCount(boneCount);
+
+  float **channels[POSE_SOA_CHANNELS] = {&pose.tx, &pose.ty, &pose.tz,
+                                         &pose.qx, &pose.qy, &pose.qz, &pose.qw,
+                                         &pose.sx, &pose.sy, &pose.sz};
+  for (int c = 0; c < POSE_SOA_CHANNELS; c++) {
+    *channels[c] = (float *)memory + c * pose.paddedCount;
+  }
+
+  for (int i = 0; i < pose.paddedCount; i++) {
+    pose.tx[i] = pose.ty[i] = pose.tz[i] = 0.0f;
+    pose.qx[i] = pose.qy[i] = pose.qz[i] = 0.0f;
+    pose.qw[i] = 1.0f;
+    pose.sx[i] = pose.sy[i] = pose.sz[i] = 1.0f;
+  }
+
+  return pose;
+}
+
+PoseSoA LoadPoseSoA(int boneCount) {
+  size_t size = POSE_SOA_CHANNELS * PoseSoAPaddedCount(boneCount) * sizeof(float);
+
+  void *memory = malloc(size + POSE_SOA_ALIGNMENT);
+  if (memory == NULL) {
+    TraceLog(LOG_WARNING, "POSE: Failed to allocate SoA pose of %d bones", boneCount);
+    return (PoseSoA){0};
+  }
+
+  uintptr_t aligned = ((uintptr_t)memory + POSE_SOA_ALIGNMENT - 1) &
+                      ~(uintptr_t)(POSE_SOA_ALIGNMENT - 1);
+
+  PoseSoA pose = PoseSoAFromMemory((void *)aligned, boneCount);
+  pose.memory = memory;
+
+  return pose;
+}
+
+PoseSoA LoadPoseSoAFromPose(Pose pose, int boneCount) {
+  PoseSoA soa = LoadPoseSoA(boneCount);
+
+  PoseToPoseSoA(soa, pose);
+
+  return soa;
+}
+
+// Nothing to unload. Memory is given back with arena. Empty (NULL channels)
+// with a warning if allocation fails.
+PoseSoA LoadPoseSoAFromArena(PoseArena *arena, int boneCount) {
+  if (arena == NULL) {
+    return LoadPoseSoA(boneCount);
+  }
+
+  size_t size = POSE_SOA_CHANNELS * PoseSoAPaddedCount(boneCount) * sizeof(float);
+  void *memory = PoseArenaAllocAligned(arena, size, POSE_SOA_ALIGNMENT);
+  if (memory == NULL) {
+    TraceLog(LOG_WARNING, "POSE: Failed to allocate SoA pose of %d bones from arena", boneCount);
+    return (PoseSoA){0};
+  }
+
+  return PoseSoAFromMemory(memory, boneCount);
+}
+
+void UnloadPoseSoA(PoseSoA pose) {
+  if (pose.memory) {
+    free(pose.memory);
+  }
+}
+
+Transform PoseSoAGetTransform(PoseSoA pose, int i) {
+  Transform transform = {0};
+
+  transform.translation = (Vector3){pose.tx[i], pose.ty[i], pose.tz[i]};
+  transform.rotation = PoseSoAGetRotation(pose, i);
+  transform.scale = (Vector3){pose.sx[i], pose.sy[i], pose.sz[i]};
+
+  return transform;
+}
+
+void PoseSoASetTransform(PoseSoA pose, int i, Transform transform) {
+  pose.tx[i] = transform.translation.x;
+  pose.ty[i] = transform.translation.y;
+  pose.tz[i] = transform.translation.z;
+
+  PoseSoASetRotation(pose, i, transform.rotation);
+
+  pose.sx[i] = transform.scale.x;
+  pose.sy[i] = transform.scale.y;
+  pose.sz[i] = transform.scale.z;
+}
+
+void PoseToPoseSoA(PoseSoA out, Pose pose) {
+  for (int i = 0; i < out.boneCount; i++) {
+    PoseSoASetTransform(out, i, pose[i]);
+  }
+}
+
+void PoseSoAToPose(Pose out, PoseSoA pose) {
+  for (int i = 0; i < pose.boneCount; i++) {
+    out[i] = PoseSoAGetTransform(pose, i);
+  }
+}
+
+void CopyPoseSoAInto(PoseSoA out, PoseSoA pose) {
+  if (out.tx != pose.tx) {
+    memmove(out.tx, pose.tx, POSE_SOA_CHANNELS * pose.paddedCount * sizeof(float));
+  }
+}
+
+// Translation and scale are lerped channel by channel, rotation with slerp.
+void PoseSoAOverrideBlendInto(PoseSoA out, PoseSoA poseA, PoseSoA poseB,
+                              float factor, float *boneMask) {
+  int n = out.boneCount;
+
+#if KANIM_SIMD_LANES > 1
+  float *o[POSE_SOA_CHANNELS], *a[POSE_SOA_CHANNELS], *b[POSE_SOA_CHANNELS];
+
+  for (int i = 0; i < n; i += KANIM_SIMD_LANES) {
+    float w[KANIM_SIMD_LANES];
+    for (int l = 0; l < KANIM_SIMD_LANES; l++) {
+      w[l] = (i + l < n) ? ((boneMask) ? factor * boneMask[i + l] : factor) : 0.0f;
+    }
+
+    PoseSoAGetChannels(out, i, o);
+    PoseSoAGetChannels(poseA, i, a);
+    PoseSoAGetChannels(poseB, i, b);
+
+    TransformLerpBlock(o, a, b, w, 0);
+  }
+#else
+
+  for (int i = 0; i < n; i++) {
+    float weight = (boneMask) ? factor * boneMask[i] : factor;
+
+    PoseSoASetRotation(out, i, QuaternionSlerp(PoseSoAGetRotation(poseA, i),
+                                               PoseSoAGetRotation(poseB, i),
+                                               weight));
+  }
+
+  float *a[6] = {poseA.tx, poseA.ty, poseA.tz, poseA.sx, poseA.sy, poseA.sz};
+  float *b[6] = {poseB.tx, poseB.ty, poseB.tz, poseB.sx, poseB.sy, poseB.sz};
+  float *o[6] = {out.tx, out.ty, out.tz, out.sx, out.sy, out.sz};
+
+  for (int c = 0; c < 6; c++) {
+    float *ca = a[c], *cb = b[c], *co = o[c];
+
+    if (boneMask) {
+      for (int i = 0; i < n; i++) {
+        co[i] = ca[i] + factor * boneMask[i] * (cb[i] - ca[i]);
+      }
+    } else {
+      for (int i = 0; i < n; i++) {
+        co[i] = ca[i] + factor * (cb[i] - ca[i]);
+      }
+    }
+  }
+#endif
+}
+
+void PoseSoALerpInto(PoseSoA out, PoseSoA poseA, PoseSoA poseB, float factor) {
+  PoseSoAOverrideBlendInto(out, poseA, poseB, factor, NULL);
+}
+
+void PoseSoAAdditiveBlendInto(PoseSoA out, PoseSoA poseA, PoseSoA poseB,
+                              float weightA, float weightB, float *boneMask) {
+  int n = out.boneCount;
+
+#if KANIM_SIMD_LANES > 1
+  float *o[POSE_SOA_CHANNELS], *a[POSE_SOA_CHANNELS], *b[POSE_SOA_CHANNELS];
+
+  for (int i = 0; i < n; i += KANIM_SIMD_LANES) {
+    float w[KANIM_SIMD_LANES];
+    for (int l = 0; l < KANIM_SIMD_LANES; l++) {
+      w[l] = (i + l < n) ? ((boneMask) ? weightB * boneMask[i + l] : weightB) : 0.0f;
+    }
+
+    PoseSoAGetChannels(out, i, o);
+    PoseSoAGetChannels(poseA, i, a);
+    PoseSoAGetChannels(poseB, i, b);
+
+    TransformAdditiveBlock(o, a, b, weightA, w, 0);
+  }
+#else
+
+  // Same functions as scalar `TransformAdditiveBatch()` (`pow()` on scale)
+  for (int i = 0; i < n; i++) {
+    float weight = (boneMask) ? weightB * boneMask[i] : weightB;
+
+    Transform base = TransformScale(PoseSoAGetTransform(poseA, i), weightA);
+    Transform additive = TransformScale(PoseSoAGetTransform(poseB, i), weight);
+
+    PoseSoASetTransform(out, i, TransformApply(base, additive));
+  }
+#endif
+}
+
+void PoseSoAGenerateAdditivePoseInto(PoseSoA out, PoseSoA pose,
+                                     PoseSoA referencePose) {
+  for (int i = 0; i < out.boneCount; i++) {
+    PoseSoASetTransform(out, i,
+                        RelativeTransform(PoseSoAGetTransform(pose, i),
+                                          PoseSoAGetTransform(referencePose, i)));
+  }
+}
+
+// Same as `PoseToLocalTransformPoseInto()`. Children are visited first so
+// that `out` can be same as `globalPose`.
+void PoseSoAToLocalTransformPoseInto(PoseSoA out, PoseSoA globalPose,
+                                     BoneInfo *bones) {
+  for (int i = out.boneCount - 1; i >= 0; i--) {
+    int parentIndex = bones[i].parent;
+    if (parentIndex == -1) {
+      PoseSoASetTransform(out, i, PoseSoAGetTransform(globalPose, i));
+      continue;
+    }
+
+    Transform parent = PoseSoAGetTransform(globalPose, parentIndex);
+    Transform global = PoseSoAGetTransform(globalPose, i);
+    Quaternion invParentRotation = QuaternionInvert(parent.rotation);
+
+    Transform local = {0};
+    local.translation = Vector3RotateByQuaternion(
+        Vector3Subtract(global.translation, parent.translation),
+        invParentRotation);
+    local.rotation = QuaternionMultiply(invParentRotation, global.rotation);
+    local.scale = Vector3Divide(global.scale, parent.scale);
+
+    PoseSoASetTransform(out, i, local);
+  }
+}
+
+void PoseSoAToGlobalTransformPoseInto(PoseSoA out, PoseSoA localPose,
+                                      BoneInfo *bones) {
+  for (int i = 0; i < out.boneCount; i++) {
+    int parentIndex = bones[i].parent;
+    if (parentIndex == -1) {
+      PoseSoASetTransform(out, i, PoseSoAGetTransform(localPose, i));
+      continue;
+    }
+
+    Transform parent = PoseSoAGetTransform(out, parentIndex);
+    Transform local = PoseSoAGetTransform(localPose, i);
+
+    Transform global = {0};
+    global.translation = Vector3Add(
+        parent.translation,
+        Vector3RotateByQuaternion(local.translation, parent.rotation));
+    global.rotation = QuaternionMultiply(parent.rotation, local.rotation);
+    global.scale = Vector3Multiply(parent.scale, local.scale);
+
+    PoseSoASetTransform(out, i, global);
+  }
+}
+
+// Skinning matrices from bind pose (`poseA`) to current pose (`poseB`).
+void PoseSoAToPoseTransformMatricesInto(Matrix *out, PoseSoA poseA,
+                                        PoseSoA poseB) {
+  for (int i = 0; i < poseA.boneCount; i++) {
+    out[i] = TransformToMatrix(TransformToTransformTransform(
+        PoseSoAGetTransform(poseA, i), PoseSoAGetTransform(poseB, i)));
+  }
+}
+
+#endif
@@ -0,0 +1,306 @@
+#ifndef __KIRAN_RAY_QUANTIZED_CLIP__
+#define __KIRAN_RAY_QUANTIZED_CLIP__
+
+#include "animation_clip.h"
+#include "pose_soa.h"
+
+#include <stdint.h>
+
+#define QUANTIZED_ROTATION_BITS 15
+#define QUANTIZED_ROTATION_MAX ((1 << QUANTIZED_ROTATION_BITS) - 1)
+#define QUANTIZED_CHANNEL_MAX 65535
+
+/* Bone transform in 18 bytes (instead of 40).
+    - rotation: Smallest three. Index of largest component (2 bits) and
+        other three components (15 bits each, in [-1/sqrt(2), 1/sqrt(2)])
+        packed in 48 bits. Largest component is made positive and rebuilt
+        while decoding.
+    - translation/scale: 16 bits per component, normalized to range of that
+        bone in whole clip. */
+typedef struct QuantizedTransform {
+  uint16_t rotation[3];
+  uint16_t translation[3];
+  uint16_t scale[3];
+} QuantizedTransform;
+
+/* Quantized frames of an `AnimationClip` (one space) in one allocation.
+
+   Max decode error (per component):
+    - rotation: 1/sqrt(2)/QUANTIZED_ROTATION_MAX (about 2.2e-5)
+    - translation/scale: half of range step (`...Extent / 65535 / 2`) */
+typedef struct QuantizedClip {
+  int boneCount;          // Number of bones per frame
+  int frameCount;         // Number of frames
+  int flags;              // Space of frames (CLIP_GLOBAL_POSE or CLIP_LOCAL_POSE) and CLIP_ADDITIVE
+
+  Vector3 *translationMin;    // Min translation of each bone
+  Vector3 *translationExtent; // Translation range of each bone
+  Vector3 *scaleMin;          // Min scale of each bone
+  Vector3 *scaleExtent;       // Scale range of each bone
+
+  QuantizedTransform *frames; // `frameCount * boneCount` transforms
+
+  char name[32];          // Name of clip
+} QuantizedClip;
+
+void QuantizeRotation(uint16_t *out, Quaternion q);
+Quaternion DequantizeRotation(uint16_t *packed);
+
+QuantizedClip LoadQuantizedClip(AnimationClip clip, int space);
+void UnloadQuantizedClip(QuantizedClip clip);
+size_t QuantizedClipMemorySize(QuantizedClip clip);
+
+Transform QuantizedClipDecodeTransform(QuantizedClip clip, int frame, int boneId);
+void QuantizedClipDecodePoseInto(Pose out, QuantizedClip clip, int frame);
+void QuantizedClipDecodePoseSoAInto(PoseSoA out, QuantizedClip clip, int frame);
+Vector3 QuantizedClipMaxTranslationError(QuantizedClip clip, int boneId);
+
+/* Max distance between world (global) bone positions of decoded and
+   `source` frames. `source` must be the clip quantized (any stored space).
+   Frame and bone of max error are written to `frame`/`boneId` if not NULL. */
+float QuantizedClipMeasureWorldError(QuantizedClip clip, AnimationClip source,
+                                     SkeletonHierarchy *hierarchy, int *frame,
+                                     int *boneId);
+
+void QuantizeRotation(uint16_t *out, Quaternion q) {
+  float c[4] = {q.x, q.y, q.z, q.w};
+
+  int largest = 0;
+  for (int i = 1; i < 4; i++) {
+    if (fabsf(c[i]) > fabsf(c[largest])) {
+      largest = i;
+    }
+  }
+
+  // q and -q are same rotation. So, largest is kept positive (not stored).
+  float sign = (c[largest] < 0.0f) ? -1.0f : 1.0f;
+
+  uint64_t packed = (uint64_t)largest << (3 * QUANTIZED_ROTATION_BITS);
+  int shift = 2 * QUANTIZED_ROTATION_BITS;
+  for (int i = 0; i < 4; i++) {
+    if (i == largest) {
+      continue;
+    }
+
+    float v = sign * c[i] * 1.41421356f * 0.5f + 0.5f; // [-1/sqrt(2), 1/sqrt(2)] -> [0, 1]
+    v = Clamp(v, 0.0f, 1.0f);
+
+    packed |= (uint64_t)(v * QUANTIZED_ROTATION_MAX + 0.5f) << shift;
+    shift -= QUANTIZED_ROTATION_BITS;
+  }
+
+  out[0] = (uint16_t)(packed >> 32);
+  out[1] = (uint16_t)(packed >> 16);
+  out[2] = (uint16_t)packed;
+}
+
+Quaternion DequantizeRotation(uint16_t *packed) {
+  uint64_t bits = ((uint64_t)packed[0] << 32) | ((uint64_t)packed[1] << 16) | packed[2];
+
+  int largest = (int)(bits >> (3 * QUANTIZED_ROTATION_BITS)) & 3;
+
+  float c[4];
+  float sum = 0.0f;
+  int shift = 2 * QUANTIZED_ROTATION_BITS;
+  for (int i = 0; i < 4; i++) {
+    if (i == largest) {
+      continue;
+    }
+
+    float v = (float)((bits >> shift) & QUANTIZED_ROTATION_MAX) / QUANTIZED_ROTATION_MAX;
+    c[i] = (v - 0.5f) * 1.41421356f;
+    sum += c[i] * c[i];
+    shift -= QUANTIZED_ROTATION_BITS;
+  }
+
+  c[largest] = sqrtf(fmaxf(1.0f - sum, 0.0f));
+
+  return (Quaternion){c[0], c[1], c[2], c[3]};
+}
+
+uint16_t QuantizeChannel(float value, float min, float extent) {
+  if (extent <= 0.0f) {
+    return 0;
+  }
+
+  float v = Clamp((value - min) / extent, 0.0f, 1.0f);
+
+  return (uint16_t)(v * QUANTIZED_CHANNEL_MAX + 0.5f);
+}
+
+float DequantizeChannel(uint16_t value, float min, float extent) {
+  return min + extent * ((float)value / QUANTIZED_CHANNEL_MAX);
+}
+
+/* Quantizes frames of `clip` in `space` (`CLIP_GLOBAL_POSE` or
+   `CLIP_LOCAL_POSE`). Clip must store that space. Local space is preferred
+   as ranges per bone are much smaller. */
+QuantizedClip LoadQuantizedClip(AnimationClip clip, int space) {
+  QuantizedClip quantized = {0};
+
+  Transform *source = (space & CLIP_LOCAL_POSE) ? clip.localFrames : clip.globalFrames;
+  if (!AnimationClipIsValid(clip) || source == NULL) {
+    TraceLog(LOG_WARNING, "CLIP: Clip \"%s\" does not store space to quantize", clip.name);
+    return quantized;
+  }
+
+  int boneCount = clip.boneCount;
+  size_t rangesSize = 4 * boneCount * sizeof(Vector3);
+  size_t framesSize = (size_t)clip.frameCount * boneCount * sizeof(QuantizedTransform);
+
+  // Ranges and frames in one allocation (freed with `translationMin`)
+  unsigned char *memory = malloc(rangesSize + framesSize);
+  if (memory == NULL) {
+    TraceLog(LOG_WARNING, "CLIP: Failed to allocate quantized frames of \"%s\"", clip.name);
+    return quantized;
+  }
+
+  quantized.boneCount = boneCount;
+  quantized.frameCount = clip.frameCount;
+  quantized.flags = (space & CLIP_LOCAL_POSE) ? CLIP_LOCAL_POSE : CLIP_GLOBAL_POSE;
+  quantized.flags |= clip.flags & CLIP_ADDITIVE;
+  memcpy(quantized.name, clip.name, sizeof(quantized.name));
+
+  quantized.translationMin = (Vector3 *)memory;
+  quantized.translationExtent = quantized.translationMin + boneCount;
+  quantized.scaleMin = quantized.translationExtent + boneCount;
+  quantized.scaleExtent = quantized.scaleMin + boneCount;
+  quantized.frames = (QuantizedTransform *)(memory + rangesSize);
+
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    Vector3 tMin = source[boneId].translation, tMax = tMin;
+    Vector3 sMin = source[boneId].scale, sMax = sMin;
+
+    for (int frame = 1; frame < clip.frameCount; frame++) {
+      Transform t = source[(size_t)frame * boneCount + boneId];
+
+      tMin = Vector3Min(tMin, t.translation);
+      tMax = Vector3Max(tMax, t.translation);
+      sMin = Vector3Min(sMin, t.scale);
+      sMax = Vector3Max(sMax, t.scale);
+    }
+
+    quantized.translationMin[boneId] = tMin;
+    quantized.translationExtent[boneId] = Vector3Subtract(tMax, tMin);
+    quantized.scaleMin[boneId] = sMin;
+    quantized.scaleExtent[boneId] = Vector3Subtract(sMax, sMin);
+  }
+
+  for (int frame = 0; frame < clip.frameCount; frame++) {
+    for (int boneId = 0; boneId < boneCount; boneId++) {
+      size_t index = (size_t)frame * boneCount + boneId;
+      Transform t = source[index];
+      QuantizedTransform *q = &quantized.frames[index];
+
+      Vector3 tMin = quantized.translationMin[boneId], tExtent = quantized.translationExtent[boneId];
+      Vector3 sMin = quantized.scaleMin[boneId], sExtent = quantized.scaleExtent[boneId];
+
+      QuantizeRotation(q->rotation, t.rotation);
+
+      q->translation[0] = QuantizeChannel(t.translation.x, tMin.x, tExtent.x);
+      q->translation[1] = QuantizeChannel(t.translation.y, tMin.y, tExtent.y);
+      q->translation[2] = QuantizeChannel(t.translation.z, tMin.z, tExtent.z);
+
+      q->scale[0] = QuantizeChannel(t.scale.x, sMin.x, sExtent.x);
+      q->scale[1] = QuantizeChannel(t.scale.y, sMin.y, sExtent.y);
+      q->scale[2] = QuantizeChannel(t.scale.z, sMin.z, sExtent.z);
+    }
+  }
+
+  return quantized;
+}
+
+void UnloadQuantizedClip(QuantizedClip clip) {
+  free(clip.translationMin);
+}
+
+size_t QuantizedClipMemorySize(QuantizedClip clip) {
+  return 4 * clip.boneCount * sizeof(Vector3) +
+         (size_t)clip.frameCount * clip.boneCount * sizeof(QuantizedTransform);
+}
+
+Transform QuantizedClipDecodeTransform(QuantizedClip clip, int frame, int boneId) {
+  QuantizedTransform *q = &clip.frames[(size_t)frame * clip.boneCount + boneId];
+  Vector3 tMin = clip.translationMin[boneId], tExtent = clip.translationExtent[boneId];
+  Vector3 sMin = clip.scaleMin[boneId], sExtent = clip.scaleExtent[boneId];
+
+  Transform t = {0};
+
+  t.rotation = DequantizeRotation(q->rotation);
+
+  t.translation.x = DequantizeChannel(q->translation[0], tMin.x, tExtent.x);
+  t.translation.y = DequantizeChannel(q->translation[1], tMin.y, tExtent.y);
+  t.translation.z = DequantizeChannel(q->translation[2], tMin.z, tExtent.z);
+
+  t.scale.x = DequantizeChannel(q->scale[0], sMin.x, sExtent.x);
+  t.scale.y = DequantizeChannel(q->scale[1], sMin.y, sExtent.y);
+  t.scale.z = DequantizeChannel(q->scale[2], sMin.z, sExtent.z);
+
+  return t;
+}
+
+// Decodes `frame` (wrapped around) into `out` (in space of clip).
+void QuantizedClipDecodePoseInto(Pose out, QuantizedClip clip, int frame) {
+  frame %= clip.frameCount;
+  if (frame < 0) {
+    frame += clip.frameCount;
+  }
+
+  for (int boneId = 0; boneId < clip.boneCount; boneId++) {
+    out[boneId] = QuantizedClipDecodeTransform(clip, frame, boneId);
+  }
+}
+
+// Same as above but into SoA blend buffer (`out.boneCount` must match).
+void QuantizedClipDecodePoseSoAInto(PoseSoA out, QuantizedClip clip, int frame) {
+  frame %= clip.frameCount;
+  if (frame < 0) {
+    frame += clip.frameCount;
+  }
+
+  for (int boneId = 0; boneId < clip.boneCount; boneId++) {
+    PoseSoASetTransform(out, boneId, QuantizedClipDecodeTransform(clip, frame, boneId));
+  }
+}
+
+// Max translation error of bone in space of clip (half of quantization step).
+Vector3 QuantizedClipMaxTranslationError(QuantizedClip clip, int boneId) {
+  return Vector3Scale(clip.translationExtent[boneId], 0.5f / QUANTIZED_CHANNEL_MAX);
+}
+
+float QuantizedClipMeasureWorldError(QuantizedClip clip, AnimationClip source,
+                                     SkeletonHierarchy *hierarchy, int *frame,
+                                     int *boneId) {
+  float maxError = 0.0f;
+
+  Pose decoded = InitPose(2 * clip.boneCount);
+  Pose temp = decoded + clip.boneCount;
+
+  for (int f = 0; f < clip.frameCount; f++) {
+    QuantizedClipDecodePoseInto(decoded, clip, f);
+    if (clip.flags & CLIP_LOCAL_POSE) {
+      PoseToGlobalTransformPoseHierarchyInto(decoded, decoded, hierarchy);
+    }
+
+    Pose reference = AnimationClipResolvePose(source, f, CLIP_GLOBAL_POSE, hierarchy, temp);
+
+    for (int b = 0; b < clip.boneCount; b++) {
+      float error = Vector3Distance(decoded[b].translation, reference[b].translation);
+      if (error > maxError) {
+        maxError = error;
+        if (frame) {
+          *frame = f;
+        }
+        if (boneId) {
+          *boneId = b;
+        }
+      }
+    }
+  }
+
+  UnloadPose(decoded);
+
+  return maxError;
+}
+
+#endif
@@ -0,0 +1,476 @@
+#ifndef __KIRAN_RAY_REDUCED_CLIP__
+#define __KIRAN_RAY_REDUCED_CLIP__
+
+#include "animation_clip.h"
+
+#define CURVE_LINEAR 0
+#define CURVE_CATMULL_ROM 1
+
+#define REDUCED_CLIP_MAX_PASSES 8
+
+/* Keyframe reduced clip (local space).
+
+   Every bone track keeps only the frames (keys) needed to rebuild all
+   frames by interpolating between keys (`curve`) within error budget given
+   while loading. Held frames collapse into the keys at both ends of the
+   hold and a bone that never moves keeps a single key.
+
+   Keys of bone `b` are `keyFrames[keyStart[b]]` to
+   `keyFrames[keyStart[b + 1] - 1]` (with `keyValues` at same indices). */
+typedef struct ReducedClip {
+  int boneCount;        // Number of bones
+  int frameCount;       // Number of frames of source clip
+  int curve;            // CURVE_LINEAR or CURVE_CATMULL_ROM
+
+  int keyCount;         // Number of keys of all bones
+  int *keyStart;        // `boneCount + 1` offsets into keys
+  int *keyFrames;       // Frame of every key
+  Transform *keyValues; // Local transform of every key
+
+  float error;          // Max world space error measured while loading
+  char name[32];        // Name of clip
+} ReducedClip;
+
+ReducedClip LoadReducedClip(AnimationClip clip, SkeletonHierarchy *hierarchy,
+                            float maxError, int curve);
+void UnloadReducedClip(ReducedClip clip);
+size_t ReducedClipMemorySize(ReducedClip clip);
+
+Transform ReducedClipSampleBone(ReducedClip clip, int boneId, float frame);
+void ReducedClipSamplePoseInto(Pose out, ReducedClip clip, float frame);
+
+float ReducedClipMeasureWorldError(ReducedClip clip, AnimationClip source,
+                                   SkeletonHierarchy *hierarchy, int *frame,
+                                   int *boneId);
+
+// Hermite interpolation of one value with Catmull-Rom tangents (keys can be unevenly spaced).
+float CatmullRomValue(float pm, float p0, float p1, float pp, float tm,
+                      float t0, float t1, float tp, float t) {
+  float h = t1 - t0;
+  float u = (t - t0) / h;
+
+  float m0 = (p1 - pm) / (t1 - tm);
+  float m1 = (pp - p0) / (tp - t0);
+
+  float u2 = u * u;
+  float u3 = u2 * u;
+
+  return (2.0f * u3 - 3.0f * u2 + 1.0f) * p0 + (u3 - 2.0f * u2 + u) * h * m0 +
+         (-2.0f * u3 + 3.0f * u2) * p1 + (u3 - u2) * h * m1;
+}
+
+Quaternion QuaternionAlign(Quaternion q, Quaternion reference) {
+  if (q.x * reference.x + q.y * reference.y + q.z * reference.z + q.w * reference.w < 0.0f) {
+    return (Quaternion){-q.x, -q.y, -q.z, -q.w};
+  }
+
+  return q;
+}
+
+/* Value of track at `frame` from keys (`frames`, `values`, `count` keys).
+   `key` is the key at or before `frame`. */
+Transform InterpolateKeys(int *frames, Transform *values, int count, int key,
+                          float frame, int curve) {
+  if (key >= count - 1) {
+    return values[count - 1];
+  }
+  if (frame <= frames[key]) {
+    return values[key];
+  }
+
+  Transform a = values[key];
+  Transform b = values[key + 1];
+  float t0 = (float)frames[key], t1 = (float)frames[key + 1];
+
+  if (curve == CURVE_LINEAR) {
+    return TransformLerp(a, b, (frame - t0) / (t1 - t0));
+  }
+
+  Transform am = (key > 0) ? values[key - 1] : a;
+  Transform bp = (key + 2 < count) ? values[key + 2] : b;
+  float tm = (key > 0) ? (float)frames[key - 1] : t0;
+  float tp = (key + 2 < count) ? (float)frames[key + 2] : t1;
+
+  // Missing neighbour is mirrored across end key (tangent of segment itself)
+  if (key == 0) {
+    Quaternion aligned = QuaternionAlign(b.rotation, a.rotation);
+    am.translation = Vector3Subtract(Vector3Scale(a.translation, 2.0f), b.translation);
+    am.scale = Vector3Subtract(Vector3Scale(a.scale, 2.0f), b.scale);
+    am.rotation = (Quaternion){2.0f * a.rotation.x - aligned.x, 2.0f * a.rotation.y - aligned.y,
+                               2.0f * a.rotation.z - aligned.z, 2.0f * a.rotation.w - aligned.w};
+    tm = 2.0f * t0 - t1;
+  }
+  if (key + 2 >= count) {
+    Quaternion aligned = QuaternionAlign(a.rotation, b.rotation);
+    bp.translation = Vector3Subtract(Vector3Scale(b.translation, 2.0f), a.translation);
+    bp.scale = Vector3Subtract(Vector3Scale(b.scale, 2.0f), a.scale);
+    bp.rotation = (Quaternion){2.0f * b.rotation.x - aligned.x, 2.0f * b.rotation.y - aligned.y,
+                               2.0f * b.rotation.z - aligned.z, 2.0f * b.rotation.w - aligned.w};
+    tp = 2.0f * t1 - t0;
+  }
+
+  // Rotations in hemisphere of `a` so components can be interpolated
+  Quaternion qm = QuaternionAlign(am.rotation, a.rotation);
+  Quaternion q1 = QuaternionAlign(b.rotation, a.rotation);
+  Quaternion qp = QuaternionAlign(bp.rotation, q1);
+
+  Transform out = {0};
+
+  out.translation.x = CatmullRomValue(am.translation.x, a.translation.x, b.translation.x, bp.translation.x, tm, t0, t1, tp, frame);
+  out.translation.y = CatmullRomValue(am.translation.y, a.translation.y, b.translation.y, bp.translation.y, tm, t0, t1, tp, frame);
+  out.translation.z = CatmullRomValue(am.translation.z, a.translation.z, b.translation.z, bp.translation.z, tm, t0, t1, tp, frame);
+
+  out.rotation.x = CatmullRomValue(qm.x, a.rotation.x, q1.x, qp.x, tm, t0, t1, tp, frame);
+  out.rotation.y = CatmullRomValue(qm.y, a.rotation.y, q1.y, qp.y, tm, t0, t1, tp, frame);
+  out.rotation.z = CatmullRomValue(qm.z, a.rotation.z, q1.z, qp.z, tm, t0, t1, tp, frame);
+  out.rotation.w = CatmullRomValue(qm.w, a.rotation.w, q1.w, qp.w, tm, t0, t1, tp, frame);
+  out.rotation = QuaternionNormalize(out.rotation);
+
+  out.scale.x = CatmullRomValue(am.scale.x, a.scale.x, b.scale.x, bp.scale.x, tm, t0, t1, tp, frame);
+  out.scale.y = CatmullRomValue(am.scale.y, a.scale.y, b.scale.y, bp.scale.y, tm, t0, t1, tp, frame);
+  out.scale.z = CatmullRomValue(am.scale.z, a.scale.z, b.scale.z, bp.scale.z, tm, t0, t1, tp, frame);
+
+  return out;
+}
+
+/* Error of local transform as distance moved by a point `reach` away from
+   bone (its furthest descendant). */
+float TransformReachError(Transform a, Transform b, float reach) {
+  float translationError = Vector3Distance(a.translation, b.translation);
+
+  Quaternion delta = QuaternionMultiply(QuaternionInvert(a.rotation), b.rotation);
+  float sinHalfAngle = sqrtf(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+  float angle = 2.0f * asinf(fminf(sinHalfAngle, 1.0f));
+
+  Vector3 scaleDelta = Vector3Subtract(a.scale, b.scale);
+  float scaleError = fmaxf(fabsf(scaleDelta.x), fmaxf(fabsf(scaleDelta.y), fabsf(scaleDelta.z)));
+
+  return translationError + reach * (angle + scaleError);
+}
+
+// Fits keys to one bone track. Returns number of keys written to `keys`.
+int FitBoneTrack(Transform *track, int stride, int frameCount, float tolerance,
+                 float reach, int curve, int *keys, Transform *values,
+                 int *worstFrames) {
+  if (frameCount == 1) {
+    keys[0] = 0;
+    values[0] = track[0];
+    return 1;
+  }
+
+  // Whole track held at first frame
+  int held = 1;
+  for (int f = 1; f < frameCount && held; f++) {
+    held = TransformReachError(track[0], track[(size_t)f * stride], reach) <= tolerance;
+  }
+  if (held) {
+    keys[0] = 0;
+    values[0] = track[0];
+    return 1;
+  }
+
+  int count = 2;
+  keys[0] = 0;
+  keys[1] = frameCount - 1;
+  values[0] = track[0];
+  values[1] = track[(size_t)(frameCount - 1) * stride];
+
+  // Insert worst frame of every segment above tolerance till none is left
+  while (1) {
+    int worstCount = 0;
+
+    for (int key = 0; key < count - 1; key++) {
+      float worstError = tolerance;
+      int worstFrame = -1;
+
+      for (int f = keys[key] + 1; f < keys[key + 1]; f++) {
+        Transform t = InterpolateKeys(keys, values, count, key, (float)f, curve);
+        float error = TransformReachError(t, track[(size_t)f * stride], reach);
+        if (error > worstError) {
+          worstError = error;
+          worstFrame = f;
+        }
+      }
+
+      if (worstFrame != -1) {
+        worstFrames[worstCount++] = worstFrame;
+      }
+    }
+
+    if (worstCount == 0) {
+      break;
+    }
+
+    // Merge worst frames (sorted) into keys (sorted) from the back
+    int total = count + worstCount;
+    int k = count - 1, w = worstCount - 1;
+    for (int i = total - 1; i >= 0; i--) {
+      if (w < 0 || (k >= 0 && keys[k] > worstFrames[w])) {
+        keys[i] = keys[k];
+        values[i] = values[k];
+        k--;
+      } else {
+        keys[i] = worstFrames[w];
+        values[i] = track[(size_t)worstFrames[w] * stride];
+        w--;
+      }
+    }
+    count = total;
+  }
+
+  return count;
+}
+
+/* Reduces `clip` so that world position of every bone (and of its
+   furthest descendant) stays within `maxError` of the source.
+
+   Budget is split over the longest parent chain (errors of ancestors add
+   up down the chain). Result is measured in world space and bones on
+   chains still above budget are refit with tighter budget. If budget is
+   still missed after `REDUCED_CLIP_MAX_PASSES` passes, clip is returned
+   as is with a warning (achieved error is in `error` of result). */
+ReducedClip LoadReducedClip(AnimationClip clip, SkeletonHierarchy *hierarchy,
+                            float maxError, int curve) {
+  ReducedClip reduced = {0};
+
+  if (!AnimationClipIsValid(clip) || (clip.flags & CLIP_ADDITIVE) ||
+      hierarchy->boneCount != clip.boneCount) {
+    TraceLog(LOG_WARNING, "CLIP: Can not reduce clip \"%s\"", clip.name);
+    return reduced;
+  }
+
+  int boneCount = clip.boneCount;
+  int frameCount = clip.frameCount;
+
+  // Local and global frames of source
+  AnimationClip source = LoadEmptyAnimationClip(boneCount, frameCount, CLIP_GLOBAL_POSE | CLIP_LOCAL_POSE);
+  for (int frame = 0; frame < frameCount; frame++) {
+    CopyPoseInto(AnimationClipGetGlobalPose(source, frame),
+                 AnimationClipResolvePose(clip, frame, CLIP_GLOBAL_POSE, hierarchy, AnimationClipGetLocalPose(source, frame)),
+                 boneCount);
+    CopyPoseInto(AnimationClipGetLocalPose(source, frame),
+                 AnimationClipResolvePose(clip, frame, CLIP_LOCAL_POSE, hierarchy, AnimationClipGetLocalPose(source, frame)),
+                 boneCount);
+  }
+
+  // Keys of a bone never exceed frame count. Fit into worst case buffers.
+  float *reach = calloc(2 * boneCount, sizeof(float));
+  int *keyStart = malloc((boneCount + 1) * sizeof(int));
+  int *keyFrames = malloc((size_t)boneCount * frameCount * sizeof(int));
+  Transform *keyValues = malloc((size_t)boneCount * frameCount * sizeof(Transform));
+  int *worstFrames = malloc(frameCount * sizeof(int));
+  int *keyCounts = calloc(boneCount, sizeof(int));
+  int *refit = malloc(boneCount * sizeof(int));
+  Pose sampled = InitPose(boneCount);
+
+  if (reach == NULL || keyStart == NULL || keyFrames == NULL || keyValues == NULL ||
+      worstFrames == NULL || keyCounts == NULL || refit == NULL || sampled == NULL) {
+    TraceLog(LOG_WARNING, "CLIP: Failed to allocate reduced clip \"%s\"", clip.name);
+    free(reach);
+    free(keyStart);
+    free(keyFrames);
+    free(keyValues);
+    free(worstFrames);
+    free(keyCounts);
+    free(refit);
+    UnloadPose(sampled);
+    UnloadAnimationClip(source);
+    return reduced;
+  }
+
+  // Reach of every bone. Leaf reach is its own length (stands in for mesh around it).
+  float *tolerance = reach + boneCount;
+
+  for (int frame = 0; frame < frameCount; frame++) {
+    Pose global = AnimationClipGetGlobalPose(source, frame);
+    Pose local = AnimationClipGetLocalPose(source, frame);
+
+    for (int boneId = 0; boneId < boneCount; boneId++) {
+      int start = hierarchy->orderIndex[boneId];
+      float r = Vector3Length(local[boneId].translation);
+
+      for (int i = start + 1; i < start + hierarchy->subtreeSize[boneId]; i++) {
+        r = fmaxf(r, Vector3Distance(global[boneId].translation, global[hierarchy->order[i]].translation));
+      }
+
+      reach[boneId] = fmaxf(reach[boneId], r);
+    }
+  }
+
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    tolerance[boneId] = maxError / hierarchy->levelCount;
+  }
+
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    refit[boneId] = 1;
+  }
+
+  reduced.boneCount = boneCount;
+  reduced.frameCount = frameCount;
+  reduced.curve = curve;
+  reduced.keyStart = keyStart;
+  memcpy(reduced.name, clip.name, sizeof(reduced.name));
+
+  int failed = 0;
+  for (int pass = 0; pass < REDUCED_CLIP_MAX_PASSES; pass++) {
+    for (int boneId = 0; boneId < boneCount; boneId++) {
+      if (refit[boneId]) {
+        size_t offset = (size_t)boneId * frameCount;
+        keyCounts[boneId] = FitBoneTrack(source.localFrames + boneId, boneCount, frameCount,
+                                         tolerance[boneId], reach[boneId], curve,
+                                         keyFrames + offset, keyValues + offset, worstFrames);
+        refit[boneId] = 0;
+      }
+    }
+
+    // Measure in world space (keys are still in per bone worst case layout)
+    failed = 0;
+    reduced.error = 0.0f;
+    for (int frame = 0; frame < frameCount; frame++) {
+      for (int boneId = 0; boneId < boneCount; boneId++) {
+        size_t offset = (size_t)boneId * frameCount;
+        int count = keyCounts[boneId];
+
+        int key = 0;
+        while (key + 1 < count && keyFrames[offset + key + 1] <= frame) {
+          key++;
+        }
+
+        sampled[boneId] = InterpolateKeys(keyFrames + offset, keyValues + offset, count, key, (float)frame, curve);
+      }
+
+      PoseToGlobalTransformPoseHierarchyInto(sampled, sampled, hierarchy);
+      Pose global = AnimationClipGetGlobalPose(source, frame);
+
+      for (int boneId = 0; boneId < boneCount; boneId++) {
+        float error = Vector3Distance(sampled[boneId].translation, global[boneId].translation);
+        reduced.error = fmaxf(reduced.error, error);
+
+        if (error > maxError) {
+          // Tighten whole parent chain
+          for (int b = boneId; b != -1; b = hierarchy->parents[b]) {
+            if (!refit[b]) {
+              refit[b] = 1;
+              tolerance[b] *= 0.5f;
+            }
+          }
+          failed = 1;
+        }
+      }
+    }
+
+    if (!failed) {
+      break;
+    }
+  }
+
+  if (failed) {
+    TraceLog(LOG_WARNING, "CLIP: Reduced clip \"%s\" misses error budget after %d passes (%f > %f)",
+             clip.name, REDUCED_CLIP_MAX_PASSES, reduced.error, maxError);
+  }
+
+  // Pack keys of all bones
+  int keyCount = 0;
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    keyStart[boneId] = keyCount;
+    keyCount += keyCounts[boneId];
+  }
+  keyStart[boneCount] = keyCount;
+
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    size_t offset = (size_t)boneId * frameCount;
+
+    memmove(keyFrames + keyStart[boneId], keyFrames + offset, keyCounts[boneId] * sizeof(int));
+    memmove(keyValues + keyStart[boneId], keyValues + offset, keyCounts[boneId] * sizeof(Transform));
+  }
+
+  // Shrinking can not fail in practice, keep worst case buffers if it does
+  int *packedFrames = realloc(keyFrames, keyCount * sizeof(int));
+  Transform *packedValues = realloc(keyValues, keyCount * sizeof(Transform));
+
+  reduced.keyCount = keyCount;
+  reduced.keyFrames = (packedFrames != NULL) ? packedFrames : keyFrames;
+  reduced.keyValues = (packedValues != NULL) ? packedValues : keyValues;
+
+  UnloadPose(sampled);
+  free(refit);
+  free(keyCounts);
+  free(worstFrames);
+  free(reach);
+  UnloadAnimationClip(source);
+
+  return reduced;
+}
+
+void UnloadReducedClip(ReducedClip clip) {
+  free(clip.keyStart);
+  free(clip.keyFrames);
+  free(clip.keyValues);
+}
+
+size_t ReducedClipMemorySize(ReducedClip clip) {
+  return (clip.boneCount + 1) * sizeof(int) +
+         clip.keyCount * (sizeof(int) + sizeof(Transform));
+}
+
+// Local transform of bone at `frame` (can be between frames, clamped to clip).
+Transform ReducedClipSampleBone(ReducedClip clip, int boneId, float frame) {
+  int start = clip.keyStart[boneId];
+  int count = clip.keyStart[boneId + 1] - start;
+  int *frames = clip.keyFrames + start;
+
+  // Last key at or before frame
+  int low = 0, high = count - 1;
+  while (low < high) {
+    int mid = (low + high + 1) / 2;
+    if (frames[mid] <= frame) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+
+  return InterpolateKeys(frames, clip.keyValues + start, count, low, frame, clip.curve);
+}
+
+// Local pose at `frame`.
+void ReducedClipSamplePoseInto(Pose out, ReducedClip clip, float frame) {
+  for (int boneId = 0; boneId < clip.boneCount; boneId++) {
+    out[boneId] = ReducedClipSampleBone(clip, boneId, frame);
+  }
+}
+
+float ReducedClipMeasureWorldError(ReducedClip clip, AnimationClip source,
+                                   SkeletonHierarchy *hierarchy, int *frame,
+                                   int *boneId) {
+  float maxError = 0.0f;
+
+  Pose sampled = InitPose(2 * clip.boneCount);
+  Pose temp = sampled + clip.boneCount;
+
+  for (int f = 0; f < clip.frameCount; f++) {
+    ReducedClipSamplePoseInto(sampled, clip, (float)f);
+    PoseToGlobalTransformPoseHierarchyInto(sampled, sampled, hierarchy);
+
+    Pose reference = AnimationClipResolvePose(source, f, CLIP_GLOBAL_POSE, hierarchy, temp);
+
+    for (int b = 0; b < clip.boneCount; b++) {
+      float error = Vector3Distance(sampled[b].translation, reference[b].translation);
+      if (error > maxError) {
+        maxError = error;
+        if (frame) {
+          *frame = f;
+        }
+        if (boneId) {
+          *boneId = b;
+        }
+      }
+    }
+  }
+
+  UnloadPose(sampled);
+
+  return maxError;
+}
+
+#endif
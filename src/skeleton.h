@@ -1,24 +1,43 @@
 #ifndef __KIRAN_RAY_SKELETON__
 #define __KIRAN_RAY_SKELETON__
 
+#include "animation_clip.h"
 #include "pose.h"
+#include "pose_arena.h"
 
 #define USE_LOCAL_POSE (1 << 0)
 
+/* Blend functions below also take `BLEND_NLERP` and `BLEND_SAME_HEMISPHERE`
+   (see transform.h) in `flags`. */
+
 typedef struct Skeleton {
   int boneCount;         // Number of bones
   BoneInfo *bones;       // Bones information (skeleton)
   Pose bindPose;         // Bones base transformation (pose)
+  Pose inverseBindPose;  // Inverse of every bind pose transform (computed once)
+
+  SkeletonHierarchy hierarchy; // Compiled bone hierarchy (built from `bones`)
 
-  Matrix *boneMatrices;  // Bones animated transformation matrices (not used yet)
+  Matrix *boneMatrices;  // Skinning matrices of `pose` (see `UpdateSkeletonBoneMatrices()`)
 
   Pose pose;      // Current pose
+
+  PoseArena *arena; // Optional. Temporary poses are taken from it (if not NULL)
+
+  struct SkeletonDirtyState *dirtyState; // Optional. Local pose and dirty flags (see skeleton_dirty.h)
 } Skeleton;
 
 Skeleton LoadSkeletonFromModel(Model model);
 void UpdateModelBonesFromPose(Model model, Pose pose);
 void UnloadSkeleton(Skeleton skeleton);
 
+/* Skinning matrices of current pose into `skeleton.boneMatrices` (uses
+   precomputed inverse bind pose). */
+void UpdateSkeletonBoneMatrices(Skeleton skeleton);
+/* Sets pose from `localPose` and updates skinning matrices in same pass
+   over hierarchy. `localPose` can be `skeleton.pose`. */
+void UpdateSkeletonFromLocalPose(Skeleton skeleton, Pose localPose);
+
 void UpdateSkeletonPose(Skeleton skeleton, Pose pose);
 void UpdateSkeletonPoseWithMask(Skeleton skeleton, Pose pose, float *boneMask);
 void UpdateSkeletonModelAnimation(Skeleton skeleton, ModelAnimation anim, int frame);
@@ -26,6 +45,23 @@ void UpdateSkeletonModelAnimationLerp(Skeleton skeleton, ModelAnimation  animA,
 void UpdateSkeletonModelAnimationPoseOverrideLayer(Skeleton skeleton, ModelAnimation anim, int frame, float factor, int flags, float *boneMask);
 void UpdateSkeletonModelAnimationPoseAdditiveLayer(Skeleton skeleton, ModelAnimation anim, int frame, Pose referencePose, float factor, int flags, float *boneMask);
 
+/* `AnimationClip` variants of above. Frames are taken in space needed by
+   `flags` directly from clip. Only if clip does not store that space, frame
+   is converted into a temporary pose. */
+void UpdateSkeletonAnimationClip(Skeleton skeleton, AnimationClip clip, int frame);
+void UpdateSkeletonAnimationClipLerp(Skeleton skeleton, AnimationClip clipA, int frameA, AnimationClip clipB, int frameB, float blendFactor, int flags);
+void UpdateSkeletonAnimationClipOverrideLayer(Skeleton skeleton, AnimationClip clip, int frame, float factor, int flags, float *boneMask);
+void UpdateSkeletonAnimationClipAdditiveLayer(Skeleton skeleton, AnimationClip clip, int frame, Pose referencePose, float factor, int flags, float *boneMask);
+
+/* Time sampled clip (see `AnimationClipSamplePoseExInto()`). Local frames
+   are used when stored. Frames are blended with blend `flags`. */
+void UpdateSkeletonAnimationClipTime(Skeleton skeleton, AnimationClip clip, float seconds, int mode, int flags);
+
+/* Additive layer of baked additive clip (`LoadAdditiveAnimationClip()`).
+   Clip must store additive poses of space needed by `flags`. */
+void UpdateSkeletonAdditiveClipLayer(Skeleton skeleton, AnimationClip additiveClip, int frame, float factor, int flags, float *boneMask);
+
+// Deep copies rig data of model. For many characters of one rig see `SkeletonDef` (skeleton_def.h).
 Skeleton LoadSkeletonFromModel(Model model) {
   Skeleton skeleton = {0};
 
@@ -33,6 +69,7 @@ Skeleton LoadSkeletonFromModel(Model model) {
 
   skeleton.bones = calloc(skeleton.boneCount, sizeof(BoneInfo));
   skeleton.bindPose = calloc(skeleton.boneCount, sizeof(Transform));
+  skeleton.inverseBindPose = calloc(skeleton.boneCount, sizeof(Transform));
   skeleton.boneMatrices = calloc(skeleton.boneCount, sizeof(Matrix));
   skeleton.pose = calloc(skeleton.boneCount, sizeof(Transform));
 
@@ -42,9 +79,12 @@ Skeleton LoadSkeletonFromModel(Model model) {
     skeleton.bones[i].parent = model.bones[i].parent;
 
     skeleton.bindPose[i] = model.bindPose[i];
+    skeleton.inverseBindPose[i] = TransformInvert(model.bindPose[i]);
     skeleton.boneMatrices[i] = model.meshes[0].boneMatrices[i];
   }
 
+  skeleton.hierarchy = LoadSkeletonHierarchy(skeleton.bones, skeleton.boneCount);
+
   return skeleton;
 }
 
@@ -81,22 +121,24 @@ void UpdateSkeletonModelAnimationLerp(Skeleton skeleton, ModelAnimation animA, i
     frameA = frameA % animA.frameCount;
     frameB = frameB % animB.frameCount;
 
-    Pose pose;
     if (flags & USE_LOCAL_POSE) {
-      Pose localAnimAPose = PoseToLocalTransformPose(animA.framePoses[frameA], skeleton.bones, skeleton.boneCount);
-      Pose localAnimBPose = PoseToLocalTransformPose(animB.framePoses[frameB], skeleton.bones, skeleton.boneCount);
+      PoseArenaMark mark = PoseArenaGetMark(skeleton.arena);
+
+      Pose localAnimAPose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+      Pose localAnimBPose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+
+      PoseToLocalTransformPoseHierarchyInto(localAnimAPose, animA.framePoses[frameA], &skeleton.hierarchy);
+      PoseToLocalTransformPoseHierarchyInto(localAnimBPose, animB.framePoses[frameB], &skeleton.hierarchy);
 
-      Pose lerpPose = PoseLerp(localAnimAPose, localAnimBPose, skeleton.boneCount, blendFactor);
-      pose = PoseToGlobalTransformPose(lerpPose, skeleton.bones, skeleton.boneCount);
+      PoseOverrideBlendExInto(localAnimAPose, localAnimAPose, localAnimBPose, skeleton.boneCount, blendFactor, NULL, flags);
+      PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, localAnimAPose, &skeleton.hierarchy);
 
-      UnloadPose(localAnimAPose);
-      UnloadPose(localAnimBPose);
-      UnloadPose(lerpPose);
+      PoseArenaUnloadPose(skeleton.arena, localAnimAPose);
+      PoseArenaUnloadPose(skeleton.arena, localAnimBPose);
+      PoseArenaRewind(skeleton.arena, mark);
     } else {
-      pose = PoseLerp(animA.framePoses[frameA], animB.framePoses[frameB], skeleton.boneCount, blendFactor);
+      PoseOverrideBlendExInto(skeleton.pose, animA.framePoses[frameA], animB.framePoses[frameB], skeleton.boneCount, blendFactor, NULL, flags);
     }
-    UpdateSkeletonPose(skeleton, pose);
-    free(pose);
   }
 }
 
@@ -107,24 +149,25 @@ void UpdateSkeletonModelAnimationPoseOverrideLayer(Skeleton skeleton, ModelAnima
       (anim.framePoses != NULL) && (factor != 0.0f)) {
     frame = frame % anim.frameCount;
 
-    Pose pose;
     if (flags & USE_LOCAL_POSE) {
-      Pose localSkeletonPose = PoseToLocalTransformPose(skeleton.pose, skeleton.bones, skeleton.boneCount);
-      Pose localAnimationPose = PoseToLocalTransformPose(anim.framePoses[frame], skeleton.bones, skeleton.boneCount);
+      PoseArenaMark mark = PoseArenaGetMark(skeleton.arena);
 
-      Pose lerpPose = PoseOverrideBlend(localSkeletonPose, localAnimationPose, skeleton.boneCount, factor, boneMask);
+      Pose localSkeletonPose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+      Pose localAnimationPose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
 
-      pose = PoseToGlobalTransformPose(lerpPose, skeleton.bones, skeleton.boneCount);
+      PoseToLocalTransformPoseHierarchyInto(localSkeletonPose, skeleton.pose, &skeleton.hierarchy);
+      PoseToLocalTransformPoseHierarchyInto(localAnimationPose, anim.framePoses[frame], &skeleton.hierarchy);
 
-      UnloadPose(lerpPose);
-      UnloadPose(localSkeletonPose);
-      UnloadPose(localAnimationPose);
+      PoseOverrideBlendExInto(localSkeletonPose, localSkeletonPose, localAnimationPose, skeleton.boneCount, factor, boneMask, flags);
+
+      PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, localSkeletonPose, &skeleton.hierarchy);
+
+      PoseArenaUnloadPose(skeleton.arena, localSkeletonPose);
+      PoseArenaUnloadPose(skeleton.arena, localAnimationPose);
+      PoseArenaRewind(skeleton.arena, mark);
     } else {
-      pose = PoseOverrideBlend(skeleton.pose, anim.framePoses[frame], skeleton.boneCount, factor, boneMask);
+      PoseOverrideBlendExInto(skeleton.pose, skeleton.pose, anim.framePoses[frame], skeleton.boneCount, factor, boneMask, flags);
     }
-
-    UpdateSkeletonPose(skeleton, pose);
-    UnloadPose(pose);
   }
 }
 
@@ -133,42 +176,201 @@ void UpdateSkeletonModelAnimationPoseAdditiveLayer(Skeleton skeleton, ModelAnima
       (anim.framePoses != NULL) && (factor != 0.0f)) {
     frame = frame % anim.frameCount;
 
-    Pose pose;
+    PoseArenaMark mark = PoseArenaGetMark(skeleton.arena);
+
     if (flags & USE_LOCAL_POSE) {
-      Pose localSkeletonPose = PoseToLocalTransformPose(skeleton.pose, skeleton.bones, skeleton.boneCount);
-      Pose localAnimationPose = PoseToLocalTransformPose(anim.framePoses[frame], skeleton.bones, skeleton.boneCount);
-      Pose localReferencePose = PoseToLocalTransformPose(referencePose, skeleton.bones, skeleton.boneCount);
+      Pose localSkeletonPose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+      Pose localAnimationPose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+      Pose localReferencePose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+
+      PoseToLocalTransformPoseHierarchyInto(localSkeletonPose, skeleton.pose, &skeleton.hierarchy);
+      PoseToLocalTransformPoseHierarchyInto(localAnimationPose, anim.framePoses[frame], &skeleton.hierarchy);
+      PoseToLocalTransformPoseHierarchyInto(localReferencePose, referencePose, &skeleton.hierarchy);
 
-      Pose localAdditivePose = PoseGenerateAdditivePose(localAnimationPose, localReferencePose, skeleton.boneCount);
+      PoseGenerateAdditivePoseInto(localAnimationPose, localAnimationPose, localReferencePose, skeleton.boneCount);
 
-      Pose combinedPose = PoseAdditiveBlend(localSkeletonPose, localAdditivePose, skeleton.boneCount, 1.0f, factor, boneMask);
+      PoseAdditiveBlendExInto(localSkeletonPose, localSkeletonPose, localAnimationPose, skeleton.boneCount, 1.0f, factor, boneMask, flags);
 
-      pose = PoseToGlobalTransformPose(combinedPose, skeleton.bones, skeleton.boneCount);
+      PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, localSkeletonPose, &skeleton.hierarchy);
 
-      UnloadPose(combinedPose);
-      UnloadPose(localAdditivePose);
-      UnloadPose(localReferencePose);
-      UnloadPose(localAnimationPose);
-      UnloadPose(localSkeletonPose);
+      PoseArenaUnloadPose(skeleton.arena, localReferencePose);
+      PoseArenaUnloadPose(skeleton.arena, localAnimationPose);
+      PoseArenaUnloadPose(skeleton.arena, localSkeletonPose);
     } else {
-      Pose additivePose = PoseGenerateAdditivePose(anim.framePoses[frame], referencePose, skeleton.boneCount);
+      Pose additivePose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+
+      PoseGenerateAdditivePoseInto(additivePose, anim.framePoses[frame], referencePose, skeleton.boneCount);
+
+      PoseAdditiveBlendExInto(skeleton.pose, skeleton.pose, additivePose, skeleton.boneCount, 1.0f, factor, boneMask, flags);
+
+      PoseArenaUnloadPose(skeleton.arena, additivePose);
+    }
+
+    PoseArenaRewind(skeleton.arena, mark);
+  }
+}
+
+// Clip frame in space needed by `flags`. `*temp` is set if a temporary pose was needed.
+Pose SkeletonAnimationClipPose(Skeleton skeleton, AnimationClip clip, int frame, int flags, Pose *temp) {
+  int space = (flags & USE_LOCAL_POSE) ? CLIP_LOCAL_POSE : CLIP_GLOBAL_POSE;
 
-      pose = PoseAdditiveBlend(skeleton.pose, additivePose, skeleton.boneCount, 1.0f, factor, boneMask);
+  Pose pose = (space == CLIP_LOCAL_POSE) ? AnimationClipGetLocalPose(clip, frame) : AnimationClipGetGlobalPose(clip, frame);
+  if (pose) {
+    return pose;
+  }
+
+  *temp = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
 
-      UnloadPose(additivePose);
+  return AnimationClipResolvePose(clip, frame, space, &skeleton.hierarchy, *temp);
+}
+
+void UpdateSkeletonAnimationClip(Skeleton skeleton, AnimationClip clip, int frame) {
+  if (AnimationClipIsValid(clip)) {
+    if (clip.globalFrames) {
+      UpdateSkeletonPose(skeleton, AnimationClipGetGlobalPose(clip, frame));
+    } else {
+      PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, AnimationClipGetLocalPose(clip, frame), &skeleton.hierarchy);
     }
+  }
+}
 
-    UpdateSkeletonPose(skeleton, pose);
-    UnloadPose(pose);
+void UpdateSkeletonAnimationClipTime(Skeleton skeleton, AnimationClip clip, float seconds, int mode, int flags) {
+  if (AnimationClipIsValid(clip)) {
+    if (clip.localFrames) {
+      AnimationClipSamplePoseExInto(skeleton.pose, clip, seconds, mode, CLIP_LOCAL_POSE, &skeleton.hierarchy, flags);
+      PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, skeleton.pose, &skeleton.hierarchy);
+    } else {
+      AnimationClipSamplePoseExInto(skeleton.pose, clip, seconds, mode, CLIP_GLOBAL_POSE, &skeleton.hierarchy, flags);
+    }
   }
 }
 
+void UpdateSkeletonAnimationClipLerp(Skeleton skeleton, AnimationClip clipA, int frameA, AnimationClip clipB, int frameB, float blendFactor, int flags) {
+  if (AnimationClipIsValid(clipA) && AnimationClipIsValid(clipB) &&
+      (blendFactor >= 0.0f) && (blendFactor <= 1.0f)) {
+    PoseArenaMark mark = PoseArenaGetMark(skeleton.arena);
+    Pose tempA = NULL, tempB = NULL;
+
+    Pose poseA = SkeletonAnimationClipPose(skeleton, clipA, frameA, flags, &tempA);
+    Pose poseB = SkeletonAnimationClipPose(skeleton, clipB, frameB, flags, &tempB);
+
+    if (flags & USE_LOCAL_POSE) {
+      Pose localPose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+
+      PoseOverrideBlendExInto(localPose, poseA, poseB, skeleton.boneCount, blendFactor, NULL, flags);
+      PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, localPose, &skeleton.hierarchy);
+
+      PoseArenaUnloadPose(skeleton.arena, localPose);
+    } else {
+      PoseOverrideBlendExInto(skeleton.pose, poseA, poseB, skeleton.boneCount, blendFactor, NULL, flags);
+    }
+
+    PoseArenaUnloadPose(skeleton.arena, tempA);
+    PoseArenaUnloadPose(skeleton.arena, tempB);
+    PoseArenaRewind(skeleton.arena, mark);
+  }
+}
+
+void UpdateSkeletonAnimationClipOverrideLayer(Skeleton skeleton, AnimationClip clip, int frame, float factor, int flags, float *boneMask) {
+  if (AnimationClipIsValid(clip) && (factor != 0.0f)) {
+    PoseArenaMark mark = PoseArenaGetMark(skeleton.arena);
+    Pose temp = NULL;
+
+    Pose clipPose = SkeletonAnimationClipPose(skeleton, clip, frame, flags, &temp);
+
+    if (flags & USE_LOCAL_POSE) {
+      Pose localSkeletonPose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+
+      PoseToLocalTransformPoseHierarchyInto(localSkeletonPose, skeleton.pose, &skeleton.hierarchy);
+      PoseOverrideBlendExInto(localSkeletonPose, localSkeletonPose, clipPose, skeleton.boneCount, factor, boneMask, flags);
+      PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, localSkeletonPose, &skeleton.hierarchy);
+
+      PoseArenaUnloadPose(skeleton.arena, localSkeletonPose);
+    } else {
+      PoseOverrideBlendExInto(skeleton.pose, skeleton.pose, clipPose, skeleton.boneCount, factor, boneMask, flags);
+    }
+
+    PoseArenaUnloadPose(skeleton.arena, temp);
+    PoseArenaRewind(skeleton.arena, mark);
+  }
+}
+
+void UpdateSkeletonAnimationClipAdditiveLayer(Skeleton skeleton, AnimationClip clip, int frame, Pose referencePose, float factor, int flags, float *boneMask) {
+  if (AnimationClipIsValid(clip) && (factor != 0.0f)) {
+    PoseArenaMark mark = PoseArenaGetMark(skeleton.arena);
+    Pose temp = NULL;
+
+    Pose clipPose = SkeletonAnimationClipPose(skeleton, clip, frame, flags, &temp);
+    Pose additivePose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+
+    if (flags & USE_LOCAL_POSE) {
+      Pose localSkeletonPose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+
+      PoseToLocalTransformPoseHierarchyInto(additivePose, referencePose, &skeleton.hierarchy);
+      PoseGenerateAdditivePoseInto(additivePose, clipPose, additivePose, skeleton.boneCount);
+
+      PoseToLocalTransformPoseHierarchyInto(localSkeletonPose, skeleton.pose, &skeleton.hierarchy);
+      PoseAdditiveBlendExInto(localSkeletonPose, localSkeletonPose, additivePose, skeleton.boneCount, 1.0f, factor, boneMask, flags);
+      PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, localSkeletonPose, &skeleton.hierarchy);
+
+      PoseArenaUnloadPose(skeleton.arena, localSkeletonPose);
+    } else {
+      PoseGenerateAdditivePoseInto(additivePose, clipPose, referencePose, skeleton.boneCount);
+      PoseAdditiveBlendExInto(skeleton.pose, skeleton.pose, additivePose, skeleton.boneCount, 1.0f, factor, boneMask, flags);
+    }
+
+    PoseArenaUnloadPose(skeleton.arena, additivePose);
+    PoseArenaUnloadPose(skeleton.arena, temp);
+    PoseArenaRewind(skeleton.arena, mark);
+  }
+}
+
+void UpdateSkeletonAdditiveClipLayer(Skeleton skeleton, AnimationClip additiveClip, int frame, float factor, int flags, float *boneMask) {
+  if (AnimationClipIsValid(additiveClip) && (factor != 0.0f)) {
+    if (flags & USE_LOCAL_POSE) {
+      Pose additivePose = AnimationClipGetLocalPose(additiveClip, frame);
+      if (additivePose == NULL) {
+        return;
+      }
+
+      PoseArenaMark mark = PoseArenaGetMark(skeleton.arena);
+      Pose localSkeletonPose = PoseArenaInitPose(skeleton.arena, skeleton.boneCount);
+
+      PoseToLocalTransformPoseHierarchyInto(localSkeletonPose, skeleton.pose, &skeleton.hierarchy);
+      PoseAdditiveBlendExInto(localSkeletonPose, localSkeletonPose, additivePose, skeleton.boneCount, 1.0f, factor, boneMask, flags);
+      PoseToGlobalTransformPoseHierarchyInto(skeleton.pose, localSkeletonPose, &skeleton.hierarchy);
+
+      PoseArenaUnloadPose(skeleton.arena, localSkeletonPose);
+      PoseArenaRewind(skeleton.arena, mark);
+    } else {
+      Pose additivePose = AnimationClipGetGlobalPose(additiveClip, frame);
+      if (additivePose == NULL) {
+        return;
+      }
+
+      PoseAdditiveBlendExInto(skeleton.pose, skeleton.pose, additivePose, skeleton.boneCount, 1.0f, factor, boneMask, flags);
+    }
+  }
+}
+
+void UpdateSkeletonBoneMatrices(Skeleton skeleton) {
+  PoseToSkinningMatricesInto(skeleton.boneMatrices, skeleton.inverseBindPose, skeleton.pose, skeleton.boneCount);
+}
+
+void UpdateSkeletonFromLocalPose(Skeleton skeleton, Pose localPose) {
+  PoseToSkinningMatricesHierarchyInto(skeleton.boneMatrices, skeleton.pose, localPose, skeleton.inverseBindPose, &skeleton.hierarchy);
+}
+
 void UnloadSkeleton(Skeleton skeleton) {
   UnloadPose(skeleton.pose);
   UnloadPose(skeleton.bindPose);
+  UnloadPose(skeleton.inverseBindPose);
 
   free(skeleton.bones);
   free(skeleton.boneMatrices);
+  free(skeleton.dirtyState);
+
+  UnloadSkeletonHierarchy(skeleton.hierarchy);
 }
 
 #endif
@@ -0,0 +1,159 @@
+#ifndef __KIRAN_RAY_SKELETON_DEF__
+#define __KIRAN_RAY_SKELETON_DEF__
+
+#include "skeleton.h"
+
+/* Shared rig data and per character state.
+
+   `Skeleton` (from `LoadSkeletonFromModel()`) copies bones, bind pose and
+   matrices into every character. `SkeletonDef` holds immutable data of a
+   rig once and is shared by reference by all `SkeletonInstance`s of that
+   rig. An instance only holds what changes per character: current pose
+   and skinning palette, in one allocation.
+
+   `SkeletonInstanceView()` gives a `Skeleton` pointing into both, so all
+   skeleton and layer stack functions work on instances. */
+typedef struct SkeletonDef {
+  int boneCount;               // Number of bones
+  BoneInfo *bones;             // Bone names and parents
+  Pose bindPose;               // Bind pose (global)
+  Pose inverseBindPose;        // Inverse of every bind pose transform
+  SkeletonHierarchy hierarchy; // Compiled bone hierarchy
+
+  int instanceCount;           // Number of instances loaded (and not unloaded)
+} SkeletonDef;
+
+typedef struct SkeletonInstance {
+  SkeletonDef *def;   // Shared rig (not owned)
+  Pose pose;          // Current pose (global)
+  Matrix *palette;    // Skinning matrices (`pose` against bind pose)
+
+  PoseArena *arena;   // Optional. Temporary poses are taken from it (if not NULL)
+} SkeletonInstance;
+
+SkeletonDef *LoadSkeletonDef(BoneInfo *bones, Pose bindPose, int boneCount);
+SkeletonDef *LoadSkeletonDefFromModel(Model model);
+void UnloadSkeletonDef(SkeletonDef *def);
+
+SkeletonInstance LoadSkeletonInstance(SkeletonDef *def);
+void UnloadSkeletonInstance(SkeletonInstance instance);
+size_t SkeletonInstanceMemorySize(SkeletonDef *def);
+
+Skeleton SkeletonInstanceView(SkeletonInstance instance);
+void UpdateSkeletonInstancePalette(SkeletonInstance instance);
+void UpdateSkeletonInstanceFromLocalPose(SkeletonInstance instance, Pose localPose);
+
+// Copies `bones` and `bindPose` (global) into one allocation.
+SkeletonDef *LoadSkeletonDef(BoneInfo *bones, Pose bindPose, int boneCount) {
+  size_t size = sizeof(SkeletonDef) + boneCount * (sizeof(BoneInfo) + 2 * sizeof(Transform));
+
+  SkeletonDef *def = calloc(1, size);
+  if (def == NULL) {
+    TraceLog(LOG_WARNING, "SKELETON: Failed to allocate skeleton def");
+    return NULL;
+  }
+
+  def->boneCount = boneCount;
+  def->bindPose = (Pose)(def + 1);
+  def->inverseBindPose = def->bindPose + boneCount;
+  def->bones = (BoneInfo *)(def->inverseBindPose + boneCount);
+
+  memcpy(def->bones, bones, boneCount * sizeof(BoneInfo));
+  CopyPoseInto(def->bindPose, bindPose, boneCount);
+  for (int i = 0; i < boneCount; i++) {
+    def->inverseBindPose[i] = TransformInvert(bindPose[i]);
+  }
+
+  def->hierarchy = LoadSkeletonHierarchy(def->bones, boneCount);
+
+  return def;
+}
+
+SkeletonDef *LoadSkeletonDefFromModel(Model model) {
+  return LoadSkeletonDef(model.bones, model.bindPose, model.boneCount);
+}
+
+// Instances must be unloaded first (def is shared by them).
+void UnloadSkeletonDef(SkeletonDef *def) {
+  if (def == NULL) {
+    return;
+  }
+
+  if (def->instanceCount != 0) {
+    TraceLog(LOG_WARNING, "SKELETON: Skeleton def unloaded with %d instances still loaded", def->instanceCount);
+  }
+
+  UnloadSkeletonHierarchy(def->hierarchy);
+  free(def);
+}
+
+// Pose and palette of instance in one allocation. Pose starts at bind pose.
+SkeletonInstance LoadSkeletonInstance(SkeletonDef *def) {
+  SkeletonInstance instance = {0};
+
+  // Palette first keeps matrices 16 byte aligned
+  Matrix *memory = malloc(SkeletonInstanceMemorySize(def));
+  if (memory == NULL) {
+    TraceLog(LOG_WARNING, "SKELETON: Failed to allocate skeleton instance");
+    return instance;
+  }
+
+  instance.def = def;
+  instance.palette = memory;
+  instance.pose = (Pose)(memory + def->boneCount);
+
+  CopyPoseInto(instance.pose, def->bindPose, def->boneCount);
+  for (int i = 0; i < def->boneCount; i++) {
+    instance.palette[i] = MatrixIdentity();
+  }
+
+  def->instanceCount++;
+
+  return instance;
+}
+
+void UnloadSkeletonInstance(SkeletonInstance instance) {
+  if (instance.def) {
+    instance.def->instanceCount--;
+  }
+
+  free(instance.palette);
+}
+
+size_t SkeletonInstanceMemorySize(SkeletonDef *def) {
+  return def->boneCount * (sizeof(Matrix) + sizeof(Transform));
+}
+
+/* `Skeleton` over instance (no copy). Skeleton functions update instance
+   pose through it. Do not `UnloadSkeleton()` a view. */
+Skeleton SkeletonInstanceView(SkeletonInstance instance) {
+  Skeleton skeleton = {0};
+
+  skeleton.boneCount = instance.def->boneCount;
+  skeleton.bones = instance.def->bones;
+  skeleton.bindPose = instance.def->bindPose;
+  skeleton.inverseBindPose = instance.def->inverseBindPose;
+  skeleton.hierarchy = instance.def->hierarchy;
+  skeleton.boneMatrices = instance.palette;
+  skeleton.pose = instance.pose;
+  skeleton.arena = instance.arena;
+
+  return skeleton;
+}
+
+/* `palette[i]` = `pose[i]` applied after inverse of bind pose. Same as
+   `PoseToPoseTransformMatricesInto(palette, bindPose, pose)` (also under
+   non-uniform scale), with inverse precomputed in `SkeletonDef`. */
+void UpdateSkeletonInstancePalette(SkeletonInstance instance) {
+  PoseToSkinningMatricesInto(instance.palette, instance.def->inverseBindPose, instance.pose, instance.def->boneCount);
+}
+
+/* Global pose and palette from `localPose` in one pass over hierarchy.
+   `localPose` can be `instance.pose`. */
+void UpdateSkeletonInstanceFromLocalPose(SkeletonInstance instance, Pose localPose) {
+  SkeletonDef *def = instance.def;
+
+  PoseToSkinningMatricesHierarchyInto(instance.palette, instance.pose, localPose, def->inverseBindPose, &def->hierarchy);
+}
+
+#endif
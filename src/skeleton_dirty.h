@@ -0,0 +1,192 @@
+#ifndef __KIRAN_RAY_SKELETON_DIRTY__
+#define __KIRAN_RAY_SKELETON_DIRTY__
+
+#include <string.h>
+
+#include "skeleton.h"
+
+/* Incremental updates of a skeleton.
+
+   Skeleton keeps its local pose and a dirty flag per bone. Edits of local
+   transforms mark only bones that really changed. `UpdateSkeletonDirty()`
+   then recomputes global transforms and skinning matrices
+   (`skeleton.boneMatrices`) of dirty subtrees only (a subtree is one
+   contiguous range of `hierarchy.order`), and does nothing when no bone
+   changed (e.g. idle character on a held frame).
+
+   Range of skinning matrices changed by last update is kept, so copies
+   of palette (`UpdateModelMeshFromSkeletonDirty()`) copy only that range.
+
+   Local pose is source of global pose. After writing `skeleton.pose` with
+   other skeleton functions, call `SyncSkeletonLocalPose()`. State is one
+   allocation (freed by `UnloadSkeleton()` too). */
+typedef struct SkeletonDirtyState {
+  Pose localPose;          // Local transforms of bones
+  unsigned char *dirty;    // Per bone: 1 if local transform changed since last update
+  int dirtyCount;          // Bones marked since last update
+
+  int updatedCount;        // Bones recomputed by last update
+  int paletteBegin;        // First bone id of `boneMatrices` changed by last update
+  int paletteEnd;          // Last bone id changed + 1 (same as begin if none)
+} SkeletonDirtyState;
+
+void LoadSkeletonDirtyState(Skeleton *skeleton);
+void UnloadSkeletonDirtyState(Skeleton *skeleton);
+
+Transform GetSkeletonBoneLocal(Skeleton skeleton, int boneId);
+void SetSkeletonBoneLocal(Skeleton skeleton, int boneId, Transform local);
+void MarkSkeletonBoneDirty(Skeleton skeleton, int boneId);
+void SetSkeletonLocalPose(Skeleton skeleton, Pose localPose);
+void SyncSkeletonLocalPose(Skeleton skeleton);
+
+int UpdateSkeletonDirty(Skeleton skeleton);
+void UpdateModelMeshFromSkeletonDirty(Model model, Skeleton skeleton);
+
+/* Local pose from current (global) pose. All bones start dirty, so first
+   update computes full palette. */
+void LoadSkeletonDirtyState(Skeleton *skeleton) {
+  int boneCount = skeleton->boneCount;
+
+  free(skeleton->dirtyState);
+
+  SkeletonDirtyState *state = malloc(sizeof(SkeletonDirtyState) + boneCount * (sizeof(Transform) + 1));
+  if (state == NULL) {
+    TraceLog(LOG_WARNING, "SKELETON: Failed to allocate dirty state");
+    skeleton->dirtyState = NULL;
+    return;
+  }
+
+  state->localPose = (Pose)(state + 1);
+  state->dirty = (unsigned char *)(state->localPose + boneCount);
+
+  PoseToLocalTransformPoseHierarchyInto(state->localPose, skeleton->pose, &skeleton->hierarchy);
+  memset(state->dirty, 1, boneCount);
+  state->dirtyCount = boneCount;
+  state->updatedCount = 0;
+  state->paletteBegin = state->paletteEnd = 0;
+
+  skeleton->dirtyState = state;
+}
+
+void UnloadSkeletonDirtyState(Skeleton *skeleton) {
+  free(skeleton->dirtyState);
+  skeleton->dirtyState = NULL;
+}
+
+Transform GetSkeletonBoneLocal(Skeleton skeleton, int boneId) {
+  return skeleton.dirtyState->localPose[boneId];
+}
+
+// Sets local transform of bone. Marks it dirty only if it changed.
+void SetSkeletonBoneLocal(Skeleton skeleton, int boneId, Transform local) {
+  SkeletonDirtyState *state = skeleton.dirtyState;
+
+  if (memcmp(&state->localPose[boneId], &local, sizeof(Transform)) == 0) {
+    return;
+  }
+
+  state->localPose[boneId] = local;
+  MarkSkeletonBoneDirty(skeleton, boneId);
+}
+
+// For local transforms written directly into `dirtyState->localPose`.
+void MarkSkeletonBoneDirty(Skeleton skeleton, int boneId) {
+  SkeletonDirtyState *state = skeleton.dirtyState;
+
+  if (!state->dirty[boneId]) {
+    state->dirty[boneId] = 1;
+    state->dirtyCount++;
+  }
+}
+
+// Sets whole local pose (e.g. sampled clip frame). Only changed bones are marked.
+void SetSkeletonLocalPose(Skeleton skeleton, Pose localPose) {
+  for (int boneId = 0; boneId < skeleton.boneCount; boneId++) {
+    SetSkeletonBoneLocal(skeleton, boneId, localPose[boneId]);
+  }
+}
+
+/* Local pose from `skeleton.pose` after it was written by other functions.
+   Bones whose local transform is same as before stay clean. */
+void SyncSkeletonLocalPose(Skeleton skeleton) {
+  for (int i = 0; i < skeleton.boneCount; i++) {
+    int boneId = skeleton.hierarchy.order[i];
+    int parentId = skeleton.hierarchy.parents[boneId];
+
+    Transform local = (parentId == -1) ? skeleton.pose[boneId] : TransformGlobalToLocal(skeleton.pose[boneId], skeleton.pose[parentId]);
+    SetSkeletonBoneLocal(skeleton, boneId, local);
+  }
+}
+
+/* Global transforms and skinning matrices of dirty subtrees. Returns
+   number of bones recomputed (0 if nothing was dirty). Changed palette
+   range is `dirtyState->paletteBegin` to `dirtyState->paletteEnd - 1`. */
+int UpdateSkeletonDirty(Skeleton skeleton) {
+  SkeletonDirtyState *state = skeleton.dirtyState;
+  SkeletonHierarchy *hierarchy = &skeleton.hierarchy;
+
+  state->updatedCount = 0;
+  state->paletteBegin = state->paletteEnd = 0;
+
+  if (state->dirtyCount == 0) {
+    return 0;
+  }
+
+  int paletteBegin = skeleton.boneCount;
+  int paletteEnd = 0;
+
+  for (int i = 0; i < skeleton.boneCount;) {
+    int rootId = hierarchy->order[i];
+
+    if (!state->dirty[rootId]) {
+      i++;
+      continue;
+    }
+
+    // Whole subtree of dirty bone (parent first), dirty bones inside it included
+    int end = i + hierarchy->subtreeSize[rootId];
+    for (; i < end; i++) {
+      int boneId = hierarchy->order[i];
+      int parentId = hierarchy->parents[boneId];
+
+      Transform global = (parentId == -1) ? state->localPose[boneId] : TransformLocalToGlobal(state->localPose[boneId], skeleton.pose[parentId]);
+
+      skeleton.pose[boneId] = global;
+      skeleton.boneMatrices[boneId] = TransformToMatrix(TransformToTransformTransformInverse(skeleton.inverseBindPose[boneId], global));
+      state->dirty[boneId] = 0;
+
+      paletteBegin = (boneId < paletteBegin) ? boneId : paletteBegin;
+      paletteEnd = (boneId + 1 > paletteEnd) ? boneId + 1 : paletteEnd;
+      state->updatedCount++;
+    }
+  }
+
+  state->dirtyCount = 0;
+  state->paletteBegin = paletteBegin;
+  state->paletteEnd = paletteEnd;
+
+  return state->updatedCount;
+}
+
+/* Copies changed range of `skeleton.boneMatrices` (last update) into
+   skinned meshes of `model`. Same result as `UpdateModelMeshFromPose()`
+   with current pose, for meshes kept in sync this way. */
+void UpdateModelMeshFromSkeletonDirty(Model model, Skeleton skeleton) {
+  SkeletonDirtyState *state = skeleton.dirtyState;
+
+  for (int m = 0; m < model.meshCount; m++) {
+    Mesh mesh = model.meshes[m];
+
+    if (mesh.boneMatrices == NULL || mesh.boneMatrices == skeleton.boneMatrices) {
+      continue;
+    }
+
+    int end = (state->paletteEnd < mesh.boneCount) ? state->paletteEnd : mesh.boneCount;
+    if (end > state->paletteBegin) {
+      memcpy(mesh.boneMatrices + state->paletteBegin, skeleton.boneMatrices + state->paletteBegin,
+             (end - state->paletteBegin) * sizeof(Matrix));
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef __KIRAN_RAY_SKELETON_HIERARCHY__
+#define __KIRAN_RAY_SKELETON_HIERARCHY__
+
+#include <raylib.h>
+#include <stdlib.h>
+
+/* Compiled bone hierarchy.
+
+   Built once from `BoneInfo.parent` and never depends on bone order of the
+   model. Bones are sorted depth first (parent first), so:
+    - Walking `order` forward visits every parent before its children and
+      walking it backward visits children before parent.
+    - Subtree of a bone is `order[orderIndex[bone]]` to
+      `order[orderIndex[bone] + subtreeSize[bone] - 1]`.
+   Bones are also grouped by depth (`levelBones`), bones of same level do not
+   depend on each other and can be processed together.
+
+   Invalid parents (out of range or loops) are logged and bone is treated as
+   a root. */
+typedef struct SkeletonHierarchy {
+  int boneCount;     // Number of bones
+  int levelCount;    // Number of depth levels (max depth + 1)
+
+  int *parents;      // Parent of each bone (-1 for roots)
+  int *depth;        // Depth of each bone (0 for roots)
+
+  int *order;        // Bone ids in depth first (parent first) order
+  int *orderIndex;   // Position of each bone in `order`
+  int *subtreeSize;  // Bones in subtree of each bone (including itself)
+
+  int *childStart;   // `boneCount + 1` offsets into `children`
+  int *children;     // Child bone ids grouped by parent
+
+  int *levelStart;   // `levelCount + 1` offsets into `levelBones`
+  int *levelBones;   // Bone ids grouped by depth
+} SkeletonHierarchy;
+
+SkeletonHierarchy LoadSkeletonHierarchy(BoneInfo *bones, int boneCount);
+void UnloadSkeletonHierarchy(SkeletonHierarchy hierarchy);
+
+int SkeletonHierarchyIsAncestor(SkeletonHierarchy *hierarchy, int ancestorId,
+                                int boneId);
+
+SkeletonHierarchy LoadSkeletonHierarchy(BoneInfo *bones, int boneCount) {
+  SkeletonHierarchy hierarchy = {0};
+
+  hierarchy.boneCount = boneCount;
+
+  // All arrays in one allocation (freed with `parents`)
+  int *memory = malloc((9 * boneCount + 2) * sizeof(int));
+  if (memory == NULL) {
+    hierarchy.boneCount = 0;
+    return hierarchy;
+  }
+
+  hierarchy.parents = memory;
+  hierarchy.depth = hierarchy.parents + boneCount;
+  hierarchy.order = hierarchy.depth + boneCount;
+  hierarchy.orderIndex = hierarchy.order + boneCount;
+  hierarchy.subtreeSize = hierarchy.orderIndex + boneCount;
+  hierarchy.childStart = hierarchy.subtreeSize + boneCount;
+  hierarchy.children = hierarchy.childStart + boneCount + 1;
+  hierarchy.levelStart = hierarchy.children + boneCount;
+  hierarchy.levelBones = hierarchy.levelStart + boneCount + 1;
+
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    int parent = bones[boneId].parent;
+
+    if (parent < -1 || parent >= boneCount || parent == boneId) {
+      TraceLog(LOG_WARNING, "HIERARCHY: Bone \"%s\" (ID: %d) has invalid parent %d. Using it as root.",
+               bones[boneId].name, boneId, parent);
+      parent = -1;
+    }
+
+    hierarchy.parents[boneId] = parent;
+  }
+
+  // Break parent loops. `depth` is used as visit state here
+  // (0: not visited, 1: on current chain, 2: done).
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    hierarchy.depth[boneId] = 0;
+  }
+
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    int current = boneId;
+    int last = -1;
+    while (current != -1 && hierarchy.depth[current] == 0) {
+      hierarchy.depth[current] = 1;
+      last = current;
+      current = hierarchy.parents[current];
+    }
+
+    // Reached a bone of current chain again. Cut the link closing the loop.
+    if (current != -1 && hierarchy.depth[current] == 1) {
+      TraceLog(LOG_WARNING, "HIERARCHY: Bone \"%s\" (ID: %d) is in a parent loop. Using it as root.",
+               bones[last].name, last);
+      hierarchy.parents[last] = -1;
+    }
+
+    current = boneId;
+    while (current != -1 && hierarchy.depth[current] == 1) {
+      hierarchy.depth[current] = 2;
+      current = hierarchy.parents[current];
+    }
+  }
+
+  // Children spans (counting sort by parent, children keep bone id order)
+  for (int i = 0; i <= boneCount; i++) {
+    hierarchy.childStart[i] = 0;
+  }
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    if (hierarchy.parents[boneId] != -1) {
+      hierarchy.childStart[hierarchy.parents[boneId] + 1]++;
+    }
+  }
+  for (int i = 0; i < boneCount; i++) {
+    hierarchy.childStart[i + 1] += hierarchy.childStart[i];
+  }
+  // `orderIndex` is used as fill cursor here
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    hierarchy.orderIndex[boneId] = hierarchy.childStart[boneId];
+  }
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    int parent = hierarchy.parents[boneId];
+    if (parent != -1) {
+      hierarchy.children[hierarchy.orderIndex[parent]++] = boneId;
+    }
+  }
+
+  // Depth first order. `levelBones` is used as stack here.
+  int orderCount = 0;
+  for (int rootId = 0; rootId < boneCount; rootId++) {
+    if (hierarchy.parents[rootId] != -1) {
+      continue;
+    }
+
+    int stackSize = 0;
+    hierarchy.levelBones[stackSize++] = rootId;
+    hierarchy.depth[rootId] = 0;
+
+    while (stackSize > 0) {
+      int boneId = hierarchy.levelBones[--stackSize];
+
+      hierarchy.orderIndex[boneId] = orderCount;
+      hierarchy.order[orderCount++] = boneId;
+
+      // Pushed in reverse so children are visited in bone id order
+      for (int i = hierarchy.childStart[boneId + 1] - 1; i >= hierarchy.childStart[boneId]; i--) {
+        int childId = hierarchy.children[i];
+
+        hierarchy.depth[childId] = hierarchy.depth[boneId] + 1;
+        hierarchy.levelBones[stackSize++] = childId;
+      }
+    }
+  }
+
+  // Subtree sizes (children before parents)
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    hierarchy.subtreeSize[boneId] = 1;
+  }
+  for (int i = boneCount - 1; i >= 0; i--) {
+    int boneId = hierarchy.order[i];
+    if (hierarchy.parents[boneId] != -1) {
+      hierarchy.subtreeSize[hierarchy.parents[boneId]] += hierarchy.subtreeSize[boneId];
+    }
+  }
+
+  // Depth levels (counting sort by depth, keeps depth first order)
+  hierarchy.levelCount = 0;
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    if (hierarchy.depth[boneId] + 1 > hierarchy.levelCount) {
+      hierarchy.levelCount = hierarchy.depth[boneId] + 1;
+    }
+  }
+  for (int i = 0; i <= hierarchy.levelCount; i++) {
+    hierarchy.levelStart[i] = 0;
+  }
+  for (int boneId = 0; boneId < boneCount; boneId++) {
+    hierarchy.levelStart[hierarchy.depth[boneId] + 1]++;
+  }
+  for (int i = 0; i < hierarchy.levelCount; i++) {
+    hierarchy.levelStart[i + 1] += hierarchy.levelStart[i];
+  }
+  for (int i = 0; i < boneCount; i++) {
+    int boneId = hierarchy.order[i];
+    int level = hierarchy.depth[boneId];
+
+    // `levelStart[level]` is used as cursor and restored below
+    hierarchy.levelBones[hierarchy.levelStart[level]++] = boneId;
+  }
+  for (int i = hierarchy.levelCount; i > 0; i--) {
+    hierarchy.levelStart[i] = hierarchy.levelStart[i - 1];
+  }
+  hierarchy.levelStart[0] = 0;
+
+  return hierarchy;
+}
+
+void UnloadSkeletonHierarchy(SkeletonHierarchy hierarchy) {
+  free(hierarchy.parents);
+}
+
+// Is `boneId` in subtree of `ancestorId` (a bone is in its own subtree)
+int SkeletonHierarchyIsAncestor(SkeletonHierarchy *hierarchy, int ancestorId,
+                                int boneId) {
+  int start = hierarchy->orderIndex[ancestorId];
+  int index = hierarchy->orderIndex[boneId];
+
+  return (index >= start) && (index < start + hierarchy->subtreeSize[ancestorId]);
+}
+
+#endif
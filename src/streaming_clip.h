@@ -0,0 +1,357 @@
+#ifndef __KIRAN_RAY_STREAMING_CLIP__
+#define __KIRAN_RAY_STREAMING_CLIP__
+
+#if defined(_WIN32) && !defined(STREAMING_CLIP_NO_THREADS)
+#define STREAMING_CLIP_NO_THREADS
+#endif
+
+#if !defined(STREAMING_CLIP_NO_THREADS)
+#include <pthread.h>
+#endif
+
+#include "kanim_file.h"
+
+// Chunks resident at once (chunk under playhead and chunk being read ahead)
+#define STREAMING_CLIP_BUFFERS 2
+
+#define STREAMING_CHUNK_EMPTY 0
+#define STREAMING_CHUNK_LOADING 1
+#define STREAMING_CHUNK_READY 2
+
+typedef struct StreamingClipChunk {
+  int chunk;          // Index of chunk held (-1 if none)
+  int state;          // STREAMING_CHUNK_EMPTY, STREAMING_CHUNK_LOADING or STREAMING_CHUNK_READY
+  Transform *frames;  // `chunkFrames * boneCount` local transforms
+} StreamingClipChunk;
+
+/* Clip of `.kanim` file played from disk.
+
+   Frames are read in chunks of `chunkFrames` frames. Only
+   `STREAMING_CLIP_BUFFERS` chunks are resident: chunk under playhead and
+   next chunk, which is read ahead by a worker thread while playhead is in
+   current one. Chunk behind playhead is evicted by reusing its buffer for
+   next read ahead. Jumping to a frame that is not resident (seek) reads
+   its chunk in place. Both a seek and reaching a chunk whose read ahead
+   has not finished yet make playhead wait and are counted in `stalls`.
+
+   Frames wrap around like `AnimationClip` (read ahead after last chunk is
+   first chunk). Define STREAMING_CLIP_NO_THREADS to read chunks on
+   calling thread (default on Windows). */
+typedef struct StreamingClip {
+  int boneCount;      // Number of bones per frame
+  int frameCount;     // Number of frames in clip
+  int chunkFrames;    // Frames per chunk
+  int chunkCount;     // Number of chunks in clip
+  int flags;          // AnimationClip flags of clip (local space)
+  float frameRate;    // Frames per second
+  char name[32];      // Name of clip
+
+  FILE *file;         // File (only used by reader)
+  long framesOffset;  // Offset of first frame in file
+
+  StreamingClipChunk chunks[STREAMING_CLIP_BUFFERS];
+  int current;        // Buffer holding chunk under playhead (-1 if none)
+  int request;        // Buffer worker has to read (-1 if none)
+  int stalls;         // Number of chunk acquires that waited on a read (seek or late read ahead)
+
+#if !defined(STREAMING_CLIP_NO_THREADS)
+  int quit;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+} StreamingClip;
+
+StreamingClip *LoadStreamingClip(const char *fileName, const char *clipName, int chunkFrames);
+void UnloadStreamingClip(StreamingClip *clip);
+size_t StreamingClipMemorySize(StreamingClip *clip);
+
+Pose StreamingClipGetLocalPose(StreamingClip *clip, int frame);
+AnimationClip StreamingClipFrame(StreamingClip *clip, int frame);
+
+// Reads chunk held by buffer. Called without lock (buffer is owned by reader while loading).
+void StreamingClipReadChunk(StreamingClip *clip, StreamingClipChunk *chunk) {
+  int firstFrame = chunk->chunk * clip->chunkFrames;
+  int frames = clip->frameCount - firstFrame;
+  if (frames > clip->chunkFrames) {
+    frames = clip->chunkFrames;
+  }
+
+  size_t count = (size_t)frames * clip->boneCount;
+  long offset = clip->framesOffset + (long)firstFrame * clip->boneCount * (long)sizeof(Transform);
+
+  if (fseek(clip->file, offset, SEEK_SET) != 0 ||
+      fread(chunk->frames, sizeof(Transform), count, clip->file) != count) {
+    TraceLog(LOG_WARNING, "STREAM: Failed to read chunk %d of \"%s\"", chunk->chunk, clip->name);
+    // Keep playing with bind like identity frames instead of garbage
+    for (size_t i = 0; i < count; i++) {
+      chunk->frames[i] = (Transform){{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}};
+    }
+  }
+}
+
+#if !defined(STREAMING_CLIP_NO_THREADS)
+void *StreamingClipWorker(void *data) {
+  StreamingClip *clip = data;
+
+  pthread_mutex_lock(&clip->mutex);
+  while (1) {
+    while (clip->request == -1 && !clip->quit) {
+      pthread_cond_wait(&clip->cond, &clip->mutex);
+    }
+    if (clip->quit) {
+      break;
+    }
+
+    StreamingClipChunk *chunk = &clip->chunks[clip->request];
+
+    pthread_mutex_unlock(&clip->mutex);
+    StreamingClipReadChunk(clip, chunk);
+    pthread_mutex_lock(&clip->mutex);
+
+    chunk->state = STREAMING_CHUNK_READY;
+    clip->request = -1;
+    pthread_cond_broadcast(&clip->cond);
+  }
+  pthread_mutex_unlock(&clip->mutex);
+
+  return NULL;
+}
+#endif
+
+/* Opens clip `clipName` (first clip if NULL) of `.kanim` file. Only file
+   tables are read here, frames are read as playback needs them. */
+StreamingClip *LoadStreamingClip(const char *fileName, const char *clipName, int chunkFrames) {
+  FILE *file = fopen(fileName, "rb");
+  if (file == NULL) {
+    TraceLog(LOG_WARNING, "STREAM: [%s] Failed to open file", fileName);
+    return NULL;
+  }
+
+  KanimHeader header = {0};
+  KanimClipEntry entry = {0};
+  int found = 0;
+
+  if (fread(&header, sizeof(KanimHeader), 1, file) == 1 &&
+      memcmp(header.magic, KANIM_MAGIC, 4) == 0 && header.version == KANIM_VERSION &&
+      header.transformSize == sizeof(Transform) &&
+      fseek(file, (long)header.clipTableOffset, SEEK_SET) == 0) {
+    for (uint32_t i = 0; !found && (i < header.clipCount); i++) {
+      if (fread(&entry, sizeof(KanimClipEntry), 1, file) != 1) {
+        break;
+      }
+      found = (clipName == NULL) || (strncmp(entry.name, clipName, sizeof(entry.name)) == 0);
+    }
+  }
+
+  if (!found || entry.frameCount == 0 || header.boneCount == 0) {
+    TraceLog(LOG_WARNING, "STREAM: [%s] Clip \"%s\" not found", fileName, clipName ? clipName : "");
+    fclose(file);
+    return NULL;
+  }
+
+  if (chunkFrames <= 0 || chunkFrames > (int)entry.frameCount) {
+    chunkFrames = entry.frameCount;
+  }
+
+  StreamingClip *clip = calloc(1, sizeof(StreamingClip));
+  Transform *frames = malloc((size_t)STREAMING_CLIP_BUFFERS * chunkFrames * header.boneCount * sizeof(Transform));
+  if (clip == NULL || frames == NULL) {
+    TraceLog(LOG_WARNING, "STREAM: [%s] Failed to allocate chunks", fileName);
+    free(frames);
+    free(clip);
+    fclose(file);
+    return NULL;
+  }
+
+  clip->boneCount = header.boneCount;
+  clip->frameCount = entry.frameCount;
+  clip->chunkFrames = chunkFrames;
+  clip->chunkCount = (clip->frameCount + chunkFrames - 1) / chunkFrames;
+  clip->flags = entry.flags;
+  clip->frameRate = entry.frameRate;
+  memcpy(clip->name, entry.name, sizeof(clip->name));
+  clip->name[sizeof(clip->name) - 1] = '\0';
+
+  clip->file = file;
+  clip->framesOffset = (long)entry.framesOffset;
+  clip->current = -1;
+  clip->request = -1;
+
+  for (int i = 0; i < STREAMING_CLIP_BUFFERS; i++) {
+    clip->chunks[i].chunk = -1;
+    clip->chunks[i].state = STREAMING_CHUNK_EMPTY;
+    clip->chunks[i].frames = frames + (size_t)i * chunkFrames * clip->boneCount;
+  }
+
+#if !defined(STREAMING_CLIP_NO_THREADS)
+  pthread_mutex_init(&clip->mutex, NULL);
+  pthread_cond_init(&clip->cond, NULL);
+  if (pthread_create(&clip->thread, NULL, StreamingClipWorker, clip) != 0) {
+    TraceLog(LOG_WARNING, "STREAM: [%s] Failed to start reader thread", fileName);
+    pthread_cond_destroy(&clip->cond);
+    pthread_mutex_destroy(&clip->mutex);
+    free(frames);
+    free(clip);
+    fclose(file);
+    return NULL;
+  }
+#endif
+
+  return clip;
+}
+
+void UnloadStreamingClip(StreamingClip *clip) {
+  if (clip == NULL) {
+    return;
+  }
+
+#if !defined(STREAMING_CLIP_NO_THREADS)
+  pthread_mutex_lock(&clip->mutex);
+  clip->quit = 1;
+  pthread_cond_broadcast(&clip->cond);
+  pthread_mutex_unlock(&clip->mutex);
+
+  pthread_join(clip->thread, NULL);
+  pthread_cond_destroy(&clip->cond);
+  pthread_mutex_destroy(&clip->mutex);
+#endif
+
+  fclose(clip->file);
+  free(clip->chunks[0].frames);
+  free(clip);
+}
+
+// Resident frame memory (all chunk buffers).
+size_t StreamingClipMemorySize(StreamingClip *clip) {
+  return sizeof(StreamingClip) +
+         (size_t)STREAMING_CLIP_BUFFERS * clip->chunkFrames * clip->boneCount * sizeof(Transform);
+}
+
+// Buffer holding `chunk` (-1 if none).
+int StreamingClipFindChunk(StreamingClip *clip, int chunk) {
+  for (int i = 0; i < STREAMING_CLIP_BUFFERS; i++) {
+    if (clip->chunks[i].chunk == chunk && clip->chunks[i].state != STREAMING_CHUNK_EMPTY) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+// Any buffer other than `keep` (buffer under playhead).
+int StreamingClipFreeBuffer(StreamingClip *clip, int keep) {
+  for (int i = 0; i < STREAMING_CLIP_BUFFERS; i++) {
+    if (i != keep && clip->chunks[i].state != STREAMING_CHUNK_LOADING) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/* Makes `chunk` resident and returns its buffer. Starts reading next chunk
+   into other buffer if reader is idle. Lock is held by caller. */
+int StreamingClipAcquireChunk(StreamingClip *clip, int chunk) {
+  int buffer;
+  int stalled = 0;
+
+  while (1) {
+    buffer = StreamingClipFindChunk(clip, chunk);
+
+    if (buffer != -1 && clip->chunks[buffer].state == STREAMING_CHUNK_READY) {
+      break;
+    }
+
+    if (buffer == -1 && clip->request == -1) {
+      // Not resident and not read ahead (seek). Playhead waits on this one.
+      buffer = StreamingClipFreeBuffer(clip, -1);
+      clip->chunks[buffer].chunk = chunk;
+      clip->chunks[buffer].state = STREAMING_CHUNK_LOADING;
+      clip->request = buffer;
+      stalled = 1;
+
+#if defined(STREAMING_CLIP_NO_THREADS)
+      StreamingClipReadChunk(clip, &clip->chunks[buffer]);
+      clip->chunks[buffer].state = STREAMING_CHUNK_READY;
+      clip->request = -1;
+#else
+      pthread_cond_broadcast(&clip->cond);
+#endif
+      continue;
+    }
+
+#if !defined(STREAMING_CLIP_NO_THREADS)
+    // Chunk (or other request) is being read
+    if (buffer != -1) {
+      stalled = 1;
+    }
+    pthread_cond_wait(&clip->cond, &clip->mutex);
+#endif
+  }
+
+  clip->stalls += stalled;
+  clip->current = buffer;
+
+  // Read ahead (evicts chunk behind playhead)
+  int next = (chunk + 1) % clip->chunkCount;
+  if (clip->request == -1 && StreamingClipFindChunk(clip, next) == -1) {
+    int ahead = StreamingClipFreeBuffer(clip, buffer);
+
+    if (ahead != -1) {
+      clip->chunks[ahead].chunk = next;
+      clip->chunks[ahead].state = STREAMING_CHUNK_LOADING;
+      clip->request = ahead;
+
+#if defined(STREAMING_CLIP_NO_THREADS)
+      StreamingClipReadChunk(clip, &clip->chunks[ahead]);
+      clip->chunks[ahead].state = STREAMING_CHUNK_READY;
+      clip->request = -1;
+#else
+      pthread_cond_broadcast(&clip->cond);
+#endif
+    }
+  }
+
+  return buffer;
+}
+
+/* Local pose of `frame` (wraps around). Pose is valid till next call on
+   this clip. */
+Pose StreamingClipGetLocalPose(StreamingClip *clip, int frame) {
+  frame %= clip->frameCount;
+  if (frame < 0) {
+    frame += clip->frameCount;
+  }
+
+  int chunk = frame / clip->chunkFrames;
+
+#if !defined(STREAMING_CLIP_NO_THREADS)
+  pthread_mutex_lock(&clip->mutex);
+#endif
+  int buffer = StreamingClipAcquireChunk(clip, chunk);
+#if !defined(STREAMING_CLIP_NO_THREADS)
+  pthread_mutex_unlock(&clip->mutex);
+#endif
+
+  return clip->chunks[buffer].frames + (size_t)(frame - chunk * clip->chunkFrames) * clip->boneCount;
+}
+
+/* One frame `AnimationClip` view of `frame` (local space). It can be given
+   to any clip function of skeleton or layer stack with any frame index
+   (one frame clip wraps every index to it). Valid till next call on this
+   clip. */
+AnimationClip StreamingClipFrame(StreamingClip *clip, int frame) {
+  AnimationClip view = {0};
+
+  view.boneCount = clip->boneCount;
+  view.frameCount = 1;
+  view.flags = CLIP_LOCAL_POSE | (clip->flags & CLIP_ADDITIVE);
+  view.frameRate = clip->frameRate;
+  view.localFrames = StreamingClipGetLocalPose(clip, frame);
+  memcpy(view.name, clip->name, sizeof(view.name));
+
+  return view;
+}
+
+#endif
@@ -4,15 +4,38 @@
 #include <raylib.h>
 #include <raymath.h>
 
+/* Blend flags (can be combined with `USE_LOCAL_POSE` of skeleton functions)
+    - BLEND_NLERP: Use normalized lerp for rotations instead of slerp. Much
+        cheaper (no acos/sin) and close to slerp for small angles.
+    - BLEND_SAME_HEMISPHERE: Rotations being blended are already in same
+        hemisphere (e.g. consecutive frames aligned with
+        `ModelAnimationAlignRotations()`). So, shortest path sign check of
+        nlerp is skipped. Caller must make sure of it, else blend takes
+        long way round. */
+#define BLEND_NLERP (1 << 1)
+#define BLEND_SAME_HEMISPHERE (1 << 2)
+
 Transform TransformScale(Transform transformA, float factor);
+Transform TransformScaleEx(Transform transformA, float factor, int flags);
 Transform TransformLerp(Transform transformA, Transform transformB,
                         float factor);
+Transform TransformLerpEx(Transform transformA, Transform transformB,
+                          float factor, int flags);
+Quaternion QuaternionNlerpShortest(Quaternion q1, Quaternion q2, float amount,
+                                   int flags);
 Transform TransformApply(Transform transformA, Transform transformB);
 Transform TransformToTransformTransform(Transform in, Transform out);
+Transform TransformToTransformTransformInverse(Transform inverseIn, Transform out);
 Transform TransformInvert(Transform transform);
+Transform TransformGlobalToLocal(Transform global, Transform parentGlobal);
+Transform TransformLocalToGlobal(Transform local, Transform parentGlobal);
 Matrix TransformToMatrix(Transform transform);
 
 Transform TransformScale(Transform transform, float factor) {
+  if (factor == 1.0f) {
+    return transform;
+  }
+
   Transform transformResult = {0};
 
   transformResult.translation = Vector3Scale(transform.translation, factor);
@@ -38,6 +61,51 @@ Transform TransformLerp(Transform transformA, Transform transformB,
   return transform;
 }
 
+// Nlerp with shortest path sign fix (skipped with BLEND_SAME_HEMISPHERE).
+Quaternion QuaternionNlerpShortest(Quaternion q1, Quaternion q2, float amount,
+                                   int flags) {
+  if (!(flags & BLEND_SAME_HEMISPHERE) &&
+      (q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w) < 0.0f) {
+    q2 = (Quaternion){-q2.x, -q2.y, -q2.z, -q2.w};
+  }
+
+  return QuaternionNlerp(q1, q2, amount);
+}
+
+Transform TransformScaleEx(Transform transform, float factor, int flags) {
+  if (!(flags & BLEND_NLERP) || factor == 1.0f) {
+    return TransformScale(transform, factor);
+  }
+
+  Transform transformResult = {0};
+
+  transformResult.translation = Vector3Scale(transform.translation, factor);
+  transformResult.rotation = QuaternionNlerpShortest(
+      QuaternionIdentity(), transform.rotation, factor, flags);
+  transformResult.scale.x = pow(transform.scale.x, factor);
+  transformResult.scale.y = pow(transform.scale.y, factor);
+  transformResult.scale.z = pow(transform.scale.z, factor);
+
+  return transformResult;
+}
+
+Transform TransformLerpEx(Transform transformA, Transform transformB,
+                          float amount, int flags) {
+  if (!(flags & BLEND_NLERP)) {
+    return TransformLerp(transformA, transformB, amount);
+  }
+
+  Transform transform = {0};
+
+  transform.translation =
+      Vector3Lerp(transformA.translation, transformB.translation, amount);
+  transform.rotation = QuaternionNlerpShortest(
+      transformA.rotation, transformB.rotation, amount, flags);
+  transform.scale = Vector3Lerp(transformA.scale, transformB.scale, amount);
+
+  return transform;
+}
+
 Transform TransformApply(Transform transformA, Transform transformB) {
   Transform transform = {0};
 
@@ -76,9 +144,15 @@ Transform TransformInvert(Transform transform) {
 }
 
 Transform TransformToTransformTransform(Transform in, Transform out) {
+  return TransformToTransformTransformInverse(TransformInvert(in), out);
+}
+
+/* Same as above with `inverseIn` = `TransformInvert(in)` computed once
+   (e.g. inverse bind pose), so nothing is inverted per call. */
+Transform TransformToTransformTransformInverse(Transform inverseIn, Transform out) {
   Transform result = {0};
 
-  Transform inv = TransformInvert(in);
+  Transform inv = inverseIn;
 
   result.translation =
       Vector3Add(Vector3RotateByQuaternion(
@@ -107,13 +181,64 @@ Transform RelativeTransform(Transform first, Transform second) {
   return out;
 }
 
+// Bone transform relative to its parent (used by local pose conversion).
+Transform TransformGlobalToLocal(Transform global, Transform parentGlobal) {
+  Transform local = {0};
+
+  Quaternion invParentRotation = QuaternionInvert(parentGlobal.rotation);
+
+  local.translation = Vector3RotateByQuaternion(
+      Vector3Subtract(global.translation, parentGlobal.translation),
+      invParentRotation);
+  local.rotation = QuaternionMultiply(invParentRotation, global.rotation);
+  local.scale = Vector3Divide(global.scale, parentGlobal.scale);
+
+  return local;
+}
+
+Transform TransformLocalToGlobal(Transform local, Transform parentGlobal) {
+  Transform global = {0};
+
+  global.translation =
+      Vector3Add(parentGlobal.translation,
+                 Vector3RotateByQuaternion(local.translation,
+                                           parentGlobal.rotation));
+  global.rotation = QuaternionMultiply(parentGlobal.rotation, local.rotation);
+  global.scale = Vector3Multiply(parentGlobal.scale, local.scale);
+
+  return global;
+}
+
+/* Rotation, then translation, then scale (same as multiplying
+   `QuaternionToMatrix()`, `MatrixTranslate()` and `MatrixScale()`). Built
+   directly: every row of rotation and translation is scaled by its axis. */
 Matrix TransformToMatrix(Transform transform) {
-  Matrix boneMatrix = MatrixMultiply(
-      MatrixMultiply(QuaternionToMatrix(transform.rotation),
-                     MatrixTranslate(transform.translation.x,
-                                     transform.translation.y,
-                                     transform.translation.z)),
-      MatrixScale(transform.scale.x, transform.scale.y, transform.scale.z));
+  Quaternion q = transform.rotation;
+  Vector3 t = transform.translation;
+  Vector3 s = transform.scale;
+
+  float x2 = q.x * q.x, y2 = q.y * q.y, z2 = q.z * q.z;
+  float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+  float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+  Matrix boneMatrix = {0};
+
+  boneMatrix.m0 = s.x * (1.0f - 2.0f * (y2 + z2));
+  boneMatrix.m4 = s.x * 2.0f * (xy - wz);
+  boneMatrix.m8 = s.x * 2.0f * (xz + wy);
+  boneMatrix.m12 = s.x * t.x;
+
+  boneMatrix.m1 = s.y * 2.0f * (xy + wz);
+  boneMatrix.m5 = s.y * (1.0f - 2.0f * (x2 + z2));
+  boneMatrix.m9 = s.y * 2.0f * (yz - wx);
+  boneMatrix.m13 = s.y * t.y;
+
+  boneMatrix.m2 = s.z * 2.0f * (xz - wy);
+  boneMatrix.m6 = s.z * 2.0f * (yz + wx);
+  boneMatrix.m10 = s.z * (1.0f - 2.0f * (x2 + y2));
+  boneMatrix.m14 = s.z * t.z;
+
+  boneMatrix.m15 = 1.0f;
 
   return boneMatrix;
 }
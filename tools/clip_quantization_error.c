@@ -0,0 +1,74 @@
+/******************************************************************\
+ Reports size and error of quantized clips
+
+ Loads all animations of a model file, quantizes every clip (local
+   space, see `src/quantized_clip.h`) and prints memory used by
+   float and quantized frames along with max world space position
+   error of any bone against float source.
+
+ Usage:
+   ./clip_quantization_error.out <model file (.glb/.gltf/.iqm/.m3d)>
+
+ This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
+\******************************************************************/
+
+#include <stdio.h>
+
+#include "quantized_clip.h"
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    printf("Usage: %s <model file>\n", argv[0]);
+    return 1;
+  }
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  int animCount = 0;
+  ModelAnimation *anims = LoadModelAnimations(argv[1], &animCount);
+  if (anims == NULL || animCount == 0) {
+    printf("No animations found in \"%s\"\n", argv[1]);
+    return 1;
+  }
+
+  printf("%-32s %6s %5s %10s %10s %6s %12s %s\n", "clip", "frames", "bones",
+         "float(B)", "quant(B)", "ratio", "max err", "(frame, bone)");
+
+  size_t totalFloat = 0, totalQuantized = 0;
+  float worstError = 0.0f;
+
+  for (int i = 0; i < animCount; i++) {
+    AnimationClip clip = LoadAnimationClipFromModelAnimation(anims[i], CLIP_GLOBAL_POSE | CLIP_LOCAL_POSE);
+    SkeletonHierarchy hierarchy = LoadSkeletonHierarchy(anims[i].bones, anims[i].boneCount);
+    QuantizedClip quantized = LoadQuantizedClip(clip, CLIP_LOCAL_POSE);
+
+    int frame = 0, boneId = 0;
+    float error = QuantizedClipMeasureWorldError(quantized, clip, &hierarchy, &frame, &boneId);
+
+    size_t floatSize = (size_t)clip.frameCount * clip.boneCount * sizeof(Transform);
+    size_t quantizedSize = QuantizedClipMemorySize(quantized);
+
+    printf("%-32s %6d %5d %10zu %10zu %5.2fx %12.6f (%d, %s)\n", clip.name,
+           clip.frameCount, clip.boneCount, floatSize, quantizedSize,
+           (double)floatSize / quantizedSize, error, frame,
+           anims[i].bones[boneId].name);
+
+    totalFloat += floatSize;
+    totalQuantized += quantizedSize;
+    if (error > worstError) {
+      worstError = error;
+    }
+
+    UnloadQuantizedClip(quantized);
+    UnloadSkeletonHierarchy(hierarchy);
+    UnloadAnimationClip(clip);
+  }
+
+  printf("Total: float %zu B, quantized %zu B (%.2fx), max world error %f\n",
+         totalFloat, totalQuantized, (double)totalFloat / totalQuantized,
+         worstError);
+
+  UnloadModelAnimations(anims, animCount);
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+/******************************************************************\
+ Reports keys, size and error of reduced clips
+
+ Loads all animations of a model file, reduces every clip to keys
+   within given world space error budget (see `src/reduced_clip.h`)
+   and prints keys kept, memory used by float frames and keys along
+   with max world space position error of any bone against source.
+
+ Usage:
+   ./clip_reduction_report.out <model file> [max error] [linear|catmull-rom]
+
+   Max error is in model units (default 0.001). Default curve is linear.
+
+ This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
+\******************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "reduced_clip.h"
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    printf("Usage: %s <model file> [max error] [linear|catmull-rom]\n", argv[0]);
+    return 1;
+  }
+
+  float maxError = (argc > 2) ? (float)atof(argv[2]) : 0.001f;
+  int curve = (argc > 3 && strcmp(argv[3], "catmull-rom") == 0) ? CURVE_CATMULL_ROM : CURVE_LINEAR;
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  int animCount = 0;
+  ModelAnimation *anims = LoadModelAnimations(argv[1], &animCount);
+  if (anims == NULL || animCount == 0) {
+    printf("No animations found in \"%s\"\n", argv[1]);
+    return 1;
+  }
+
+  printf("%-32s %6s %5s %8s %10s %10s %6s %12s %s\n", "clip", "frames", "bones",
+         "keys", "float(B)", "keys(B)", "ratio", "max err", "(frame, bone)");
+
+  size_t totalFloat = 0, totalReduced = 0;
+  float worstError = 0.0f;
+
+  for (int i = 0; i < animCount; i++) {
+    AnimationClip clip = LoadAnimationClipFromModelAnimation(anims[i], CLIP_GLOBAL_POSE | CLIP_LOCAL_POSE);
+    SkeletonHierarchy hierarchy = LoadSkeletonHierarchy(anims[i].bones, anims[i].boneCount);
+    ReducedClip reduced = LoadReducedClip(clip, &hierarchy, maxError, curve);
+
+    int frame = 0, boneId = 0;
+    float error = ReducedClipMeasureWorldError(reduced, clip, &hierarchy, &frame, &boneId);
+
+    size_t floatSize = (size_t)clip.frameCount * clip.boneCount * sizeof(Transform);
+    size_t reducedSize = ReducedClipMemorySize(reduced);
+
+    printf("%-32s %6d %5d %8d %10zu %10zu %5.2fx %12.6f (%d, %s)\n", clip.name,
+           clip.frameCount, clip.boneCount, reduced.keyCount, floatSize,
+           reducedSize, (double)floatSize / reducedSize, error, frame,
+           anims[i].bones[boneId].name);
+
+    totalFloat += floatSize;
+    totalReduced += reducedSize;
+    if (error > worstError) {
+      worstError = error;
+    }
+
+    UnloadReducedClip(reduced);
+    UnloadSkeletonHierarchy(hierarchy);
+    UnloadAnimationClip(clip);
+  }
+
+  printf("Total: float %zu B, reduced %zu B (%.2fx), max world error %f (budget %f)\n",
+         totalFloat, totalReduced, (double)totalFloat / totalReduced,
+         worstError, maxError);
+
+  UnloadModelAnimations(anims, animCount);
+
+  return 0;
+}
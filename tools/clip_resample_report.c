@@ -0,0 +1,81 @@
+/******************************************************************\
+ Reports size and error of resampled clips
+
+ Loads all animations of a model file, re-bakes every clip at given
+   frame rate (see `LoadResampledAnimationClip()` in
+   `src/animation_clip.h`) and prints memory used by source and
+   resampled frames along with max world space position error of any
+   bone when resampled clip is sampled at time of every source frame.
+
+ Usage:
+   ./clip_resample_report.out <model file> [frame rate] [loop|clamp]
+
+   Default frame rate is 15. Default time mode is loop.
+
+ This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
+\******************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "animation_clip.h"
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    printf("Usage: %s <model file> [frame rate] [loop|clamp]\n", argv[0]);
+    return 1;
+  }
+
+  float frameRate = (argc > 2) ? (float)atof(argv[2]) : 15.0f;
+  int mode = (argc > 3 && strcmp(argv[3], "clamp") == 0) ? CLIP_TIME_CLAMP : CLIP_TIME_LOOP;
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  int animCount = 0;
+  ModelAnimation *anims = LoadModelAnimations(argv[1], &animCount);
+  if (anims == NULL || animCount == 0) {
+    printf("No animations found in \"%s\"\n", argv[1]);
+    return 1;
+  }
+
+  printf("%-32s %6s %6s %7s %10s %10s %6s %12s %s\n", "clip", "frames", "after",
+         "rate", "source(B)", "after(B)", "ratio", "max err", "(frame, bone)");
+
+  size_t totalSource = 0, totalResampled = 0;
+  float worstError = 0.0f;
+
+  for (int i = 0; i < animCount; i++) {
+    AnimationClip clip = LoadAnimationClipFromModelAnimation(anims[i], CLIP_LOCAL_POSE);
+    SkeletonHierarchy hierarchy = LoadSkeletonHierarchy(anims[i].bones, anims[i].boneCount);
+    AnimationClip resampled = LoadResampledAnimationClip(clip, frameRate, mode, &hierarchy);
+
+    int frame = 0, boneId = 0;
+    float error = AnimationClipMeasureResampleError(resampled, clip, mode, &hierarchy, &frame, &boneId);
+
+    size_t sourceSize = (size_t)clip.frameCount * clip.boneCount * sizeof(Transform);
+    size_t resampledSize = (size_t)resampled.frameCount * resampled.boneCount * sizeof(Transform);
+
+    printf("%-32s %6d %6d %7.2f %10zu %10zu %5.2fx %12.6f (%d, %s)\n", clip.name,
+           clip.frameCount, resampled.frameCount, resampled.frameRate,
+           sourceSize, resampledSize, (double)sourceSize / resampledSize,
+           error, frame, anims[i].bones[boneId].name);
+
+    totalSource += sourceSize;
+    totalResampled += resampledSize;
+    if (error > worstError) {
+      worstError = error;
+    }
+
+    UnloadAnimationClip(resampled);
+    UnloadSkeletonHierarchy(hierarchy);
+    UnloadAnimationClip(clip);
+  }
+
+  printf("Total: source %zu B, resampled %zu B (%.2fx), max world error %f\n",
+         totalSource, totalResampled, (double)totalSource / totalResampled,
+         worstError);
+
+  UnloadModelAnimations(anims, animCount);
+
+  return 0;
+}
@@ -0,0 +1,203 @@
+/******************************************************************\
+ Headless crowd benchmark of job system
+
+ Updates a crowd of characters every frame on 1 to N threads (see
+   `src/job_system.h`) and prints time per frame and speedup over
+   one thread. Update of every character is: two time sampled clips
+   blended in its own `LayerStack`, local to global pose and skinning
+   palette. Characters are `SkeletonInstance`s of one shared
+   `SkeletonDef`. Temporaries come from one `PoseArena` per worker.
+   Palettes are checksummed to show all thread counts compute the same
+   crowd.
+
+ Without model file a synthetic 65 bone skeleton with procedural
+   clips is used. With model file its first two animations are used
+   (first frame of first animation stands in for bind pose, as model
+   meshes are not loaded headless).
+
+ Usage:
+   ./crowd_benchmark.out [characters] [frames] [max threads] [model file]
+
+   Defaults: 1000 characters, 100 frames, one thread per CPU.
+
+ This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
+\******************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+
+#include "job_system.h"
+#include "layer_stack.h"
+#include "skeleton_def.h"
+#include "tool_common.h"
+
+typedef struct Character {
+  SkeletonInstance instance; // Own pose and palette
+  LayerStack layers;   // Own working poses
+  float time;          // Playback time (seconds)
+  float speed;         // Playback speed
+  float blend;         // Weight of second clip
+} Character;
+
+typedef struct Crowd {
+  Character *characters;
+  AnimationClip clips[2];
+  PoseArena arenas[JOB_SYSTEM_MAX_THREADS]; // One per worker
+  float deltaTime;
+} Crowd;
+
+void UpdateCrowdJob(void *data, int begin, int end, int workerId) {
+  Crowd *crowd = data;
+
+  for (int i = begin; i < end; i++) {
+    Character *character = &crowd->characters[i];
+    character->instance.arena = &crowd->arenas[workerId];
+    Skeleton skeleton = SkeletonInstanceView(character->instance);
+
+    character->time += crowd->deltaTime * character->speed;
+
+    ClearLayerStack(&character->layers);
+    LayerStackPushAnimationClipTime(&character->layers, crowd->clips[0], character->time, CLIP_TIME_LOOP);
+    LayerStackPushAnimationClipTimeOverride(&character->layers, crowd->clips[1], character->time, CLIP_TIME_LOOP,
+                                            character->blend, NULL);
+    UpdateSkeletonFromLayerStack(skeleton, &character->layers);
+
+    UpdateSkeletonInstancePalette(character->instance);
+
+    ResetPoseArena(skeleton.arena);
+  }
+}
+
+int main(int argc, char **argv) {
+  int characterCount = (argc > 1) ? atoi(argv[1]) : 1000;
+  int frames = (argc > 2) ? atoi(argv[2]) : 100;
+  int maxThreads = (argc > 3) ? atoi(argv[3]) : GetCpuCount();
+  const char *fileName = (argc > 4) ? argv[4] : NULL;
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  Crowd crowd = {0};
+  crowd.deltaTime = 1.0f / 60.0f;
+
+  BoneInfo *bones = NULL;
+  int boneCount = 65;
+  Pose bindPose = NULL;
+
+  ModelAnimation *anims = NULL;
+  int animCount = 0;
+
+  if (fileName) {
+    anims = LoadModelAnimations(fileName, &animCount);
+    if (anims == NULL || animCount == 0) {
+      printf("No animations found in \"%s\"\n", fileName);
+      return 1;
+    }
+
+    bones = anims[0].bones;
+    boneCount = anims[0].boneCount;
+    bindPose = CopyPose(anims[0].framePoses[0], boneCount);
+    crowd.clips[0] = LoadAnimationClipFromModelAnimation(anims[0], CLIP_LOCAL_POSE);
+    crowd.clips[1] = LoadAnimationClipFromModelAnimation(anims[(animCount > 1) ? 1 : 0], CLIP_LOCAL_POSE);
+  } else {
+    LoadSyntheticRig(&bones, boneCount, SYNTHETIC_TREE_CHAINS, crowd.clips, 2, 30);
+  }
+
+  if (bindPose == NULL) {
+    SkeletonHierarchy hierarchy = LoadSkeletonHierarchy(bones, boneCount);
+    bindPose = InitPose(boneCount);
+    PoseToGlobalTransformPoseHierarchyInto(bindPose, AnimationClipGetLocalPose(crowd.clips[0], 0), &hierarchy);
+    UnloadSkeletonHierarchy(hierarchy);
+  }
+  SkeletonDef *def = LoadSkeletonDef(bones, bindPose, boneCount);
+
+  crowd.characters = calloc(characterCount, sizeof(Character));
+  for (int i = 0; i < characterCount; i++) {
+    Character *character = &crowd.characters[i];
+
+    character->instance = LoadSkeletonInstance(def);
+    character->layers = LoadLayerStack(SkeletonInstanceView(character->instance));
+    character->speed = 0.8f + 0.4f * (i % 7) / 6.0f;
+    character->blend = (i % 11) / 10.0f;
+  }
+
+  if (maxThreads < 1) {
+    maxThreads = 1;
+  }
+  if (maxThreads > JOB_SYSTEM_MAX_THREADS) {
+    maxThreads = JOB_SYSTEM_MAX_THREADS;
+  }
+  for (int i = 0; i < maxThreads; i++) {
+    crowd.arenas[i] = LoadPoseArenaForPoses(boneCount, 4);
+  }
+
+  printf("%d characters, %d bones, %d frames, %d CPUs, %zu B per instance\n", characterCount, boneCount, frames,
+         GetCpuCount(), SkeletonInstanceMemorySize(def));
+  printf("%8s %12s %14s %9s %11s %8s %s\n", "threads", "ms/frame", "characters/ms", "speedup", "efficiency", "steals", "checksum");
+
+  double singleThreadTime = 0.0;
+
+  for (int threads = 1; threads <= maxThreads; threads = (threads * 2 <= maxThreads || threads == maxThreads) ? threads * 2 : maxThreads) {
+    JobSystem *jobs = LoadJobSystem(threads);
+
+    for (int i = 0; i < characterCount; i++) {
+      crowd.characters[i].time = 0.0f;
+    }
+
+    RunJobs(jobs, UpdateCrowdJob, &crowd, characterCount, 0); // Warm up
+
+    double start = Now();
+    for (int frame = 0; frame < frames; frame++) {
+      RunJobs(jobs, UpdateCrowdJob, &crowd, characterCount, 0);
+    }
+    double frameTime = (Now() - start) / frames;
+
+    int steals = 0;
+    for (int w = 0; w < jobs->threadCount; w++) {
+      steals += jobs->deques[w].steals;
+    }
+
+    double checksum = 0.0;
+    for (int i = 0; i < characterCount; i++) {
+      for (int b = 0; b < boneCount; b++) {
+        checksum += crowd.characters[i].instance.palette[b].m12 + crowd.characters[i].instance.palette[b].m13;
+      }
+    }
+
+    if (threads == 1) {
+      singleThreadTime = frameTime;
+    }
+
+    double speedup = singleThreadTime / frameTime;
+    printf("%8d %12.3f %14.1f %8.2fx %10.0f%% %8d %.6e\n", jobs->threadCount, frameTime * 1e3,
+           characterCount / (frameTime * 1e3), speedup, 100.0 * speedup / jobs->threadCount,
+           steals, checksum);
+
+    UnloadJobSystem(jobs);
+
+    if (threads == maxThreads) {
+      break;
+    }
+  }
+
+  for (int i = 0; i < maxThreads; i++) {
+    UnloadPoseArena(&crowd.arenas[i]);
+  }
+  for (int i = 0; i < characterCount; i++) {
+    UnloadSkeletonInstance(crowd.characters[i].instance);
+    UnloadLayerStack(&crowd.characters[i].layers);
+  }
+  free(crowd.characters);
+
+  UnloadSkeletonDef(def);
+  UnloadPose(bindPose);
+  UnloadAnimationClip(crowd.clips[0]);
+  UnloadAnimationClip(crowd.clips[1]);
+  if (anims) {
+    UnloadModelAnimations(anims, animCount);
+  } else {
+    free(bones);
+  }
+
+  return 0;
+}
@@ -0,0 +1,97 @@
+/******************************************************************\
+ Bakes model animations into `.kanim` file
+
+ Loads all animations of every given model file, converts them
+   into local space clips and writes them with one shared bone table
+   into a `.kanim` file (see `src/kanim_file.h`). Files whose bone
+   table does not match the first file are skipped.
+
+ Usage:
+   ./kanim_bake.out <output.kanim> <model file> [model file ...]
+
+ This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
+\******************************************************************/
+
+#include <stdio.h>
+
+#include "kanim_file.h"
+
+// Same bone names and parents
+int BoneTablesMatch(BoneInfo *a, int aCount, BoneInfo *b, int bCount) {
+  if (aCount != bCount) {
+    return 0;
+  }
+
+  for (int i = 0; i < aCount; i++) {
+    if (a[i].parent != b[i].parent || strncmp(a[i].name, b[i].name, sizeof(a[i].name)) != 0) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    printf("Usage: %s <output.kanim> <model file> [model file ...]\n", argv[0]);
+    return 1;
+  }
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  BoneInfo *bones = NULL;
+  int boneCount = 0;
+
+  AnimationClip *clips = NULL;
+  int clipCount = 0;
+
+  ModelAnimation **animFiles = calloc(argc, sizeof(ModelAnimation *));
+  int *animFileCounts = calloc(argc, sizeof(int));
+
+  for (int i = 2; i < argc; i++) {
+    animFiles[i] = LoadModelAnimations(argv[i], &animFileCounts[i]);
+    if (animFiles[i] == NULL || animFileCounts[i] == 0) {
+      printf("Skipping \"%s\": no animations\n", argv[i]);
+      continue;
+    }
+
+    ModelAnimation *anims = animFiles[i];
+    if (bones == NULL) {
+      bones = anims[0].bones;
+      boneCount = anims[0].boneCount;
+    }
+
+    clips = realloc(clips, (clipCount + animFileCounts[i]) * sizeof(AnimationClip));
+
+    for (int j = 0; j < animFileCounts[i]; j++) {
+      if (!BoneTablesMatch(bones, boneCount, anims[j].bones, anims[j].boneCount)) {
+        printf("Skipping \"%s\" of \"%s\": bone table does not match\n", anims[j].name, argv[i]);
+        continue;
+      }
+
+      clips[clipCount] = LoadAnimationClipFromModelAnimation(anims[j], CLIP_LOCAL_POSE);
+      if (AnimationClipIsValid(clips[clipCount])) {
+        printf("%-32s %6d frames\n", clips[clipCount].name, clips[clipCount].frameCount);
+        clipCount++;
+      }
+    }
+  }
+
+  int success = (clipCount > 0) && ExportKanimFile(argv[1], bones, boneCount, clips, clipCount);
+  if (success) {
+    printf("Wrote %d clips (%d bones) to \"%s\"\n", clipCount, boneCount, argv[1]);
+  } else {
+    printf("Failed to write \"%s\"\n", argv[1]);
+  }
+
+  UnloadAnimationClips(clips, clipCount);
+  for (int i = 2; i < argc; i++) {
+    if (animFiles[i]) {
+      UnloadModelAnimations(animFiles[i], animFileCounts[i]);
+    }
+  }
+  free(animFileCounts);
+  free(animFiles);
+
+  return success ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+/******************************************************************\
+ Headless benchmark of animation LOD
+
+ Updates a crowd of characters with `AnimationLod` (see
+   `src/animation_lod.h`) and prints cost of every level and of a
+   crowd spread over camera distances, against evaluating every
+   character at full detail.
+
+ Levels used:
+   0: all bones, every frame, full rate clip
+   1: bones deeper than 4 excluded, every 2 frames
+   2: bones deeper than 3 excluded, every 4 frames, half rate clip
+   3: bones deeper than 2 excluded, every 8 frames, quarter rate clip
+
+ Update of every character is: sample clip (only on evaluated frames),
+   blend last two evaluations, local to global pose and skinning
+   palette. Uses a synthetic 65 bone skeleton (binary tree, 6 levels
+   deep) with a procedural clip.
+
+ Usage:
+   ./lod_benchmark.out [characters] [frames] [max distance]
+
+   Defaults: 1000 characters, 240 frames, 100 units (characters are
+   spread evenly from camera to max distance).
+
+ This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
+\******************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+
+#include "animation_lod.h"
+#include "skeleton_def.h"
+#include "tool_common.h"
+
+#define LOD_LEVELS 4
+#define MIP_COUNT 3
+
+typedef struct Character {
+  SkeletonInstance instance; // Own pose and palette
+  AnimationLodInstance lod;  // Own LOD state
+  Vector3 position;          // Position in world
+  float time;                // Playback time (seconds)
+} Character;
+
+typedef struct Crowd {
+  Character *characters;
+  int characterCount;
+  AnimationLod lod;
+  AnimationClip *mips;
+  Vector3 camera;
+  float deltaTime;
+  int forcedLevel;       // Level for all characters (-1 to select from distance)
+  int levelCounts[LOD_LEVELS];
+  int evaluations;       // Full evaluations in last frames
+} Crowd;
+
+void UpdateCrowd(Crowd *crowd) {
+  for (int i = 0; i < crowd->characterCount; i++) {
+    Character *character = &crowd->characters[i];
+    Skeleton skeleton = SkeletonInstanceView(character->instance);
+
+    int level = crowd->forcedLevel;
+    if (level < 0) {
+      level = AnimationLodSelectLevel(&crowd->lod, Vector3Distance(crowd->camera, character->position));
+    }
+    if (level != character->lod.level) {
+      SetAnimationLodInstanceLevel(&crowd->lod, &character->lod, level);
+    }
+    crowd->levelCounts[level]++;
+
+    character->time += crowd->deltaTime;
+
+    if (AnimationLodBeginUpdate(&crowd->lod, &character->lod)) {
+      AnimationClip clip = crowd->mips[crowd->lod.levels[level].clipMip];
+      AnimationLodSampleClipInto(character->lod.currentPose, &crowd->lod, level, clip, character->time, CLIP_TIME_LOOP);
+      crowd->evaluations++;
+    }
+    AnimationLodEndUpdate(&crowd->lod, &character->lod, skeleton, 0);
+
+    AnimationLodUpdatePalette(&crowd->lod, level, character->instance);
+  }
+}
+
+// Returns time per frame (seconds).
+double RunCrowd(Crowd *crowd, int frames) {
+  for (int i = 0; i < crowd->characterCount; i++) {
+    crowd->characters[i].time = 0.0f;
+  }
+
+  UpdateCrowd(crowd); // Warm up
+
+  for (int l = 0; l < LOD_LEVELS; l++) {
+    crowd->levelCounts[l] = 0;
+  }
+  crowd->evaluations = 0;
+
+  double start = Now();
+  for (int frame = 0; frame < frames; frame++) {
+    UpdateCrowd(crowd);
+  }
+
+  return (Now() - start) / frames;
+}
+
+// Excludes bones deeper than `maxDepth` from `level` on.
+void ExcludeDeepBones(AnimationLod *lod, int level, int maxDepth) {
+  BoneMask mask = BoneMaskZeros(lod->hierarchy.boneCount);
+
+  for (int i = 0; i < lod->hierarchy.boneCount; i++) {
+    if (lod->hierarchy.depth[i] > maxDepth) {
+      mask[i] = 1.0f;
+    }
+  }
+  AnimationLodExcludeBones(lod, level, mask);
+
+  UnloadBoneMask(mask);
+}
+
+int main(int argc, char **argv) {
+  int characterCount = (argc > 1) ? atoi(argv[1]) : 1000;
+  int frames = (argc > 2) ? atoi(argv[2]) : 240;
+  float maxDistance = (argc > 3) ? (float)atof(argv[3]) : 100.0f;
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  int boneCount = 65;
+  BoneInfo *bones = NULL;
+  AnimationClip clip = {0};
+  LoadSyntheticRig(&bones, boneCount, SYNTHETIC_TREE_BINARY, &clip, 1, 60);
+
+  SkeletonHierarchy hierarchy = LoadSkeletonHierarchy(bones, boneCount);
+  Pose bindPose = InitPose(boneCount);
+  PoseToGlobalTransformPoseHierarchyInto(bindPose, AnimationClipGetLocalPose(clip, 0), &hierarchy);
+  UnloadSkeletonHierarchy(hierarchy);
+
+  SkeletonDef *def = LoadSkeletonDef(bones, bindPose, boneCount);
+
+  Crowd crowd = {0};
+  crowd.characterCount = characterCount;
+  crowd.deltaTime = 1.0f / 60.0f;
+  crowd.mips = LoadAnimationClipMips(clip, MIP_COUNT, CLIP_TIME_LOOP, &def->hierarchy);
+
+  crowd.characters = calloc(characterCount, sizeof(Character));
+  for (int i = 0; i < characterCount; i++) {
+    crowd.characters[i].instance = LoadSkeletonInstance(def);
+  }
+
+  crowd.lod = LoadAnimationLod(SkeletonInstanceView(crowd.characters[0].instance), LOD_LEVELS);
+  SetAnimationLodLevel(&crowd.lod, 0, 0.15f * maxDistance, 1, 0);
+  SetAnimationLodLevel(&crowd.lod, 1, 0.35f * maxDistance, 2, 0);
+  SetAnimationLodLevel(&crowd.lod, 2, 0.65f * maxDistance, 4, 1);
+  SetAnimationLodLevel(&crowd.lod, 3, maxDistance, 8, 2);
+  ExcludeDeepBones(&crowd.lod, 1, 4);
+  ExcludeDeepBones(&crowd.lod, 2, 3);
+  ExcludeDeepBones(&crowd.lod, 3, 2);
+
+  for (int i = 0; i < characterCount; i++) {
+    Character *character = &crowd.characters[i];
+    float distance = maxDistance * (i + 0.5f) / characterCount;
+    float angle = 2.4f * i;
+
+    character->lod = LoadAnimationLodInstance(&crowd.lod, i);
+    character->position = (Vector3){distance * cosf(angle), 0.0f, distance * sinf(angle)};
+  }
+
+  printf("%d characters, %d bones, %d frames\n", characterCount, boneCount, frames);
+  printf("%6s %9s %7s %9s %6s %12s %12s %9s\n", "level", "distance", "bones", "interval", "mip", "ms/frame", "us/character", "speedup");
+
+  double levelTimes[LOD_LEVELS];
+
+  for (int level = 0; level < LOD_LEVELS; level++) {
+    AnimationLodLevel *lodLevel = &crowd.lod.levels[level];
+
+    crowd.forcedLevel = level;
+    levelTimes[level] = RunCrowd(&crowd, frames);
+
+    printf("%6d %9.1f %7d %9d %6d %12.3f %12.3f %8.2fx\n", level, lodLevel->distance, lodLevel->boneCount,
+           lodLevel->updateInterval, lodLevel->clipMip, levelTimes[level] * 1e3,
+           levelTimes[level] * 1e6 / characterCount, levelTimes[0] / levelTimes[level]);
+  }
+
+  crowd.forcedLevel = -1;
+  double mixedTime = RunCrowd(&crowd, frames);
+
+  printf("\nMixed distances (0 to %.1f):", maxDistance);
+  for (int level = 0; level < LOD_LEVELS; level++) {
+    printf(" level %d: %d", level, crowd.levelCounts[level] / frames);
+  }
+  printf("\n");
+  printf("  full detail %.3f ms/frame, LOD %.3f ms/frame (%.2fx), %.1f%% characters evaluated per frame\n",
+         levelTimes[0] * 1e3, mixedTime * 1e3, levelTimes[0] / mixedTime,
+         100.0 * crowd.evaluations / ((double)frames * characterCount));
+
+  for (int i = 0; i < characterCount; i++) {
+    UnloadAnimationLodInstance(crowd.characters[i].lod);
+    UnloadSkeletonInstance(crowd.characters[i].instance);
+  }
+  free(crowd.characters);
+
+  UnloadAnimationLod(&crowd.lod);
+  UnloadAnimationClipMips(crowd.mips, MIP_COUNT);
+  UnloadSkeletonDef(def);
+  UnloadPose(bindPose);
+  UnloadAnimationClip(clip);
+  free(bones);
+
+  return 0;
+}
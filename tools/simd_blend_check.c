@@ -0,0 +1,150 @@
+/******************************************************************\
+ Checks SIMD blend kernels against scalar path
+
+ Blends random transforms with `TransformLerpBatch()` and
+   `TransformAdditiveBatch()` (see `src/pose_simd.h`) and compares
+   every lane with `TransformLerpEx()` and
+   `TransformApply(TransformScaleEx(), TransformScaleEx())`. Rotation
+   pairs are swept over cases where slerp changes branch:
+   nearly identical, nearly antipodal, around nlerp threshold (dot
+   0.95) and random (weights outside [0, 1] included).
+
+ Prints max difference of any component per case and number of lanes
+   above `KANIM_SIMD_TOLERANCE`. Exits with 1 if any lane is above.
+
+ Usage:
+   ./simd_blend_check.out [lanes per case]
+
+   Defaults: 1048576 lanes. Build with SIMD flags to check SIMD path
+   (e.g. `make CFLAGS="-I../src -O2 -mavx2"`), otherwise scalar path
+   is checked against itself.
+
+ This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
+\******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pose_simd.h"
+
+#define CASE_RANDOM 0
+#define CASE_IDENTICAL 1
+#define CASE_ANTIPODAL 2
+#define CASE_THRESHOLD 3
+#define CASE_COUNT 4
+
+unsigned int seed = 1;
+
+// Uniform in [-1, 1].
+float Random(void) {
+  seed = seed * 1664525u + 1013904223u;
+
+  return (seed >> 8) / 8388608.0f - 1.0f;
+}
+
+Quaternion RandomRotation(void) {
+  return QuaternionNormalize((Quaternion){Random(), Random(), Random(), Random()});
+}
+
+// Rotation of `q` by `angle` (radians) about a random axis.
+Quaternion RotateRandomAxis(Quaternion q, float angle) {
+  Vector3 axis = Vector3Normalize((Vector3){Random(), Random(), Random()});
+
+  return QuaternionMultiply(q, QuaternionFromAxisAngle(axis, angle));
+}
+
+// Rotation paired with `q` for `testCase`.
+Quaternion PairedRotation(Quaternion q, int testCase, int index) {
+  switch (testCase) {
+    case CASE_IDENTICAL:
+    case CASE_ANTIPODAL: {
+      // Per component noise from 1e-7 to 4e-4 (dot rounds to 1 or just below)
+      float noise = 1e-7f * (1 << (index % 13));
+      Quaternion r = QuaternionNormalize((Quaternion){q.x + noise * Random(), q.y + noise * Random(),
+                                                      q.z + noise * Random(), q.w + noise * Random()});
+      return (testCase == CASE_ANTIPODAL) ? (Quaternion){-r.x, -r.y, -r.z, -r.w} : r;
+    }
+    case CASE_THRESHOLD:
+      return RotateRandomAxis(q, 2.0f * acosf(0.95f + 1e-6f * Random()));
+    default:
+      return RandomRotation();
+  }
+}
+
+float TransformDifference(Transform a, Transform b) {
+  float d[10] = {a.translation.x - b.translation.x, a.translation.y - b.translation.y,
+                 a.translation.z - b.translation.z, a.rotation.x - b.rotation.x,
+                 a.rotation.y - b.rotation.y, a.rotation.z - b.rotation.z,
+                 a.rotation.w - b.rotation.w, a.scale.x - b.scale.x,
+                 a.scale.y - b.scale.y, a.scale.z - b.scale.z};
+  float difference = 0.0f;
+
+  for (int i = 0; i < 10; i++) {
+    difference = fmaxf(difference, fabsf(d[i]));
+  }
+
+  return difference;
+}
+
+int main(int argc, char **argv) {
+  int count = (argc > 1) ? atoi(argv[1]) : 1 << 20;
+
+  const char *caseNames[CASE_COUNT] = {"random", "identical", "antipodal", "dot 0.95"};
+  const char *blendNames[3] = {"slerp", "nlerp", "additive"};
+
+  Transform *a = malloc(count * sizeof(Transform));
+  Transform *b = malloc(count * sizeof(Transform));
+  Transform *out = malloc(count * sizeof(Transform));
+  float *weights = malloc(count * sizeof(float));
+
+  printf("%d lanes per case, %d lanes per instruction, tolerance %.0e\n", count, KANIM_SIMD_LANES, KANIM_SIMD_TOLERANCE);
+  printf("%-10s %-9s %12s %12s\n", "case", "blend", "max diff", "lanes above");
+
+  int failed = 0;
+
+  for (int testCase = 0; testCase < CASE_COUNT; testCase++) {
+    for (int i = 0; i < count; i++) {
+      Quaternion q = RandomRotation();
+
+      a[i] = (Transform){{Random(), Random(), Random()}, q, {1.0f + 0.5f * Random(), 1.0f, 1.0f}};
+      b[i] = (Transform){{Random(), Random(), Random()}, PairedRotation(q, testCase, i), {1.0f, 1.0f + 0.5f * Random(), 1.0f}};
+      weights[i] = (testCase == CASE_RANDOM) ? 0.5f + Random() : 0.5f + 0.5f * Random();
+    }
+
+    for (int blend = 0; blend < 3; blend++) {
+      int flags = (blend == 1) ? BLEND_NLERP : 0;
+
+      // Additive: `b` relative to `a` (near identity for identical case)
+      if (blend == 2) {
+        for (int i = 0; i < count; i++) {
+          b[i].rotation = QuaternionMultiply(QuaternionInvert(a[i].rotation), b[i].rotation);
+        }
+        TransformAdditiveBatch(out, a, b, count, 1.0f, 1.0f, weights, flags);
+      } else {
+        TransformLerpBatch(out, a, b, count, 1.0f, weights, flags);
+      }
+
+      float maxDifference = 0.0f;
+      int above = 0;
+
+      for (int i = 0; i < count; i++) {
+        Transform expected = (blend == 2) ? TransformApply(a[i], TransformScaleEx(b[i], weights[i], flags))
+                                          : TransformLerpEx(a[i], b[i], weights[i], flags);
+        float difference = TransformDifference(out[i], expected);
+
+        maxDifference = fmaxf(maxDifference, difference);
+        above += (difference > KANIM_SIMD_TOLERANCE);
+      }
+
+      printf("%-10s %-9s %12.2e %12d\n", caseNames[testCase], blendNames[blend], maxDifference, above);
+      failed |= (above > 0);
+    }
+  }
+
+  free(a);
+  free(b);
+  free(out);
+  free(weights);
+
+  return failed;
+}
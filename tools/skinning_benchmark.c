@@ -0,0 +1,216 @@
+/******************************************************************\
+ Headless benchmark of CPU skinning
+
+ Skins a synthetic mesh (see `src/cpu_skinning.h`) and prints
+   vertices per second of a plain per vertex loop (4 influences,
+   raymath) and of `SkinMeshCpu()` on 1 to N threads, with max
+   difference of positions and normals from plain loop.
+
+ Mesh is a tube around a chain of bones. Vertices have 1 to 4
+   influences (mixed like a character mesh: most have 1 or 2) and
+   palette comes from a bent and scaled pose of the chain.
+
+ Usage:
+   ./skinning_benchmark.out [vertices] [iterations] [max threads]
+
+   Defaults: 200000 vertices, 50 iterations, one thread per CPU.
+
+ This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
+\******************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+
+#include "cpu_skinning.h"
+#include "pose.h"
+#include "tool_common.h"
+
+#define BONE_COUNT 64
+
+// Tube of `vertexCount` vertices along y, skinned to a chain of bones.
+Mesh LoadSyntheticMesh(int vertexCount) {
+  Mesh mesh = {0};
+
+  mesh.vertexCount = vertexCount;
+  mesh.boneCount = BONE_COUNT;
+  mesh.vertices = malloc(3 * vertexCount * sizeof(float));
+  mesh.normals = malloc(3 * vertexCount * sizeof(float));
+  mesh.boneIds = calloc(4 * vertexCount, 1);
+  mesh.boneWeights = calloc(4 * vertexCount, sizeof(float));
+
+  int ringSize = 32;
+
+  for (int v = 0; v < vertexCount; v++) {
+    float angle = 2.0f * PI * (v % ringSize) / ringSize;
+    float height = (float)BONE_COUNT * (v / ringSize) / (vertexCount / ringSize + 1);
+
+    mesh.vertices[3 * v + 0] = 0.2f * cosf(angle);
+    mesh.vertices[3 * v + 1] = height;
+    mesh.vertices[3 * v + 2] = 0.2f * sinf(angle);
+    mesh.normals[3 * v + 0] = cosf(angle);
+    mesh.normals[3 * v + 1] = 0.0f;
+    mesh.normals[3 * v + 2] = sinf(angle);
+
+    // 45% 1 influence, 30% 2, 15% 3, 10% 4
+    int hash = (v * 2654435761u) >> 16;
+    int count = (hash % 100 < 45) ? 1 : (hash % 100 < 75) ? 2 : (hash % 100 < 90) ? 3 : 4;
+
+    int bone = (int)height;
+    float total = 0.0f;
+    for (int j = 0; j < count; j++) {
+      int id = bone + j - count / 2;
+      id = (id < 0) ? 0 : (id >= BONE_COUNT) ? BONE_COUNT - 1 : id;
+
+      mesh.boneIds[4 * v + j] = (unsigned char)id;
+      mesh.boneWeights[4 * v + j] = 1.0f / (1.0f + j);
+      total += mesh.boneWeights[4 * v + j];
+    }
+    for (int j = 0; j < count; j++) {
+      mesh.boneWeights[4 * v + j] /= total;
+    }
+  }
+
+  return mesh;
+}
+
+void UnloadSyntheticMesh(Mesh mesh) {
+  free(mesh.vertices);
+  free(mesh.normals);
+  free(mesh.boneIds);
+  free(mesh.boneWeights);
+}
+
+// Skinning matrices of a bent and scaled chain against straight chain.
+void SyntheticPalette(Matrix *palette) {
+  Pose bindPose = InitPose(BONE_COUNT);
+  Pose pose = InitPose(BONE_COUNT);
+
+  Transform current = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}};
+  for (int i = 0; i < BONE_COUNT; i++) {
+    bindPose[i] = (Transform){{0.0f, (float)i, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}};
+
+    Transform local = {{0.0f, (i == 0) ? 0.0f : 1.0f, 0.0f},
+                       QuaternionFromAxisAngle((Vector3){1.0f, 0.0f, 0.3f}, 0.05f * sinf(0.3f * i)),
+                       {1.0f + 0.1f * sinf(0.2f * i), 1.0f, 1.0f + 0.05f * cosf(0.4f * i)}};
+    current = (i == 0) ? local : TransformLocalToGlobal(local, current);
+    pose[i] = current;
+  }
+
+  PoseToPoseTransformMatricesInto(palette, bindPose, pose, BONE_COUNT);
+
+  UnloadPose(bindPose);
+  UnloadPose(pose);
+}
+
+// Plain per vertex skinning (same math as `skinning-lighting.vs.glsl`).
+void SkinMeshReference(Mesh mesh, Matrix *palette, Matrix *normalMatrices, float *positions, float *normals) {
+  for (int v = 0; v < mesh.vertexCount; v++) {
+    Vector3 p = {mesh.vertices[3 * v + 0], mesh.vertices[3 * v + 1], mesh.vertices[3 * v + 2]};
+    Vector3 n = {mesh.normals[3 * v + 0], mesh.normals[3 * v + 1], mesh.normals[3 * v + 2]};
+    Vector3 position = {0};
+    Vector3 normal = {0};
+
+    for (int j = 0; j < 4; j++) {
+      float weight = mesh.boneWeights[4 * v + j];
+      int boneId = mesh.boneIds[4 * v + j];
+
+      position = Vector3Add(position, Vector3Scale(Vector3Transform(p, palette[boneId]), weight));
+      normal = Vector3Add(normal, Vector3Scale(Vector3Transform(n, normalMatrices[boneId]), weight));
+    }
+    normal = Vector3Normalize(normal);
+
+    positions[3 * v + 0] = position.x;
+    positions[3 * v + 1] = position.y;
+    positions[3 * v + 2] = position.z;
+    normals[3 * v + 0] = normal.x;
+    normals[3 * v + 1] = normal.y;
+    normals[3 * v + 2] = normal.z;
+  }
+}
+
+float MaxDifference(float *a, float *b, int count) {
+  float difference = 0.0f;
+
+  for (int i = 0; i < count; i++) {
+    float d = fabsf(a[i] - b[i]);
+    difference = (d > difference) ? d : difference;
+  }
+
+  return difference;
+}
+
+int main(int argc, char **argv) {
+  int vertexCount = (argc > 1) ? atoi(argv[1]) : 200000;
+  int iterations = (argc > 2) ? atoi(argv[2]) : 50;
+  int maxThreads = (argc > 3) ? atoi(argv[3]) : GetCpuCount();
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  Mesh mesh = LoadSyntheticMesh(vertexCount);
+
+  Matrix palette[BONE_COUNT];
+  Matrix normalMatrices[BONE_COUNT];
+  SyntheticPalette(palette);
+  for (int i = 0; i < BONE_COUNT; i++) {
+    // Translation dropped (normals are directions)
+    Matrix m = MatrixTranspose(MatrixInvert(palette[i]));
+    m.m12 = m.m13 = m.m14 = 0.0f;
+    normalMatrices[i] = m;
+  }
+
+  float *referencePositions = malloc(3 * vertexCount * sizeof(float));
+  float *referenceNormals = malloc(3 * vertexCount * sizeof(float));
+  float *positions = malloc(3 * vertexCount * sizeof(float));
+  float *normals = malloc(3 * vertexCount * sizeof(float));
+
+  double start = Now();
+  CpuSkin skin = LoadCpuSkin(mesh, BONE_COUNT);
+  double loadTime = Now() - start;
+
+  printf("%d vertices, %d bones, %d iterations (load %.3f ms)\n", vertexCount, BONE_COUNT, iterations, loadTime * 1e3);
+  printf("influence groups:");
+  for (int k = 0; k <= CPU_SKIN_MAX_INFLUENCES; k++) {
+    printf(" %d: %d", k, skin.groupStart[k + 1] - skin.groupStart[k]);
+  }
+  printf("\n%-16s %12s %14s %9s %12s %12s\n", "skinning", "ms/mesh", "Mvertices/s", "speedup", "position err", "normal err");
+
+  SkinMeshReference(mesh, palette, normalMatrices, referencePositions, referenceNormals);
+  start = Now();
+  for (int i = 0; i < iterations; i++) {
+    SkinMeshReference(mesh, palette, normalMatrices, referencePositions, referenceNormals);
+  }
+  double referenceTime = (Now() - start) / iterations;
+  printf("%-16s %12.3f %14.2f %8.2fx %12s %12s\n", "plain loop", referenceTime * 1e3,
+         vertexCount / referenceTime * 1e-6, 1.0, "-", "-");
+
+  for (int threads = 1; threads <= maxThreads; threads = (threads * 2 <= maxThreads || threads == maxThreads) ? threads * 2 : maxThreads) {
+    JobSystem *jobs = (threads > 1) ? LoadJobSystem(threads) : NULL;
+
+    SkinMeshCpu(&skin, palette, positions, normals, jobs); // Warm up
+    start = Now();
+    for (int i = 0; i < iterations; i++) {
+      SkinMeshCpu(&skin, palette, positions, normals, jobs);
+    }
+    double time = (Now() - start) / iterations;
+
+    char name[32];
+    snprintf(name, sizeof(name), "CpuSkin %d thr", threads);
+    printf("%-16s %12.3f %14.2f %8.2fx %12.2e %12.2e\n", name, time * 1e3, vertexCount / time * 1e-6,
+           referenceTime / time, MaxDifference(positions, referencePositions, 3 * vertexCount),
+           MaxDifference(normals, referenceNormals, 3 * vertexCount));
+
+    if (jobs) {
+      UnloadJobSystem(jobs);
+    }
+  }
+
+  UnloadCpuSkin(&skin);
+  free(referencePositions);
+  free(referenceNormals);
+  free(positions);
+  free(normals);
+  UnloadSyntheticMesh(mesh);
+
+  return 0;
+}
@@ -0,0 +1,213 @@
+/******************************************************************\
+ Loopback test of pose snapshots
+
+ Sends poses of a crowd from a simulated server to a simulated client
+   with `PoseSnapshotEncoder` and `PoseSnapshotDecoder` (see
+   `src/pose_snapshot.h`) over a link that drops and delays packets
+   (acks go back over same link). Prints bytes per character per tick
+   against raw poses, and world position error of decoded poses and of
+   poses played back through `PoseInterpolationBuffer`.
+
+ Uses a synthetic 65 bone skeleton (binary tree, 6 levels deep) with a
+   procedural clip, sent 20 times per second. One character in four is
+   idle (holds a frame), rest play clip at different phases.
+
+ Usage:
+   ./snapshot_loopback.out [characters] [ticks] [loss %] [latency ticks]
+
+   Defaults: 100 characters, 600 ticks, 5% loss, 3 ticks latency.
+   Client plays back 2 ticks behind newest snapshot it can have
+   (latency is at least 1 tick).
+
+ This system is built as drop in for raylib (https://github.com/raysan5/raylib/)
+\******************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+
+#include "pose_snapshot.h"
+#include "tool_common.h"
+
+#define TICK_RATE 20.0f
+#define INTERPOLATION_DELAY 2 // Ticks client plays behind newest snapshot
+#define MAX_LATENCY 64
+
+typedef struct Packet {
+  unsigned char *data;
+  int size;       // 0 if no packet (dropped or none sent)
+} Packet;
+
+typedef struct Character {
+  PoseSnapshotEncoder encoder;    // Server side
+  PoseSnapshotDecoder decoder;    // Client side
+  PoseInterpolationBuffer buffer; // Client side
+  Packet packets[MAX_LATENCY];     // In flight to client, by tick sent
+  int acks[MAX_LATENCY];           // In flight to server, by tick sent (-1 if none)
+  float phase;                     // Clip time offset (seconds)
+  int idle;                        // Holds first frame
+} Character;
+
+// Local pose of character on server at `time`.
+void CharacterPoseInto(Pose out, Character *character, AnimationClip clip, float time, SkeletonHierarchy *hierarchy) {
+  float seconds = (character->idle) ? 0.0f : time + character->phase;
+
+  AnimationClipSamplePoseInto(out, clip, seconds, CLIP_TIME_LOOP, CLIP_LOCAL_POSE, hierarchy);
+}
+
+// Max and sum of bone position differences of two local poses (in world).
+void PoseWorldError(Pose a, Pose b, Pose tempA, Pose tempB, SkeletonHierarchy *hierarchy, float *max, double *sum) {
+  PoseToGlobalTransformPoseHierarchyInto(tempA, a, hierarchy);
+  PoseToGlobalTransformPoseHierarchyInto(tempB, b, hierarchy);
+
+  for (int i = 0; i < hierarchy->boneCount; i++) {
+    float d = Vector3Distance(tempA[i].translation, tempB[i].translation);
+    *max = (d > *max) ? d : *max;
+    *sum += d;
+  }
+}
+
+int main(int argc, char **argv) {
+  int characterCount = (argc > 1) ? atoi(argv[1]) : 100;
+  int ticks = (argc > 2) ? atoi(argv[2]) : 600;
+  float loss = (argc > 3) ? (float)atof(argv[3]) / 100.0f : 0.05f;
+  int latency = (argc > 4) ? atoi(argv[4]) : 3;
+
+  latency = (latency < 1) ? 1 : (latency > MAX_LATENCY) ? MAX_LATENCY : latency;
+
+  SetTraceLogLevel(LOG_WARNING);
+  srand(1);
+
+  int boneCount = 65;
+  BoneInfo *bones = NULL;
+  AnimationClip clip = {0};
+  LoadSyntheticRig(&bones, boneCount, SYNTHETIC_TREE_BINARY, &clip, 1, 60);
+
+  SkeletonHierarchy hierarchy = LoadSkeletonHierarchy(bones, boneCount);
+  PoseSnapshotConfig config = PoseSnapshotDefaultConfig();
+  Pose referencePose = CopyPose(AnimationClipGetLocalPose(clip, 0), boneCount);
+  int maxSize = PoseSnapshotMaxSize(boneCount);
+
+  Character *characters = calloc(characterCount, sizeof(Character));
+  for (int i = 0; i < characterCount; i++) {
+    Character *character = &characters[i];
+
+    character->encoder = LoadPoseSnapshotEncoder(referencePose, boneCount, config);
+    character->decoder = LoadPoseSnapshotDecoder(referencePose, boneCount, config);
+    character->buffer = LoadPoseInterpolationBuffer(boneCount, 2 * (latency + INTERPOLATION_DELAY) + 4);
+    character->phase = 0.37f * i;
+    character->idle = (i % 4 == 3);
+    for (int t = 0; t < MAX_LATENCY; t++) {
+      character->packets[t].data = malloc(maxSize);
+      character->acks[t] = -1;
+    }
+  }
+
+  Pose serverPose = InitPose(boneCount);
+  Pose clientPose = InitPose(boneCount);
+  Pose tempA = InitPose(boneCount);
+  Pose tempB = InitPose(boneCount);
+
+  long long bytes = 0;
+  long long sent = 0, delivered = 0, rejected = 0, fromReference = 0;
+  float decodedMax = 0.0f, interpolatedMax = 0.0f;
+  double decodedSum = 0.0, interpolatedSum = 0.0;
+  long long decodedBones = 0, interpolatedBones = 0;
+  double encodeTime = 0.0, decodeTime = 0.0;
+
+  for (int tick = 0; tick < ticks + latency; tick++) {
+    int slot = tick % latency;
+
+    for (int i = 0; i < characterCount; i++) {
+      Character *character = &characters[i];
+
+      // Arrivals of this tick (sent `latency` ticks ago): ack to server, packet to client
+      if (character->acks[slot] >= 0) {
+        PoseSnapshotEncoderAck(&character->encoder, character->acks[slot]);
+        character->acks[slot] = -1;
+      }
+
+      Packet *packet = &character->packets[slot];
+      if (packet->size > 0) {
+        double start = Now();
+        int sequence = DecodePoseSnapshot(&character->decoder, packet->data, packet->size, clientPose);
+        decodeTime += Now() - start;
+
+        if (sequence >= 0) {
+          float sentTime = (tick - latency) / TICK_RATE;
+          delivered++;
+          PoseInterpolationBufferPush(&character->buffer, sentTime, clientPose);
+
+          CharacterPoseInto(serverPose, character, clip, sentTime, &hierarchy);
+          PoseWorldError(serverPose, clientPose, tempA, tempB, &hierarchy, &decodedMax, &decodedSum);
+          decodedBones += boneCount;
+        } else {
+          rejected++;
+        }
+        packet->size = 0;
+
+        // Ack takes same link back
+        character->acks[slot] = (sequence >= 0 && (float)rand() / RAND_MAX >= loss) ? sequence : -1;
+      }
+
+      // Client playback, behind newest snapshot it can have
+      float renderTime = (tick - latency - INTERPOLATION_DELAY) / TICK_RATE;
+      if (renderTime >= 0.0f && tick < ticks && PoseInterpolationBufferSampleInto(clientPose, &character->buffer, renderTime)) {
+        CharacterPoseInto(serverPose, character, clip, renderTime, &hierarchy);
+        PoseWorldError(serverPose, clientPose, tempA, tempB, &hierarchy, &interpolatedMax, &interpolatedSum);
+        interpolatedBones += boneCount;
+      }
+
+      // Server sends this tick's pose
+      if (tick < ticks) {
+        CharacterPoseInto(serverPose, character, clip, tick / TICK_RATE, &hierarchy);
+
+        double start = Now();
+        int size = EncodePoseSnapshot(&character->encoder, serverPose, packet->data, maxSize);
+        encodeTime += Now() - start;
+
+        bytes += size;
+        sent++;
+        fromReference += (PoseSnapshotReadUint16(packet->data + 2) == POSE_SNAPSHOT_NO_BASELINE);
+        packet->size = ((float)rand() / RAND_MAX >= loss) ? size : 0;
+      }
+    }
+  }
+
+  int rawSize = boneCount * (int)sizeof(Transform);
+  double perCharacter = (double)bytes / sent;
+
+  printf("%d characters, %d bones, %d ticks (%.0f Hz), %.1f%% loss, %d ticks latency\n", characterCount, boneCount,
+         ticks, TICK_RATE, 100.0f * loss, latency);
+  printf("snapshots: %lld sent, %lld decoded, %lld rejected (baseline lost), %lld against reference pose\n", sent,
+         delivered, rejected, fromReference);
+  printf("bytes per character per tick: %.1f (raw pose %d, max snapshot %d, %.1fx smaller)\n", perCharacter, rawSize,
+         maxSize, rawSize / perCharacter);
+  printf("bandwidth: %.2f kB/s per character, %.1f kB/s for crowd\n", perCharacter * TICK_RATE / 1024.0,
+         perCharacter * TICK_RATE * characterCount / 1024.0);
+  printf("%-14s %12s %12s\n", "world error", "max", "mean");
+  printf("%-14s %12.2e %12.2e\n", "decoded", decodedMax, (decodedBones > 0) ? decodedSum / decodedBones : 0.0);
+  printf("%-14s %12.2e %12.2e\n", "interpolated", interpolatedMax, (interpolatedBones > 0) ? interpolatedSum / interpolatedBones : 0.0);
+  printf("encode %.2f us, decode %.2f us per snapshot\n", encodeTime / sent * 1e6, (delivered + rejected > 0) ? decodeTime / (delivered + rejected) * 1e6 : 0.0);
+
+  for (int i = 0; i < characterCount; i++) {
+    UnloadPoseSnapshotEncoder(&characters[i].encoder);
+    UnloadPoseSnapshotDecoder(&characters[i].decoder);
+    UnloadPoseInterpolationBuffer(&characters[i].buffer);
+    for (int t = 0; t < MAX_LATENCY; t++) {
+      free(characters[i].packets[t].data);
+    }
+  }
+  free(characters);
+
+  UnloadPose(serverPose);
+  UnloadPose(clientPose);
+  UnloadPose(tempA);
+  UnloadPose(tempB);
+  UnloadPose(referencePose);
+  UnloadSkeletonHierarchy(hierarchy);
+  UnloadAnimationClip(clip);
+  free(bones);
+
+  return 0;
+}
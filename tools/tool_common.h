@@ -0,0 +1,66 @@
+#ifndef __KIRAN_RAY_TOOL_COMMON__
+#define __KIRAN_RAY_TOOL_COMMON__
+
+/* Helpers shared by headless tools. `clock_gettime()` needs tools to
+   define `_POSIX_C_SOURCE` before including any header. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "animation_clip.h"
+
+// Tree shapes of synthetic rig
+#define SYNTHETIC_TREE_BINARY 0 // Parent of bone i is (i - 1) / 2 (65 bones are 6 levels deep)
+#define SYNTHETIC_TREE_CHAINS 1 // Long chains, every third bone branches off further up
+
+double Now(void);
+void LoadSyntheticRig(BoneInfo **bones, int boneCount, int tree, AnimationClip *clips, int clipCount, int frameCount);
+
+// Monotonic time in seconds.
+double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Bones (parents before children) and `clipCount` looping local space
+   clips of `frameCount` frames (one second each). Every bone swings
+   about its own axis with phase growing down bone ids. Free with
+   `free(bones)` and `UnloadAnimationClip()`. */
+void LoadSyntheticRig(BoneInfo **bones, int boneCount, int tree, AnimationClip *clips, int clipCount, int frameCount) {
+  *bones = calloc(boneCount, sizeof(BoneInfo));
+  for (int i = 0; i < boneCount; i++) {
+    snprintf((*bones)[i].name, sizeof((*bones)[i].name), "bone_%d", i);
+
+    if (tree == SYNTHETIC_TREE_BINARY) {
+      (*bones)[i].parent = (i == 0) ? -1 : (i - 1) / 2;
+    } else {
+      (*bones)[i].parent = (i == 0) ? -1 : (i - 1) - (i % 3 == 0 ? i / 4 : 0);
+    }
+  }
+
+  for (int c = 0; c < clipCount; c++) {
+    clips[c] = LoadEmptyAnimationClip(boneCount, frameCount, CLIP_LOCAL_POSE);
+    clips[c].frameRate = (float)frameCount;
+    if (clipCount > 1) {
+      snprintf(clips[c].name, sizeof(clips[c].name), "synthetic_%d", c);
+    } else {
+      snprintf(clips[c].name, sizeof(clips[c].name), "synthetic");
+    }
+
+    for (int frame = 0; frame < frameCount; frame++) {
+      Pose pose = AnimationClipGetLocalPose(clips[c], frame);
+      float phase = 2.0f * PI * frame / frameCount;
+
+      for (int i = 0; i < boneCount; i++) {
+        pose[i].translation = (Vector3){0.0f, (i == 0) ? 1.0f : 0.1f, 0.0f};
+        pose[i].rotation = QuaternionFromAxisAngle((Vector3){(float)c, 1.0f, 0.5f}, 0.3f * sinf(phase + 0.2f * i));
+        pose[i].scale = (Vector3){1.0f, 1.0f, 1.0f};
+      }
+    }
+  }
+}
+
+#endif